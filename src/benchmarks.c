@@ -0,0 +1,135 @@
+/** @file benchmarks.c
+ *  @brief Function defines for the on-target benchmarks.
+ *
+ *  This file contains all of the function definitions
+ *  declared in benchmarks.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* Includes */
+#include <stddef.h>
+#include "defines.h"
+#include "benchmarks.h"
+#include "cycles.h"
+
+static uint8_t bench_tx[BENCH_SPI_FRAMES];
+static uint8_t bench_rx[BENCH_SPI_FRAMES];
+
+static uint32_t bench_rate(const uint32_t bits, const uint32_t cycles) {
+  /* SYS_CLK is in MHz, so bits per cycle times 1e3 */
+  return (cycles == 0U)
+             ? 0U
+             : (uint32_t)(((uint64_t)bits * SYS_CLK * 1000U) / cycles);
+}
+
+void bench_spi_block(const spi_peripheral_t spi, const _Bool polarity,
+                     const _Bool phase,
+                     struct BenchSPIResult results[BENCH_SPI_PRESC_LEN]) {
+  if (results == NULL) {
+    return;
+  }
+
+  /* SPI1 and SPI4 sit on APB2, the rest on APB1 */
+  uint32_t bus_clk = APB1_CLK;
+  if (spi == SPI_PERIPH_1) {
+    bus_clk = APB2_CLK;
+  }
+#ifdef SPI4_BASE
+  if (spi == SPI_PERIPH_4) {
+    bus_clk = APB2_CLK;
+  }
+#endif
+
+  const uint32_t bits = (BENCH_SPI_FRAMES * 8U);
+
+  for (uint32_t i = 0U; i < sizeof(bench_tx); i++) {
+    bench_tx[i] = (uint8_t)i;
+  }
+  cycles_init();
+
+  for (uint32_t div = 0U; div < BENCH_SPI_PRESC_LEN; div++) {
+    struct BenchSPIResult *result = &results[div];
+    spi_configure_clk(spi, (spi_prescaler_t)div, polarity, phase);
+
+    /* SCK is the bus clock over 2^(div + 1) */
+    result->Ideal = ((bits << (div + 1U)) * (SYS_CLK / bus_clk));
+
+    uint32_t start = cycles_now();
+    spi_transfer_block(spi, bench_tx, bench_rx, BENCH_SPI_FRAMES);
+    result->Block = (cycles_now() - start);
+
+    start = cycles_now();
+    for (uint32_t frame = 0U; frame < BENCH_SPI_FRAMES; frame++) {
+      bench_rx[frame] = (uint8_t)spi_trx_data(spi, bench_tx[frame]);
+    }
+    result->Single = (cycles_now() - start);
+
+    result->BlockRate = bench_rate(bits, result->Block);
+    result->SingleRate = bench_rate(bits, result->Single);
+  }
+}
+
+static void bench_can_settle(const bxcan_peripheral_t can) {
+  struct bxCANRegs *regs = CAN(can);
+
+  /* Untimed: all mailboxes sent and looped back */
+  const uint32_t tme = (CAN_TSR_TME0_Msk | CAN_TSR_TME1_Msk | CAN_TSR_TME2_Msk);
+  while ((regs->TSR & tme) != tme) { ASM_NOP; }
+  while ((regs->RFR[0] & CAN_RF0R_FMP0_Msk) != 3U) { ASM_NOP; }
+}
+
+void bench_can_frames(const bxcan_peripheral_t can,
+                      struct BenchCANResult *result) {
+  if (result == NULL) {
+    return;
+  }
+
+  struct bxCANFrame frames[3];
+  struct bxCANMessage messages[3];
+  struct bxCANMailboxRegs buffer;
+  uint32_t cycles[4] = {0U};
+
+  for (uint8_t i = 0U; i < 3U; i++) {
+    frames[i] = (struct bxCANFrame){.ID = (0x100U + i), .DLC = 8U};
+    messages[i] = (struct bxCANMessage){.ID = (0x100U + i), .DLC = 8U};
+    for (uint8_t byte = 0U; byte < 8U; byte++) {
+      frames[i].DATA[byte] = byte;
+    }
+    messages[i].DATA[0] = 0x03020100UL;
+    messages[i].DATA[1] = 0x07060504UL;
+  }
+  cycles_init();
+
+  for (uint32_t round = 0U; round < BENCH_CAN_ROUNDS; round++) {
+    uint32_t start = cycles_now();
+    for (uint8_t i = 0U; i < 3U; i++) {
+      bxcan_tx_frame(can, &frames[i]);
+    }
+    cycles[0] += (cycles_now() - start);
+    bench_can_settle(can);
+
+    start = cycles_now();
+    for (uint8_t i = 0U; i < 3U; i++) {
+      bxcan_rx_frame_fetch(can, 0U, &buffer);
+      bxcan_rx_frame_process(buffer, &frames[i]);
+    }
+    cycles[2] += (cycles_now() - start);
+
+    start = cycles_now();
+    (void)bxcan_tx_frames(can, messages, 3U);
+    cycles[1] += (cycles_now() - start);
+    bench_can_settle(can);
+
+    start = cycles_now();
+    (void)bxcan_rx_frames(can, 0U, messages, 3U);
+    cycles[3] += (cycles_now() - start);
+  }
+
+  const uint32_t total = (BENCH_CAN_ROUNDS * 3U);
+  result->TxFrame = (cycles[0] / total);
+  result->TxFrames = (cycles[1] / total);
+  result->RxFrame = (cycles[2] / total);
+  result->RxFrames = (cycles[3] / total);
+}
@@ -0,0 +1,97 @@
+/** @file benchmarks.h
+ *  @brief On-target driver benchmarks.
+ *
+ *  The benchmarks time driver routines with the DWT
+ *  cycle counter and leave the results in RAM, read them
+ *  with the debugger or send them over a USART.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "bxcan.h"
+#include "spi.h"
+
+/** @brief Frames clocked per SPI measurement */
+#define BENCH_SPI_FRAMES 256U
+
+/** @brief Number of spi_prescaler_t settings */
+#define BENCH_SPI_PRESC_LEN 8U
+
+/**
+ *  @brief Contains the SPI throughput at one prescaler
+ *
+ *  Ideal is the length of BENCH_SPI_FRAMES back-to-back
+ *  frames on the wire, Block and Single the time taken by
+ *  spi_transfer_block() and a spi_trx_data() loop. All
+ *  values are in core cycles, the rates in kbit/s.
+ */
+struct BenchSPIResult {
+  uint32_t Ideal;
+  uint32_t Block;
+  uint32_t Single;
+  uint32_t BlockRate;
+  uint32_t SingleRate;
+};
+
+/**
+ * @brief Measures SPI throughput at every prescaler.
+ *
+ * The SPI has to be configured as a full-duplex master
+ * with 8-bit frames and started by the caller. A MISO to
+ * MOSI loopback is enough as wiring. The clock polarity
+ * and phase are set as given, the prescaler is left at
+ * DIV256 afterwards.
+ *
+ * @param spi The selected SPI
+ * @param polarity The default state of the clock
+ * @param phase Capture data on first or second pulse
+ * @param results One result per spi_prescaler_t value
+ * @return None
+ */
+void bench_spi_block(const spi_peripheral_t spi, const _Bool polarity,
+                     const _Bool phase,
+                     struct BenchSPIResult results[BENCH_SPI_PRESC_LEN]);
+
+/** @brief Rounds of three frames per CAN measurement */
+#define BENCH_CAN_ROUNDS 32U
+
+/**
+ *  @brief Contains the CAN frame handling cost
+ *
+ *  TxFrame and RxFrame time the bxCANFrame path
+ *  (bxcan_tx_frame(), bxcan_rx_frame_fetch() plus
+ *  bxcan_rx_frame_process()), TxFrames and RxFrames the
+ *  bxCANMessage batch calls. All values are in core
+ *  cycles per frame, the bus time is not included.
+ */
+struct BenchCANResult {
+  uint32_t TxFrame;
+  uint32_t TxFrames;
+  uint32_t RxFrame;
+  uint32_t RxFrames;
+};
+
+/**
+ * @brief Measures the CPU cost of sending and receiving.
+ *
+ * The CAN has to be started by the caller in loopback
+ * mode (silent loopback keeps the bus quiet) with a
+ * filter that routes every standard data frame to FIFO0,
+ * and no receive interrupts. Each round loads the three
+ * mailboxes at once and drains the three received
+ * frames, the waits for the bus are not timed.
+ *
+ * @param can The selected CAN
+ * @param result The measured costs
+ * @return None
+ */
+void bench_can_frames(const bxcan_peripheral_t can,
+                      struct BenchCANResult *result);
+
+#endif
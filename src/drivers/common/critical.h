@@ -0,0 +1,43 @@
+/** @file critical.h
+ *  @brief Helpers for short interrupt-safe sections.
+ *
+ *  The drivers share a few small queues between thread
+ *  code and interrupt handlers. These helpers mask the
+ *  interrupts for the few instructions that touch them
+ *  and restore the previous PRIMASK afterwards, so they
+ *  can also be used from inside interrupt handlers.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef CRITICAL_H
+#define CRITICAL_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/**
+ * @brief Masks all configurable interrupts.
+ *
+ * @return The PRIMASK value before masking
+ */
+__attribute__((always_inline)) static inline uint32_t critical_enter(void) {
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+}
+
+/**
+ * @brief Restores the interrupt mask of critical_enter().
+ *
+ * @param primask The value returned by critical_enter()
+ * @return None
+ */
+__attribute__((always_inline)) static inline void
+critical_exit(const uint32_t primask) {
+  __set_PRIMASK(primask);
+}
+
+#endif
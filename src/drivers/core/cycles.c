@@ -0,0 +1,19 @@
+/** @file cycles.c
+ *  @brief Function defines for the cycle counter.
+ *
+ *  This file contains all of the function definitions
+ *  declared in cycles.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* Includes */
+#include "cycles.h"
+
+void cycles_init(void) {
+  /* The DWT is off unless the trace block is enabled */
+  COREDEBUG_PTR->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT_PTR->CYCCNT = 0UL;
+  DWT_PTR->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
@@ -0,0 +1,43 @@
+/** @file cycles.h
+ *  @brief Function prototypes for the cycle counter.
+ *
+ *  This file contains the function prototypes required
+ *  to time code with the DWT cycle counter, which counts
+ *  core clocks (SYS_CLK) and wraps every ~23.8 seconds.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef CYCLES_H
+#define CYCLES_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+#ifndef UTEST
+#define DWT_PTR       DWT
+#define COREDEBUG_PTR CoreDebug
+#else
+extern DWT_Type *DWT_PTR;
+extern CoreDebug_Type *COREDEBUG_PTR;
+#endif
+
+/**
+ * @brief Enables and resets the DWT cycle counter.
+ *
+ * @return None
+ */
+void cycles_init(void);
+
+/**
+ * @brief Returns the current cycle count.
+ *
+ * Differences of two counts stay valid across a wrap.
+ *
+ * @return The DWT cycle counter
+ */
+static inline uint32_t cycles_now(void) { return DWT_PTR->CYCCNT; }
+
+#endif
@@ -9,8 +9,131 @@
  */
 
 /* -- Includes -- */
+#include <stddef.h>
+#include <string.h>
 #include "bxcan.h"
+#include "critical.h"
 #include "defines.h"
+#ifdef BXCAN_STATS
+#include "cycles.h"
+#endif
+
+/**
+ *  @brief Contains a receive ring state
+ *
+ *  Head and Tail are free running frame counters, the
+ *  ring index is their value modulo BXCAN_RX_RING_LEN.
+ *  The RX interrupts advance Head, the consumer Tail.
+ */
+struct bxCANRxRing {
+  struct bxCANMailboxRegs Ring[BXCAN_RX_RING_LEN];
+  volatile uint32_t Head;
+  volatile uint32_t Tail;
+  uint32_t Dropped;
+  uint32_t Overruns;
+  uint32_t Unrouted; /**< Routed frames with no room to go */
+};
+
+static struct bxCANRxRing bxcan_rx_rings[BXCAN_PERIPH_LEN];
+
+/**
+ *  @brief Contains a transmit queue state
+ *
+ *  Queue holds packed frames sorted by priority, index 0
+ *  being the most urgent. Mailbox mirrors the frames
+ *  loaded in the hardware so aborted ones can be queued
+ *  again.
+ */
+struct bxCANTxQueue {
+  struct bxCANMailboxRegs Queue[BXCAN_TX_QUEUE_LEN];
+  struct bxCANMailboxRegs Mailbox[3];
+  uint32_t Failed;
+  uint8_t Count;
+  uint8_t Loaded;   /**< Mailboxes holding queued frames */
+  uint8_t Aborting; /**< Mailboxes with an abort request */
+};
+
+static struct bxCANTxQueue bxcan_tx_queues[BXCAN_PERIPH_LEN];
+
+/**
+ *  @brief bxCAN transmit interrupt look up table
+ */
+static const IRQn_Type BXCAN_TX_IRQ_LUT[] = {
+#ifdef CAN1_BASE
+    CAN1_TX_IRQn,
+#endif
+#ifdef CAN2_BASE
+    CAN2_TX_IRQn,
+#endif
+};
+
+/**
+ *  @brief bxCAN receive interrupt look up table
+ */
+static const IRQn_Type BXCAN_RX_IRQ_LUT[][2] = {
+#ifdef CAN1_BASE
+    {CAN1_RX0_IRQn, CAN1_RX1_IRQn},
+#endif
+#ifdef CAN2_BASE
+    {CAN2_RX0_IRQn, CAN2_RX1_IRQn},
+#endif
+};
+
+#ifdef BXCAN_STATS
+/**
+ *  @brief Contains the statistics state of a CAN
+ */
+static struct {
+  struct bxCANStats Stats;
+  uint32_t TxStart[3]; /**< Mailbox load times */
+  uint32_t Since;      /**< Window start */
+} bxcan_stats[BXCAN_PERIPH_LEN];
+
+static inline uint32_t bxcan_frame_bits(const uint32_t ir, const uint32_t tr) {
+  /* 44 / 64 bits of overhead plus 3 of interframe space */
+  const uint32_t data = ((ir & BIT(CAN_RI0R_RTR_Pos)) ? 0U : (tr & 0xFU));
+  return (((ir & BIT(CAN_RI0R_IDE_Pos)) ? 67U : 47U) +
+          (((data > 8U) ? 8U : data) * 8U));
+}
+
+static inline void bxcan_stats_tx_start(const bxcan_peripheral_t can,
+                                        const uint8_t mailbox) {
+  bxcan_stats[can].TxStart[mailbox] = cycles_now();
+}
+
+static void bxcan_stats_tx_done(const bxcan_peripheral_t can,
+                                struct bxCANRegs *regs, const uint8_t mailbox,
+                                const uint32_t tsr) {
+  struct bxCANStats *stats = &bxcan_stats[can].Stats;
+  const uint8_t shift = (8U * mailbox);
+
+  if (tsr & (CAN_TSR_TXOK0_Msk << shift)) {
+    const uint32_t latency = (cycles_now() - bxcan_stats[can].TxStart[mailbox]);
+    stats->TxLatencyLast[mailbox] = latency;
+    stats->TxLatencyTotal += latency;
+    if (latency > stats->TxLatencyMax[mailbox]) {
+      stats->TxLatencyMax[mailbox] = latency;
+    }
+    stats->TxFrames++;
+    stats->TxBits += bxcan_frame_bits(regs->TxMailbox[mailbox].IR,
+                                      regs->TxMailbox[mailbox].TR);
+  } else if (tsr & (CAN_TSR_ALST0_Msk << shift)) {
+    stats->ArbitrationLost++;
+  } else if (tsr & (CAN_TSR_TERR0_Msk << shift)) {
+    stats->TxErrors++;
+  }
+}
+
+static inline void bxcan_stats_rx(const bxcan_peripheral_t can,
+                                  const uint32_t ir, const uint32_t tr) {
+  bxcan_stats[can].Stats.RxFrames++;
+  bxcan_stats[can].Stats.RxBits += bxcan_frame_bits(ir, tr);
+}
+#else
+#define bxcan_stats_tx_start(can, mailbox)
+#define bxcan_stats_tx_done(can, regs, mailbox, tsr)
+#define bxcan_stats_rx(can, ir, tr)
+#endif
 
 static inline _Bool validateBXCAN(const bxcan_peripheral_t can) {
   /* Make sure peripheral exists */
@@ -131,12 +254,37 @@ void bxcan_configure_bitrate(const bxcan_peripheral_t can,
              CAN_BTR_SJW_Msk); // clear first
     btr |= ((config.TimeSeg1 << CAN_BTR_TS1_Pos) |
             (config.TimeSeg2 << CAN_BTR_TS2_Pos) |
-            (config.BaudPrescaler << CAN_BTR_BRP_Pos));
+            (config.BaudPrescaler << CAN_BTR_BRP_Pos) |
+            (config.SyncJump << CAN_BTR_SJW_Pos));
 
     regs->BTR = btr;
   }
 }
 
+_Bool bxcan_bitrate_solve(const uint32_t clock, const uint32_t bitrate,
+                          const uint16_t sample_point,
+                          struct bxCANBitrateConfig *config) {
+  if ((config == NULL) || (bitrate == 0U) || (sample_point > 1000U)) {
+    return FALSE;
+  } else if ((clock == 0U) || (bitrate > (clock / 4U))) {
+    return FALSE; // Not even one clock per quantum
+  }
+
+  /* Longest bit first, finer sample point placement */
+  for (uint32_t tq = 25U; tq >= 4U; tq--) {
+    if (BXCAN_TQ_FITS(clock, bitrate, sample_point, tq)) {
+      const uint32_t ts2 = BXCAN_TS2_TQ(tq, sample_point);
+      config->TimeSeg1 = (BXCAN_TS1_TQ(tq, sample_point) - 1U);
+      config->TimeSeg2 = (ts2 - 1U);
+      config->BaudPrescaler = ((clock / (bitrate * tq)) - 1U);
+      config->SyncJump = (((ts2 < 4U) ? ts2 : 4U) - 1U);
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 void bxcan_configure_automation(const bxcan_peripheral_t can,
                                 const struct bxCANAutomationConfig config) {
   if (!validateBXCAN(can)) {
@@ -248,6 +396,383 @@ void bxcan_configure_filter(const bxcan_peripheral_t can, const uint8_t filter,
   }
 }
 
+/**
+ *  @brief Contains an ID / mask block of the filter planner
+ */
+struct bxCANFilterBlock {
+  uint32_t ID;
+  uint32_t Mask;
+  bxcan_rx_handler_t Handler;
+  _Bool IDE;
+  _Bool FIFO;
+};
+
+/**
+ *  @brief Contains the register image of a planned session
+ */
+struct bxCANFilterImage {
+  struct bxCANRegs *Regs; /**< NULL to only count banks */
+  uint32_t FM1R;
+  uint32_t FS1R;
+  uint32_t FFA1R;
+  uint32_t FA1R;
+  bxcan_rx_handler_t (*Handlers)[BXCAN_FMI_LEN];
+  uint8_t FMI[2]; /**< Next filter match index per FIFO */
+  uint8_t Bank;
+};
+
+/**
+ *  @brief Receive handlers indexed by FIFO and filter match
+ */
+static bxcan_rx_handler_t bxcan_rx_handlers[BXCAN_PERIPH_LEN][2]
+                                           [BXCAN_FMI_LEN];
+
+/**
+ *  @brief Gateway routes indexed by FIFO and filter match
+ */
+static const struct bxCANRoute *bxcan_routes[BXCAN_PERIPH_LEN][2]
+                                            [BXCAN_FMI_LEN];
+
+/* Filter block categories, in packing order */
+#define BXCAN_BLOCK_STD_MASK 0U
+#define BXCAN_BLOCK_STD_LIST 1U
+#define BXCAN_BLOCK_EXT_LIST 2U
+#define BXCAN_BLOCK_EXT_MASK 3U
+
+static inline uint32_t bxcan_id_mask(const _Bool ide) {
+  return ((ide) ? 0x1FFFFFFFUL : 0x7FFUL);
+}
+
+static inline uint8_t bxcan_block_category(const struct bxCANFilterBlock *b) {
+  const _Bool exact = (b->Mask == bxcan_id_mask(b->IDE));
+  if (b->IDE) {
+    return ((exact) ? BXCAN_BLOCK_EXT_LIST : BXCAN_BLOCK_EXT_MASK);
+  } else {
+    return ((exact) ? BXCAN_BLOCK_STD_LIST : BXCAN_BLOCK_STD_MASK);
+  }
+}
+
+static uint32_t bxcan_block_size(const uint32_t mask, const _Bool ide) {
+  /* Every don't care bit doubles the accepted IDs */
+  uint32_t open = (bxcan_id_mask(ide) & ~mask);
+  uint32_t size = 1U;
+  while (open != 0U) {
+    size <<= (open & 1U);
+    open >>= 1U;
+  }
+  return size;
+}
+
+static _Bool bxcan_filter_split(const struct bxCANFilterRule *rule,
+                                struct bxCANFilterBlock *blocks,
+                                uint8_t *count) {
+  const uint32_t limit = bxcan_id_mask(rule->IDE);
+  if ((rule->First > rule->Last) || (rule->Last > limit)) {
+    return FALSE;
+  }
+
+  /* Largest aligned power of two blocks covering the range */
+  uint32_t id = rule->First;
+  while (id <= rule->Last) {
+    uint32_t size = ((id == 0U) ? (limit + 1U) : (id & (~id + 1U)));
+    while ((size - 1U) > (rule->Last - id)) { size >>= 1U; }
+
+    if (*count >= BXCAN_FILTER_BLOCKS) {
+      return FALSE;
+    }
+    blocks[*count].ID = id;
+    blocks[*count].Mask = (limit & ~(size - 1U));
+    blocks[*count].Handler = rule->Handler;
+    blocks[*count].IDE = rule->IDE;
+    blocks[*count].FIFO = rule->FIFO;
+    (*count)++;
+
+    id += size;
+  }
+  return TRUE;
+}
+
+static _Bool bxcan_filter_merge(struct bxCANFilterBlock *blocks,
+                                uint8_t *count) {
+  uint8_t best[2] = {0xFFU, 0xFFU};
+  uint32_t best_mask = 0U;
+  int64_t best_cost = INT64_MAX;
+
+  /* Cheapest pair in extra accepted IDs, overlaps are free */
+  for (uint8_t i = 0U; i < *count; i++) {
+    for (uint8_t j = (i + 1U); j < *count; j++) {
+      const struct bxCANFilterBlock *a = &blocks[i];
+      const struct bxCANFilterBlock *b = &blocks[j];
+      if ((a->IDE != b->IDE) || (a->FIFO != b->FIFO) ||
+          (a->Handler != b->Handler)) {
+        continue; // Could never share a bank entry
+      }
+
+      const uint32_t mask = (a->Mask & b->Mask & ~(a->ID ^ b->ID));
+      const int64_t cost = ((int64_t)bxcan_block_size(mask, a->IDE) -
+                            bxcan_block_size(a->Mask, a->IDE) -
+                            bxcan_block_size(b->Mask, b->IDE));
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_mask = mask;
+        best[0] = i;
+        best[1] = j;
+      }
+    }
+  }
+
+  if (best[0] == 0xFFU) {
+    return FALSE;
+  }
+
+  blocks[best[0]].Mask = best_mask;
+  blocks[best[0]].ID &= best_mask;
+  blocks[best[1]] = blocks[*count - 1U];
+  (*count)--;
+  return TRUE;
+}
+
+static inline uint32_t bxcan_filter_word16(const struct bxCANFilterBlock *b) {
+  /* STID[10:0] | RTR | IDE | EXID[17:15], mask in the top half */
+  return ((b->ID << 5U) | (((b->Mask << 5U) | BIT(4) | BIT(3)) << 16U));
+}
+
+static inline uint32_t bxcan_filter_word32(const uint32_t id, const _Bool ide) {
+  return ((ide) ? ((id << CAN_RI0R_EXID_Pos) | BIT(CAN_RI0R_IDE_Pos))
+                : (id << CAN_RI0R_STID_Pos));
+}
+
+static inline uint8_t bxcan_filter_entries(const _Bool list,
+                                           const _Bool single) {
+  return (uint8_t)(((single) ? 1U : 2U) * ((list) ? 2U : 1U));
+}
+
+static void bxcan_filter_bank(struct bxCANFilterImage *image,
+                              const _Bool list, const _Bool single,
+                              const _Bool fifo,
+                              const struct bxCANFilterBlock *entry[4]) {
+  const uint8_t bank = image->Bank++;
+  if (image->Regs == NULL) {
+    return;
+  }
+
+  /* Every entry of a bank gets the next index of its FIFO */
+  for (uint8_t i = 0U; i < bxcan_filter_entries(list, single); i++) {
+    const uint8_t fmi = image->FMI[fifo]++;
+    if (fmi < BXCAN_FMI_LEN) {
+      image->Handlers[fifo][fmi] = entry[i]->Handler;
+    }
+  }
+
+  uint32_t fr1;
+  uint32_t fr2;
+  if ((single == FALSE) && (list == TRUE)) {
+    fr1 = ((entry[0]->ID << 5U) | (entry[1]->ID << 21U));
+    fr2 = ((entry[2]->ID << 5U) | (entry[3]->ID << 21U));
+  } else if (single == FALSE) {
+    fr1 = bxcan_filter_word16(entry[0]);
+    fr2 = bxcan_filter_word16(entry[1]);
+  } else if (list == TRUE) {
+    fr1 = bxcan_filter_word32(entry[0]->ID, TRUE);
+    fr2 = bxcan_filter_word32(entry[1]->ID, TRUE);
+  } else {
+    /* Masks also match IDE and RTR, data frames only */
+    fr1 = bxcan_filter_word32(entry[0]->ID, TRUE);
+    fr2 = (bxcan_filter_word32(entry[0]->Mask, TRUE) | BIT(CAN_RI0R_RTR_Pos));
+  }
+
+  image->FM1R |= ((uint32_t)list << bank);
+  image->FS1R |= ((uint32_t)single << bank);
+  image->FFA1R |= ((uint32_t)fifo << bank);
+  image->FA1R |= BIT(bank);
+  image->Regs->FilterBank[bank].FR1 = fr1;
+  image->Regs->FilterBank[bank].FR2 = fr2;
+}
+
+static void bxcan_filter_pack(const struct bxCANFilterBlock *blocks,
+                              const uint8_t count,
+                              struct bxCANFilterImage *image) {
+  for (uint8_t fifo = 0U; fifo < 2U; fifo++) {
+    /* Sort the block indexes of this FIFO by category */
+    uint8_t slots[4][BXCAN_FILTER_BLOCKS];
+    uint8_t length[4] = {0U};
+    for (uint8_t i = 0U; i < count; i++) {
+      if (blocks[i].FIFO == fifo) {
+        const uint8_t category = bxcan_block_category(&blocks[i]);
+        slots[category][length[category]++] = i;
+      }
+    }
+
+    /* Unused slots repeat the last entry of the bank */
+    const struct bxCANFilterBlock *entry[4];
+    const uint8_t *mask = slots[BXCAN_BLOCK_STD_MASK];
+    const uint8_t *list = slots[BXCAN_BLOCK_STD_LIST];
+    uint8_t used = 0U;
+    for (uint8_t i = 0U; i < length[BXCAN_BLOCK_STD_MASK]; i += 2U) {
+      entry[0] = &blocks[mask[i]];
+      entry[1] = entry[0];
+      if ((i + 1U) < length[BXCAN_BLOCK_STD_MASK]) {
+        entry[1] = &blocks[mask[i + 1U]];
+      } else if (used < length[BXCAN_BLOCK_STD_LIST]) {
+        entry[1] = &blocks[list[used++]]; // Spare slot takes a single ID
+      }
+      bxcan_filter_bank(image, FALSE, FALSE, fifo, entry);
+    }
+
+    for (; used < length[BXCAN_BLOCK_STD_LIST]; used += 4U) {
+      for (uint8_t i = 0U; i < 4U; i++) {
+        const uint8_t slot = (((used + i) < length[BXCAN_BLOCK_STD_LIST])
+                                  ? (used + i)
+                                  : (length[BXCAN_BLOCK_STD_LIST] - 1U));
+        entry[i] = &blocks[list[slot]];
+      }
+      bxcan_filter_bank(image, TRUE, FALSE, fifo, entry);
+    }
+
+    const uint8_t *ext = slots[BXCAN_BLOCK_EXT_LIST];
+    for (uint8_t i = 0U; i < length[BXCAN_BLOCK_EXT_LIST]; i += 2U) {
+      entry[0] = &blocks[ext[i]];
+      entry[1] = entry[0];
+      if ((i + 1U) < length[BXCAN_BLOCK_EXT_LIST]) {
+        entry[1] = &blocks[ext[i + 1U]];
+      }
+      bxcan_filter_bank(image, TRUE, TRUE, fifo, entry);
+    }
+
+    const uint8_t *wide = slots[BXCAN_BLOCK_EXT_MASK];
+    for (uint8_t i = 0U; i < length[BXCAN_BLOCK_EXT_MASK]; i++) {
+      entry[0] = &blocks[wide[i]];
+      bxcan_filter_bank(image, FALSE, TRUE, fifo, entry);
+    }
+  }
+}
+
+uint8_t bxcan_filter_plan(const bxcan_peripheral_t can,
+                          const struct bxCANFilterRule *rules,
+                          const uint8_t count, const uint8_t first,
+                          const uint8_t banks) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else if ((rules == NULL) || (count == 0U)) {
+    return 0U;
+  } else if ((banks == 0U) || ((first + banks) > BXCAN_FILTER_BANKS)) {
+    return 0U;
+  } else {
+    /* Filter options are available in CAN1 only */
+    struct bxCANRegs *regs = CAN(0U);
+
+    /* Banks from CAN2SB on belong to CAN2, a range across
+     * the split would take the banks of the other CAN */
+    const uint8_t split =
+        (uint8_t)((regs->FMR & CAN_FMR_CAN2SB_Msk) >> CAN_FMR_CAN2SB_Pos);
+    if ((can == 0U) ? ((first + banks) > split) : (first < split)) {
+      return 0U;
+    }
+
+    struct bxCANFilterBlock blocks[BXCAN_FILTER_BLOCKS];
+    uint8_t length = 0U;
+    for (uint8_t i = 0U; i < count; i++) {
+      if (!bxcan_filter_split(&rules[i], blocks, &length)) {
+        return 0U;
+      }
+    }
+
+    /* Trade accuracy for banks until everything fits */
+    struct bxCANFilterImage image = {0};
+    bxcan_filter_pack(blocks, length, &image);
+    while (image.Bank > banks) {
+      if (!bxcan_filter_merge(blocks, &length)) {
+        return 0U;
+      }
+      image.Bank = 0U;
+      bxcan_filter_pack(blocks, length, &image);
+    }
+    const uint8_t used = image.Bank;
+    const uint32_t range = ((uint32_t)(BIT(banks) - 1U) << first);
+
+    /* Indexes continue after the banks of this CAN before
+     * the range, active or not */
+    for (uint8_t bank = ((can == 0U) ? 0U : split); bank < first; bank++) {
+      image.FMI[(regs->FFA1R >> bank) & 1U] += bxcan_filter_entries(
+          ((regs->FM1R >> bank) & 1U), ((regs->FS1R >> bank) & 1U));
+    }
+
+    image.Handlers = bxcan_rx_handlers[can];
+    memset(image.Handlers, 0, sizeof(bxcan_rx_handlers[can]));
+    memset(bxcan_routes[can], 0, sizeof(bxcan_routes[can]));
+
+    regs->FMR |= CAN_FMR_FINIT_Msk;
+
+    /* Banks may only change while inactive */
+    image.FA1R = (regs->FA1R & ~range);
+    regs->FA1R = image.FA1R;
+
+    image.Regs = regs;
+    image.Bank = first;
+    image.FM1R = (regs->FM1R & ~range);
+    image.FS1R = (regs->FS1R & ~range);
+    image.FFA1R = (regs->FFA1R & ~range);
+    bxcan_filter_pack(blocks, length, &image);
+
+    regs->FM1R = image.FM1R;
+    regs->FS1R = image.FS1R;
+    regs->FFA1R = image.FFA1R;
+    regs->FA1R = image.FA1R;
+
+    regs->FMR &= ~(CAN_FMR_FINIT_Msk);
+    return used;
+  }
+}
+
+void bxcan_set_rx_handler(const bxcan_peripheral_t can, const _Bool FIFO,
+                          const uint8_t fmi, const bxcan_rx_handler_t handler) {
+  if (!validateBXCAN(can)) {
+    return;
+  } else if (!(fmi < BXCAN_FMI_LEN)) {
+    return;
+  } else {
+    bxcan_rx_handlers[can][FIFO][fmi] = handler;
+  }
+}
+
+void bxcan_set_route(const bxcan_peripheral_t can, const _Bool FIFO,
+                     const uint8_t fmi, const struct bxCANRoute *route) {
+  if (!validateBXCAN(can)) {
+    return;
+  } else if (!(fmi < BXCAN_FMI_LEN)) {
+    return;
+  } else if ((route != NULL) && !validateBXCAN(route->Target)) {
+    return;
+  } else {
+    bxcan_routes[can][FIFO][fmi] = route;
+  }
+}
+
+_Bool bxcan_rx_dispatch(const bxcan_peripheral_t can,
+                        const struct bxCANMailboxRegs buffer) {
+  if (!validateBXCAN(can)) {
+    return FALSE;
+  } else {
+    const uint32_t tr = buffer.TR;
+    const uint8_t fmi = ((tr & CAN_RDT0R_FMI_Msk) >> CAN_RDT0R_FMI_Pos);
+    if (!(fmi < BXCAN_FMI_LEN)) {
+      return FALSE;
+    }
+
+    /* The filter already did the matching */
+    const bxcan_rx_handler_t handler =
+        bxcan_rx_handlers[can][(tr >> BXCAN_RX_FIFO_Pos) & 1U][fmi];
+    if (handler == NULL) {
+      return FALSE;
+    }
+
+    struct bxCANFrame frame;
+    bxcan_rx_frame_process(buffer, &frame);
+    handler(can, &frame);
+    return TRUE;
+  }
+}
+
 static inline uint8_t get_empty_mailbox(struct bxCANRegs *regs) {
   uint32_t tsr = regs->TSR;
   if (tsr & CAN_TSR_TME0_Msk) {
@@ -261,6 +786,48 @@ static inline uint8_t get_empty_mailbox(struct bxCANRegs *regs) {
   }
 }
 
+static void bxcan_frame_pack(struct bxCANRegs *regs, struct bxCANFrame *frame,
+                             struct bxCANMailboxRegs *words) {
+  /* Correct global time transmission */
+  if ((frame->TGT) && (CAN_MCR_TTCM_Msk & regs->MCR)) {
+    frame->DLC = 8U;
+  } else {
+    frame->TGT = FALSE;
+  }
+
+  /* Pass data in temp registers */
+  REG32 lr = 0U;
+  REG32 hr = 0U;
+  for (uint8_t i = 0U; i < frame->DLC; i++) {
+    if (i < 4U) {
+      lr |= ((uint32_t)frame->DATA[i] << (i * 8));
+    } else {
+      hr |= ((uint32_t)frame->DATA[i] << ((i - 4) * 8));
+    }
+  }
+
+  words->LR = lr;
+  words->HR = hr;
+  words->TR = ((frame->DLC) | (frame->TGT << CAN_TDT0R_TGT_Pos));
+  words->IR =
+      ((frame->ID << ((frame->IDE) ? CAN_RI0R_EXID_Pos : CAN_RI0R_STID_Pos)) |
+       (frame->IDE << CAN_RI0R_IDE_Pos) | (frame->RTR << CAN_RI0R_RTR_Pos));
+}
+
+static inline void bxcan_mailbox_load(const bxcan_peripheral_t can,
+                                      struct bxCANRegs *regs,
+                                      const uint8_t mailbox,
+                                      const struct bxCANMailboxRegs *words) {
+  (void)can;
+  bxcan_stats_tx_start(can, mailbox);
+
+  /* Configure frame and transmit it */
+  regs->TxMailbox[mailbox].LR = words->LR;
+  regs->TxMailbox[mailbox].HR = words->HR;
+  regs->TxMailbox[mailbox].TR = words->TR;
+  regs->TxMailbox[mailbox].IR = (words->IR | CAN_TI0R_TXRQ_Msk);
+}
+
 void bxcan_tx_frame(const bxcan_peripheral_t can, struct bxCANFrame *frame) {
   if (!validateBXCAN(can)) {
     return;
@@ -268,37 +835,14 @@ void bxcan_tx_frame(const bxcan_peripheral_t can, struct bxCANFrame *frame) {
     return;
   } else {
     struct bxCANRegs *regs = CAN(can);
+    struct bxCANMailboxRegs words;
 
     /* Wait until the mailbox becomes empty */
     uint8_t mailbox = 0xFFU;
     while (mailbox == 0xFFU) { mailbox = get_empty_mailbox(regs); }
 
-    /* Correct global time transmission */
-    if ((frame->TGT) && (CAN_MCR_TTCM_Msk & regs->MCR)) {
-      frame->DLC = 8U;
-    } else {
-      frame->TGT = FALSE;
-    }
-
-    /* Pass data in temp registers */
-    REG32 lr = 0U;
-    REG32 hr = 0U;
-    for (uint8_t i = 0U; i < frame->DLC; i++) {
-      if (i < 4U) {
-        lr |= (frame->DATA[i] << (i * 8));
-      } else {
-        hr |= (frame->DATA[i] << ((i - 4) * 8));
-      }
-    }
-
-    /* Configure frame and transmit it */
-    regs->TxMailbox[mailbox].LR = lr;
-    regs->TxMailbox[mailbox].HR = hr;
-    regs->TxMailbox[mailbox].TR =
-        ((frame->DLC) | (frame->TGT << CAN_TDT0R_TGT_Pos));
-    regs->TxMailbox[mailbox].IR =
-        ((frame->ID << ((frame->IDE) ? CAN_RI0R_EXID_Pos : CAN_RI0R_STID_Pos)) |
-         (frame->IDE << CAN_RI0R_IDE_Pos) | CAN_TI0R_TXRQ_Msk);
+    bxcan_frame_pack(regs, frame, &words);
+    bxcan_mailbox_load(can, regs, mailbox, &words);
   }
 }
 
@@ -311,9 +855,11 @@ inline void bxcan_rx_frame_fetch(const bxcan_peripheral_t can, const _Bool FIFO,
 
     /* Register fetching */
     buffer->IR = regs->FIFOMailbox[FIFO].IR;
-    buffer->TR = regs->FIFOMailbox[FIFO].TR;
+    buffer->TR = ((regs->FIFOMailbox[FIFO].TR & ~BXCAN_RX_FIFO_Msk) |
+                  ((uint32_t)FIFO << BXCAN_RX_FIFO_Pos));
     buffer->LR = regs->FIFOMailbox[FIFO].LR;
     buffer->HR = regs->FIFOMailbox[FIFO].HR;
+    bxcan_stats_rx(can, buffer->IR, buffer->TR);
 
     /* Release FIFO */
     regs->RFR[FIFO] |= CAN_RF0R_RFOM0_Msk;
@@ -326,6 +872,7 @@ void bxcan_rx_frame_process(const struct bxCANMailboxRegs buffer,
   frame->ID =
       (buffer.IR >> ((frame->IDE) ? CAN_RI0R_EXID_Pos : CAN_RI0R_STID_Pos));
   frame->DLC = (buffer.TR & 0xFU);
+  frame->FMI = ((buffer.TR & CAN_RDT0R_FMI_Msk) >> CAN_RDT0R_FMI_Pos);
   frame->TIME = (buffer.TR >> CAN_RDT0R_TIME_Pos);
 
   /* Data gathering */
@@ -339,6 +886,96 @@ void bxcan_rx_frame_process(const struct bxCANMailboxRegs buffer,
   frame->DATA[7] = (buffer.HR >> 24);
 }
 
+uint32_t bxcan_tx_frames(const bxcan_peripheral_t can,
+                         const struct bxCANMessage *messages,
+                         const uint32_t count) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else if (messages == NULL) {
+    return 0U;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+    uint32_t sent = 0U;
+
+    while (sent < count) {
+      const uint32_t tsr = regs->TSR;
+      for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+        if (!(tsr & (CAN_TSR_TME0_Msk << mailbox))) {
+          continue;
+        }
+
+        const struct bxCANMessage *message = &messages[sent];
+        if (message->DLC > 8U) {
+          return sent;
+        }
+
+        bxcan_stats_tx_start(can, mailbox);
+        regs->TxMailbox[mailbox].LR = message->DATA[0];
+        regs->TxMailbox[mailbox].HR = message->DATA[1];
+        regs->TxMailbox[mailbox].TR =
+            (message->DLC | ((uint32_t)message->TGT << CAN_TDT0R_TGT_Pos));
+        regs->TxMailbox[mailbox].IR =
+            ((message->ID << ((message->IDE) ? CAN_RI0R_EXID_Pos
+                                             : CAN_RI0R_STID_Pos)) |
+             ((uint32_t)message->IDE << CAN_RI0R_IDE_Pos) |
+             ((uint32_t)message->RTR << CAN_RI0R_RTR_Pos) |
+             CAN_TI0R_TXRQ_Msk);
+
+        if (++sent == count) {
+          break;
+        }
+      }
+    }
+
+    return sent;
+  }
+}
+
+void bxcan_rx_message_process(const struct bxCANMailboxRegs *buffer,
+                              struct bxCANMessage *message) {
+  const uint32_t ir = buffer->IR;
+  const uint32_t tr = buffer->TR;
+
+  message->IDE = ((ir >> CAN_RI0R_IDE_Pos) & 1U);
+  message->RTR = ((ir >> CAN_RI0R_RTR_Pos) & 1U);
+  message->ID =
+      (ir >> ((message->IDE) ? CAN_RI0R_EXID_Pos : CAN_RI0R_STID_Pos));
+  message->DLC = (tr & 0xFU);
+  message->TGT = FALSE;
+  message->FMI = ((tr & CAN_RDT0R_FMI_Msk) >> CAN_RDT0R_FMI_Pos);
+  message->TIME = (uint16_t)(tr >> CAN_RDT0R_TIME_Pos);
+  message->DATA[0] = buffer->LR;
+  message->DATA[1] = buffer->HR;
+}
+
+uint32_t bxcan_rx_frames(const bxcan_peripheral_t can, const _Bool FIFO,
+                         struct bxCANMessage *messages, const uint32_t count) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else if (messages == NULL) {
+    return 0U;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+    uint32_t received = 0U;
+    uint32_t rfr;
+
+    while ((received < count) &&
+           ((rfr = regs->RFR[FIFO]) & CAN_RF0R_FMP0_Msk)) {
+      if (rfr & CAN_RF0R_RFOM0_Msk) {
+        continue; // Previous release still in progress
+      }
+
+      bxcan_stats_rx(can, regs->FIFOMailbox[FIFO].IR,
+                     regs->FIFOMailbox[FIFO].TR);
+      bxcan_rx_message_process(&regs->FIFOMailbox[FIFO],
+                               &messages[received++]);
+      regs->RFR[FIFO] = CAN_RF0R_RFOM0_Msk;
+    }
+
+    return received;
+  }
+}
+
 const struct bxCANErrorInfo bxcan_get_error_info(const bxcan_peripheral_t can) {
   struct bxCANErrorInfo info = {0};
 
@@ -359,3 +996,422 @@ const struct bxCANErrorInfo bxcan_get_error_info(const bxcan_peripheral_t can) {
     return info;
   }
 }
+
+void bxcan_rx_ring_start(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+    struct bxCANRxRing *ring = &bxcan_rx_rings[can];
+
+    /* Nothing runs the handlers yet, reset freely */
+    regs->IER &= ~(CAN_IER_FMPIE0_Msk | CAN_IER_FMPIE1_Msk);
+    ring->Head = 0U;
+    ring->Tail = 0U;
+    ring->Dropped = 0U;
+    ring->Overruns = 0U;
+    ring->Unrouted = 0U;
+
+    regs->IER |= (CAN_IER_FMPIE0_Msk | CAN_IER_FOVIE0_Msk |
+                  CAN_IER_FMPIE1_Msk | CAN_IER_FOVIE1_Msk);
+    NVIC_EnableIRQ(BXCAN_RX_IRQ_LUT[can][0]);
+    NVIC_EnableIRQ(BXCAN_RX_IRQ_LUT[can][1]);
+  }
+}
+
+void bxcan_rx_ring_stop(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+
+    regs->IER &= ~(CAN_IER_FMPIE0_Msk | CAN_IER_FOVIE0_Msk |
+                   CAN_IER_FMPIE1_Msk | CAN_IER_FOVIE1_Msk);
+    NVIC_DisableIRQ(BXCAN_RX_IRQ_LUT[can][0]);
+    NVIC_DisableIRQ(BXCAN_RX_IRQ_LUT[can][1]);
+  }
+}
+
+_Bool bxcan_rx_ring_pop(const bxcan_peripheral_t can,
+                        struct bxCANMailboxRegs *buffer) {
+  if (!validateBXCAN(can)) {
+    return FALSE;
+  } else if (buffer == NULL) {
+    return FALSE;
+  } else {
+    struct bxCANRxRing *ring = &bxcan_rx_rings[can];
+    const uint32_t tail = ring->Tail;
+
+    if (ring->Head == tail) {
+      return FALSE;
+    }
+
+    const struct bxCANMailboxRegs *entry =
+        &ring->Ring[tail & (BXCAN_RX_RING_LEN - 1U)];
+    buffer->IR = entry->IR;
+    buffer->TR = entry->TR;
+    buffer->LR = entry->LR;
+    buffer->HR = entry->HR;
+
+    /* Hand the slot back only after the copy */
+    ring->Tail = (tail + 1U);
+    return TRUE;
+  }
+}
+
+uint32_t bxcan_rx_ring_pending(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else {
+    return (bxcan_rx_rings[can].Head - bxcan_rx_rings[can].Tail);
+  }
+}
+
+uint32_t bxcan_rx_ring_dropped(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else {
+    return bxcan_rx_rings[can].Dropped;
+  }
+}
+
+uint32_t bxcan_rx_fifo_overruns(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else {
+    return bxcan_rx_rings[can].Overruns;
+  }
+}
+
+uint32_t bxcan_route_dropped(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else {
+    return bxcan_rx_rings[can].Unrouted;
+  }
+}
+
+/* The identifier word orders frames like the bus arbitration
+ * does: base ID, then RTR / SRR, IDE, extended ID and RTR */
+static inline uint32_t bxcan_tx_key(const struct bxCANMailboxRegs *words) {
+  return (words->IR & ~CAN_TI0R_TXRQ_Msk);
+}
+
+static _Bool bxcan_tx_insert(struct bxCANTxQueue *queue,
+                             const struct bxCANMailboxRegs *words,
+                             const _Bool front) {
+  if (queue->Count >= BXCAN_TX_QUEUE_LEN) {
+    return FALSE;
+  }
+
+  /* Equal keys keep their order, aborted frames go first */
+  const uint32_t key = bxcan_tx_key(words);
+  uint8_t pos = queue->Count;
+  while (pos > 0U) {
+    const uint32_t other = bxcan_tx_key(&queue->Queue[pos - 1U]);
+    if ((other < key) || ((other == key) && (front == FALSE))) {
+      break;
+    }
+    queue->Queue[pos] = queue->Queue[pos - 1U];
+    pos--;
+  }
+
+  queue->Queue[pos] = *words;
+  queue->Count++;
+  return TRUE;
+}
+
+/* Frames being aborted come back into the queue, so their
+ * places have to stay free */
+static inline _Bool bxcan_tx_room(const struct bxCANTxQueue *queue) {
+  uint8_t reserved = 0U;
+  for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+    reserved += ((queue->Aborting >> mailbox) & 1U);
+  }
+  return ((queue->Count + reserved) < BXCAN_TX_QUEUE_LEN);
+}
+
+static void bxcan_tx_refill(const bxcan_peripheral_t can,
+                            struct bxCANRegs *regs, struct bxCANTxQueue *queue,
+                            const uint32_t tsr) {
+  /* Fill the empty mailboxes, most urgent first */
+  for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+    if (queue->Count == 0U) {
+      return;
+    } else if (tsr & (CAN_TSR_TME0_Msk << mailbox)) {
+      queue->Mailbox[mailbox] = queue->Queue[0];
+      bxcan_mailbox_load(can, regs, mailbox, &queue->Queue[0]);
+      queue->Loaded |= (uint8_t)BIT(mailbox);
+      queue->Count--;
+      for (uint8_t i = 0U; i < queue->Count; i++) {
+        queue->Queue[i] = queue->Queue[i + 1U];
+      }
+    }
+  }
+
+  /* Evict mailboxes outranked by queued frames, the abort
+   * completion puts them back into the queue */
+  for (uint8_t i = 0U; i < queue->Count; i++) {
+    if (!bxcan_tx_room(queue)) {
+      return; // No place to put the evicted frame
+    }
+
+    uint8_t worst = 0xFFU;
+    for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+      if ((queue->Loaded & BIT(mailbox)) &&
+          !(queue->Aborting & BIT(mailbox)) &&
+          ((worst == 0xFFU) || (bxcan_tx_key(&queue->Mailbox[mailbox]) >
+                                bxcan_tx_key(&queue->Mailbox[worst])))) {
+        worst = mailbox;
+      }
+    }
+
+    if ((worst == 0xFFU) || (bxcan_tx_key(&queue->Queue[i]) >=
+                             bxcan_tx_key(&queue->Mailbox[worst]))) {
+      return;
+    }
+    queue->Aborting |= (uint8_t)BIT(worst);
+    regs->TSR = (CAN_TSR_ABRQ0_Msk << (8U * worst));
+  }
+}
+
+void bxcan_tx_queue_start(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+    struct bxCANTxQueue *queue = &bxcan_tx_queues[can];
+
+    const uint32_t primask = critical_enter();
+    queue->Count = 0U;
+    queue->Loaded = 0U;
+    queue->Aborting = 0U;
+    queue->Failed = 0U;
+    critical_exit(primask);
+
+    regs->IER |= CAN_IER_TMEIE_Msk;
+    NVIC_EnableIRQ(BXCAN_TX_IRQ_LUT[can]);
+  }
+}
+
+_Bool bxcan_tx_queue_push(const bxcan_peripheral_t can,
+                          struct bxCANFrame *frame) {
+  if (!validateBXCAN(can)) {
+    return FALSE;
+  } else if (frame == NULL) {
+    return FALSE;
+  } else if (frame->DLC > 8U) {
+    return FALSE;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+    struct bxCANTxQueue *queue = &bxcan_tx_queues[can];
+    struct bxCANMailboxRegs words;
+    bxcan_frame_pack(regs, frame, &words);
+
+    const uint32_t primask = critical_enter();
+
+    _Bool queued = FALSE;
+    if (bxcan_tx_room(queue)) {
+      queued = bxcan_tx_insert(queue, &words, FALSE);
+      bxcan_tx_refill(can, regs, queue, regs->TSR);
+    }
+    critical_exit(primask);
+
+    return queued;
+  }
+}
+
+uint32_t bxcan_tx_queue_pending(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else {
+    const struct bxCANTxQueue *queue = &bxcan_tx_queues[can];
+    uint32_t pending = queue->Count;
+    for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+      pending += ((queue->Loaded >> mailbox) & 1U);
+    }
+    return pending;
+  }
+}
+
+uint32_t bxcan_tx_queue_failed(const bxcan_peripheral_t can) {
+  if (!validateBXCAN(can)) {
+    return 0U;
+  } else {
+    return bxcan_tx_queues[can].Failed;
+  }
+}
+
+#ifdef BXCAN_STATS
+void bxcan_stats_snapshot(const bxcan_peripheral_t can,
+                          struct bxCANStats *stats, const _Bool reset) {
+  if (!validateBXCAN(can)) {
+    return;
+  } else if (stats == NULL) {
+    return;
+  } else {
+    struct bxCANRegs *regs = CAN(can);
+
+    const uint32_t primask = critical_enter();
+    const uint32_t now = cycles_now();
+    *stats = bxcan_stats[can].Stats;
+    stats->Window = (now - bxcan_stats[can].Since);
+    if (reset == TRUE) {
+      memset(&bxcan_stats[can].Stats, 0, sizeof(struct bxCANStats));
+      bxcan_stats[can].Since = now;
+    }
+    critical_exit(primask);
+
+    /* A bit is BRP + 1 times 3 + TS1 + TS2 APB1 clocks */
+    const uint32_t btr = regs->BTR;
+    const uint64_t clocks =
+        ((uint64_t)(((btr & CAN_BTR_BRP_Msk) >> CAN_BTR_BRP_Pos) + 1U) *
+         (3U + ((btr & CAN_BTR_TS1_Msk) >> CAN_BTR_TS1_Pos) +
+          ((btr & CAN_BTR_TS2_Msk) >> CAN_BTR_TS2_Pos)));
+
+    /* Bus time used over the window, both in core cycles */
+    const uint64_t busy =
+        ((((uint64_t)stats->TxBits + stats->RxBits) * clocks * SYS_CLK) /
+         APB1_CLK);
+    stats->Load = 0U;
+    if (stats->Window != 0U) {
+      const uint64_t load = ((busy * 1000U) / stats->Window);
+      stats->Load = (uint16_t)((load > 1000U) ? 1000U : load);
+    }
+
+    stats->Errors = bxcan_get_error_info(can);
+  }
+}
+#endif
+
+static void bxcan_tx_complete(const bxcan_peripheral_t can) {
+  struct bxCANRegs *regs = CAN(can);
+  struct bxCANTxQueue *queue = &bxcan_tx_queues[can];
+  const uint32_t tsr = regs->TSR;
+
+  for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+    const uint8_t shift = (8U * mailbox);
+    if (!(tsr & (CAN_TSR_RQCP0_Msk << shift))) {
+      continue;
+    }
+
+    /* Clearing RQCP also clears TXOK, ALST and TERR */
+    bxcan_stats_tx_done(can, regs, mailbox, tsr);
+    regs->TSR = (CAN_TSR_RQCP0_Msk << shift);
+    if (queue->Loaded & BIT(mailbox)) {
+      if (tsr & (CAN_TSR_TXOK0_Msk << shift)) {
+        /* Sent, also when the abort came too late */
+      } else if ((queue->Aborting & BIT(mailbox)) &&
+                 bxcan_tx_insert(queue, &queue->Mailbox[mailbox], TRUE)) {
+        /* Back in the queue */
+      } else {
+        queue->Failed++;
+      }
+    }
+    queue->Loaded &= (uint8_t)~BIT(mailbox);
+    queue->Aborting &= (uint8_t)~BIT(mailbox);
+  }
+
+  /* Mailboxes freed since the read interrupt again */
+  bxcan_tx_refill(can, regs, queue, tsr);
+}
+
+static _Bool bxcan_route_forward(const struct bxCANRoute *route,
+                                 const struct bxCANMailboxRegs *rx,
+                                 const uint32_t tr) {
+  struct bxCANRegs *regs = CAN(route->Target);
+  struct bxCANTxQueue *queue = &bxcan_tx_queues[route->Target];
+  struct bxCANMailboxRegs words;
+
+  uint32_t ir = rx->IR;
+  if (route->Rewrite) {
+    const uint8_t shift = (route->IDE) ? CAN_RI0R_EXID_Pos : CAN_RI0R_STID_Pos;
+    ir = ((ir & CAN_RI0R_RTR_Msk) | (route->ID << shift) |
+          ((uint32_t)route->IDE << CAN_RI0R_IDE_Pos));
+  }
+
+  /* The FMI bits of RDTxR would land on TGT */
+  words.IR = (ir & ~CAN_TI0R_TXRQ_Msk);
+  words.TR = (tr & CAN_TDT0R_DLC_Msk);
+  words.LR = rx->LR;
+  words.HR = rx->HR;
+
+  /* The TX interrupt of the target may preempt otherwise */
+  const uint32_t primask = critical_enter();
+
+  _Bool sent = TRUE;
+  const uint8_t mailbox = get_empty_mailbox(regs);
+  if ((queue->Count == 0U) && (mailbox != 0xFFU)) {
+    bxcan_mailbox_load(route->Target, regs, mailbox, &words);
+  } else if (bxcan_tx_room(queue) && bxcan_tx_insert(queue, &words, FALSE)) {
+    bxcan_tx_refill(route->Target, regs, queue, regs->TSR);
+  } else {
+    sent = FALSE;
+  }
+  critical_exit(primask);
+
+  return sent;
+}
+
+static void bxcan_rx_drain(const bxcan_peripheral_t can, const uint8_t fifo) {
+  struct bxCANRegs *regs = CAN(can);
+  struct bxCANRxRing *ring = &bxcan_rx_rings[can];
+  uint32_t rfr;
+
+  /* Empty the FIFO in one go, every entry costs another
+   * interrupt otherwise */
+  while ((rfr = regs->RFR[fifo]) & CAN_RF0R_FMP0_Msk) {
+    if (rfr & CAN_RF0R_RFOM0_Msk) {
+      continue; // Previous release still in progress
+    }
+
+    /* Dropped frames were on the bus all the same */
+    const uint32_t tr = regs->FIFOMailbox[fifo].TR;
+    bxcan_stats_rx(can, regs->FIFOMailbox[fifo].IR, tr);
+
+    /* Routed frames go out before touching the ring */
+    const uint8_t fmi = ((tr & CAN_RDT0R_FMI_Msk) >> CAN_RDT0R_FMI_Pos);
+    const struct bxCANRoute *route =
+        (fmi < BXCAN_FMI_LEN) ? bxcan_routes[can][fifo][fmi] : NULL;
+    if ((route != NULL) &&
+        !bxcan_route_forward(route, &regs->FIFOMailbox[fifo], tr)) {
+      ring->Unrouted++;
+    }
+
+    const uint32_t head = ring->Head;
+    if ((route != NULL) && !route->Local) {
+      /* Forwarded only */
+    } else if ((head - ring->Tail) < BXCAN_RX_RING_LEN) {
+      struct bxCANMailboxRegs *entry =
+          &ring->Ring[head & (BXCAN_RX_RING_LEN - 1U)];
+      entry->IR = regs->FIFOMailbox[fifo].IR;
+      entry->TR =
+          ((tr & ~BXCAN_RX_FIFO_Msk) | ((uint32_t)fifo << BXCAN_RX_FIFO_Pos));
+      entry->LR = regs->FIFOMailbox[fifo].LR;
+      entry->HR = regs->FIFOMailbox[fifo].HR;
+      ring->Head = (head + 1U);
+    } else {
+      ring->Dropped++;
+    }
+
+    /* FULL and FOVR are write 1 to clear, write RFOM only */
+    regs->RFR[fifo] = CAN_RF0R_RFOM0_Msk;
+  }
+
+  if (rfr & CAN_RF0R_FOVR0_Msk) {
+    regs->RFR[fifo] = CAN_RF0R_FOVR0_Msk;
+    ring->Overruns++;
+  }
+}
+
+/* bxCAN interrupt routine overrides */
+#ifdef CAN1_BASE
+void CAN1_TX_IRQHandler(void) { bxcan_tx_complete(BXCAN_PERIPH_1); }
+void CAN1_RX0_IRQHandler(void) { bxcan_rx_drain(BXCAN_PERIPH_1, 0U); }
+void CAN1_RX1_IRQHandler(void) { bxcan_rx_drain(BXCAN_PERIPH_1, 1U); }
+#endif
+#ifdef CAN2_BASE
+void CAN2_TX_IRQHandler(void) { bxcan_tx_complete(BXCAN_PERIPH_2); }
+void CAN2_RX0_IRQHandler(void) { bxcan_rx_drain(BXCAN_PERIPH_2, 0U); }
+void CAN2_RX1_IRQHandler(void) { bxcan_rx_drain(BXCAN_PERIPH_2, 1U); }
+#endif
@@ -72,7 +72,33 @@ struct __attribute__((packed)) bxCANRegs {
 _Static_assert((sizeof(struct bxCANRegs)) == (sizeof(uint32_t) * 200U),
                "bxCAN register struct size mismatch. Is it aligned?");
 
+#ifndef UTEST
 #define CAN(NUM) (struct bxCANRegs *)(CAN1_BASE + (0x400UL * (uint8_t)NUM))
+#else
+extern struct bxCANRegs *CAN(const uint8_t num);
+#endif
+
+/** @brief Receive ring size in frames, must be a power of two */
+#define BXCAN_RX_RING_LEN 32U
+
+_Static_assert(((BXCAN_RX_RING_LEN & (BXCAN_RX_RING_LEN - 1U)) == 0U),
+               "bxCAN receive ring length must be a power of two.");
+
+/** @brief Number of filter banks shared by CAN1 and CAN2 */
+#define BXCAN_FILTER_BANKS 28U
+
+/** @brief Maximum ID / mask blocks the filter planner handles */
+#define BXCAN_FILTER_BLOCKS 64U
+
+/** @brief Filter match indexes per FIFO, 4 for each bank */
+#define BXCAN_FMI_LEN (BXCAN_FILTER_BANKS * 4U)
+
+/** @brief FIFO of a fetched frame, kept in a reserved RDTxR bit */
+#define BXCAN_RX_FIFO_Pos (4U)
+#define BXCAN_RX_FIFO_Msk (0x1UL << BXCAN_RX_FIFO_Pos)
+
+/** @brief Transmit queue size in frames */
+#define BXCAN_TX_QUEUE_LEN 16U
 
 struct __attribute__((packed)) bxCANISR {
   _Bool TME  : 1; /**< Transmit mailbox empty */
@@ -101,11 +127,74 @@ struct __attribute__((packed)) bxCANBitrateConfig {
   uint8_t TimeSeg1       : 4;  /**< tBS1 = tq x (TimeSeg1 + 1) */
   uint8_t TimeSeg2       : 3;  /**< tBS2 = tq x (TimeSeg2 + 1) */
   uint16_t BaudPrescaler : 10; /**< tq = (BaudPrescaler + 1) x tPCLK */
+  uint8_t SyncJump       : 2;  /**< tRJW = tq x (SyncJump + 1) */
 };
 
 _Static_assert((sizeof(struct bxCANBitrateConfig)) == (sizeof(uint8_t) * 3U),
                "bxCAN Bitrate config struct size mismatch. Is it aligned?");
 
+/* Bit timing solver, clock and bitrate in Hz, sample point in
+ * permille. A bit is 1 + tBS1 + tBS2 quanta, tBS1 is rounded
+ * to the sample point */
+#define BXCAN_TS1_TQ(n, sp) (((((n) * (sp)) + 500UL) / 1000UL) - 1UL)
+#define BXCAN_TS2_TQ(n, sp) ((n) - 1UL - BXCAN_TS1_TQ(n, sp))
+#define BXCAN_TQ_FITS(clk, rate, sp, n)                                        \
+  (((((clk) % ((rate) * (n))) == 0UL) &&                                       \
+    (((clk) / ((rate) * (n))) >= 1UL) &&                                       \
+    (((clk) / ((rate) * (n))) <= 1024UL) && (BXCAN_TS1_TQ(n, sp) >= 1UL) &&    \
+    (BXCAN_TS1_TQ(n, sp) <= 16UL) && (BXCAN_TS2_TQ(n, sp) >= 1UL) &&           \
+    (BXCAN_TS2_TQ(n, sp) <= 8UL)))
+#define BXCAN_TQ_TRY(clk, rate, sp, n, next)                                   \
+  (BXCAN_TQ_FITS(clk, rate, sp, n) ? (n) : (next))
+
+/** @brief Most quanta per bit that fit, 0 if unreachable */
+#define BXCAN_TQ(clk, rate, sp)                                                \
+  BXCAN_TQ_TRY(clk, rate, sp, 25UL, BXCAN_TQ_TRY(clk, rate, sp, 24UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 23UL, BXCAN_TQ_TRY(clk, rate, sp, 22UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 21UL, BXCAN_TQ_TRY(clk, rate, sp, 20UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 19UL, BXCAN_TQ_TRY(clk, rate, sp, 18UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 17UL, BXCAN_TQ_TRY(clk, rate, sp, 16UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 15UL, BXCAN_TQ_TRY(clk, rate, sp, 14UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 13UL, BXCAN_TQ_TRY(clk, rate, sp, 12UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 11UL, BXCAN_TQ_TRY(clk, rate, sp, 10UL,          \
+  BXCAN_TQ_TRY(clk, rate, sp, 9UL, BXCAN_TQ_TRY(clk, rate, sp, 8UL,            \
+  BXCAN_TQ_TRY(clk, rate, sp, 7UL, BXCAN_TQ_TRY(clk, rate, sp, 6UL,            \
+  BXCAN_TQ_TRY(clk, rate, sp, 5UL, BXCAN_TQ_TRY(clk, rate, sp, 4UL,            \
+  0UL))))))))))))))))))))))
+
+/* Adds nothing, only breaks the build for unreachable rates */
+#define BXCAN_BITRATE_CHECK(clk, rate, sp)                                     \
+  (0U * sizeof(struct {                                                        \
+     _Static_assert(BXCAN_TQ(clk, rate, sp) != 0UL,                            \
+                    "CAN bitrate unreachable from the peripheral clock.");     \
+     int Valid;                                                                \
+   }))
+
+/**
+ *  @brief Solves the bit timing at compile time.
+ *
+ *  Usage: bxcan_configure_bitrate(can, BXCAN_BITRATE(500000, 875));
+ *
+ *  Picks the most time quanta per bit the APB1 clock of
+ *  defines.h allows for the bitrate (in bit/s), places
+ *  the sample point (in permille) and sets the maximum
+ *  resynchronization jump width. The arguments have to
+ *  be constants, unreachable rates fail the build.
+ *  bxcan_bitrate_solve() is the run time counterpart.
+ */
+#define BXCAN_BITRATE(rate, sp)                                                \
+  BXCAN_BITRATE_CLK((APB1_CLK * 1000000UL), (rate), (sp))
+#define BXCAN_BITRATE_CLK(clk, rate, sp)                                       \
+  ((struct bxCANBitrateConfig){                                                \
+      .TimeSeg1 = (BXCAN_TS1_TQ(BXCAN_TQ(clk, rate, sp), sp) - 1UL +           \
+                   BXCAN_BITRATE_CHECK(clk, rate, sp)),                        \
+      .TimeSeg2 = (BXCAN_TS2_TQ(BXCAN_TQ(clk, rate, sp), sp) - 1UL),          \
+      .BaudPrescaler = (((clk) / ((rate) * BXCAN_TQ(clk, rate, sp))) - 1UL),   \
+      .SyncJump = (((BXCAN_TS2_TQ(BXCAN_TQ(clk, rate, sp), sp) < 4UL)          \
+                        ? BXCAN_TS2_TQ(BXCAN_TQ(clk, rate, sp), sp)            \
+                        : 4UL) -                                               \
+                   1UL)})
+
 /**
  *  @brief Contains bxCAN filter configuration
  */
@@ -129,6 +218,12 @@ struct __attribute__((packed)) bxCANAutomationConfig {
 
 /**
  *  @brief Contains bxCAN frame structure
+ *
+ *  Layout change: FMI sits between TGT and DATA, which
+ *  grew the packed struct from 18 to 19 bytes and moved
+ *  DATA from offset 10 to 11. Code that copies frames as
+ *  raw bytes or by offset (e.g. over a link or into a
+ *  log) has to follow, the field names did not change.
  */
 struct __attribute__((packed)) bxCANFrame {
   /* --- Header --- */
@@ -139,15 +234,41 @@ struct __attribute__((packed)) bxCANFrame {
   /* --- Time --- */
   volatile uint16_t TIME;
   volatile _Bool TGT;
+  /* --- Filter --- */
+  volatile uint8_t FMI; /**< Filter match index */
   /* --- Data --- */
   volatile uint8_t DATA[8];
   // CRC handled by HW
   // ACK handled by HW
 };
 
-_Static_assert((sizeof(struct bxCANFrame)) == (sizeof(uint8_t) * 18U),
+_Static_assert((sizeof(struct bxCANFrame)) == (sizeof(uint8_t) * 19U),
                "bxCAN Frame struct size mismatch. Is it aligned?");
 
+/**
+ *  @brief Contains an aligned bxCAN frame
+ *
+ *  Plain, naturally aligned counterpart of bxCANFrame.
+ *  The payload is kept as the two little endian words of
+ *  the mailbox data registers (byte 0 in the low byte of
+ *  DATA[0]), so moving a frame is a handful of word
+ *  copies.
+ */
+struct bxCANMessage {
+  uint32_t ID;
+  uint8_t DLC;
+  _Bool IDE;
+  _Bool RTR;
+  _Bool TGT;
+  uint16_t TIME;
+  uint8_t FMI;
+  uint8_t _reserved;
+  uint32_t DATA[2]; /**< As in the LR / HR mailbox registers */
+};
+
+_Static_assert((sizeof(struct bxCANMessage)) == (sizeof(uint32_t) * 5U),
+               "bxCAN Message struct size mismatch. Is it aligned?");
+
 /**
  *  @brief Contains bxCAN error info
  */
@@ -163,6 +284,31 @@ struct __attribute__((packed)) bxCANErrorInfo {
 _Static_assert((sizeof(struct bxCANErrorInfo)) == (sizeof(uint8_t) * 6U),
                "bxCAN Error info struct size mismatch. Is it aligned?");
 
+#ifdef BXCAN_STATS
+/**
+ *  @brief Contains bxCAN bus statistics
+ *
+ *  Counts cover the window since the last reset. Bits are
+ *  estimated from the frame format without stuff bits,
+ *  interframe space included. Latencies are in core
+ *  cycles from loading a mailbox to its completion.
+ */
+struct bxCANStats {
+  uint32_t TxFrames;
+  uint32_t RxFrames;
+  uint32_t TxBits;
+  uint32_t RxBits;
+  uint32_t TxLatencyLast[3]; /**< Per mailbox */
+  uint32_t TxLatencyMax[3];  /**< Per mailbox */
+  uint32_t TxLatencyTotal;   /**< Divide by TxFrames for the mean */
+  uint32_t ArbitrationLost;  /**< Requests ended by a lost arbitration */
+  uint32_t TxErrors;         /**< Requests ended by an error */
+  uint32_t Window;           /**< Cycles since the last reset */
+  uint16_t Load;             /**< Bus load in permille */
+  struct bxCANErrorInfo Errors;
+};
+#endif
+
 /* -- Enums -- */
 /**
  *  @brief Available bxCAN operation modes
@@ -204,6 +350,49 @@ typedef enum bxcan_fifo_priority {
   BXCAN_FIFO_PRIORITY_RQ,
 } bxcan_fifo_priority_t;
 
+/* -- Types -- */
+/**
+ *  @brief Receive dispatch handler
+ *
+ *  Called by bxcan_rx_dispatch() with the decoded frame.
+ */
+typedef void (*bxcan_rx_handler_t)(const bxcan_peripheral_t can,
+                                   const struct bxCANFrame *frame);
+
+/**
+ *  @brief Contains an ID subscription for the filter planner
+ */
+struct __attribute__((packed)) bxCANFilterRule {
+  uint32_t First;             /**< Lowest accepted ID */
+  uint32_t Last;              /**< Highest accepted ID, First for one ID */
+  bxcan_rx_handler_t Handler; /**< Dispatch target (may be NULL) */
+  _Bool IDE  : 1;             /**< Extended (29-bit) IDs */
+  _Bool FIFO : 1;             /**< Target FIFO */
+};
+
+_Static_assert((sizeof(struct bxCANFilterRule)) ==
+                   ((sizeof(uint32_t) * 2U) + sizeof(bxcan_rx_handler_t) + 1U),
+               "bxCAN Filter rule struct size mismatch. Is it aligned?");
+
+/**
+ *  @brief Contains a gateway route
+ *
+ *  Frames of the routed filter match index are moved to
+ *  the target CAN by the receive interrupt, see
+ *  bxcan_set_route().
+ */
+struct __attribute__((packed)) bxCANRoute {
+  uint32_t ID;               /**< Outgoing ID when Rewrite is set */
+  bxcan_peripheral_t Target; /**< CAN the frames are sent on */
+  _Bool IDE     : 1;         /**< Outgoing ID is extended (29-bit) */
+  _Bool Rewrite : 1;         /**< Replace the ID, keep it otherwise */
+  _Bool Local   : 1;         /**< Also keep the frames in the ring */
+};
+
+_Static_assert((sizeof(struct bxCANRoute)) ==
+                   (sizeof(uint32_t) + sizeof(bxcan_peripheral_t) + 1U),
+               "bxCAN Route struct size mismatch. Is it aligned?");
+
 /**
  * @brief Sets the bxCAN to the specified mode
  *
@@ -261,7 +450,8 @@ void bxcan_set_interrupts(const bxcan_peripheral_t can,
  * The configuration options for the baudrate is
  * located in the bxCANBitrateConfig struct. Make sure
  * to not exceed the bit limit of the values and to
- * calculate the expected outcome beforehand.
+ * calculate the expected outcome beforehand, or let
+ * BXCAN_BITRATE() / bxcan_bitrate_solve() do it.
  *
  * @param can The selected CAN
  * @param config The baudrate configuration
@@ -270,6 +460,23 @@ void bxcan_set_interrupts(const bxcan_peripheral_t can,
 void bxcan_configure_bitrate(const bxcan_peripheral_t can,
                              const struct bxCANBitrateConfig config);
 
+/**
+ * @brief Solves the bxCAN bit timing at run time
+ *
+ * Same choice as BXCAN_BITRATE(): the most time quanta
+ * per bit that divide the clock, tBS1 rounded to the
+ * sample point and the widest jump width.
+ *
+ * @param clock The peripheral (APB1) clock in Hz
+ * @param bitrate The bitrate in bit/s
+ * @param sample_point The sample point in permille
+ * @param config The solved configuration
+ * @return TRUE if solved, FALSE if unreachable
+ */
+_Bool bxcan_bitrate_solve(const uint32_t clock, const uint32_t bitrate,
+                          const uint16_t sample_point,
+                          struct bxCANBitrateConfig *config);
+
 /**
  * @brief Configures the bxCAN automation according to config
  *
@@ -334,6 +541,94 @@ void bxcan_set_filter_start(const bxcan_peripheral_t can,
 void bxcan_configure_filter(const bxcan_peripheral_t can, const uint8_t filter,
                             const struct bxCANFilterConfig config);
 
+/**
+ * @brief Plans and programs the bxCAN filter banks
+ *
+ * Each rule subscribes to a single ID or an ID range of
+ * data frames. Ranges are split into aligned ID / mask
+ * blocks and packed as densely as the banks allow:
+ * standard IDs go to 16-bit banks (4 IDs in list mode,
+ * 2 blocks in mask mode), extended ones to 32-bit banks
+ * (2 IDs or 1 block). When the blocks still do not fit,
+ * the two blocks whose merged mask lets through the
+ * fewest extra IDs are merged until they do, so the
+ * hardware may then accept a superset of the rules. All
+ * banks of the range are written in a single filter
+ * initialization session, unused ones are deactivated.
+ * Filter match indexes follow the bank order, the
+ * dispatch table of the CAN is rebuilt from the rule
+ * handlers, so merges only happen between blocks of the
+ * same handler. The range must lie on the side of the
+ * CAN in the bank split of bxcan_set_filter_start().
+ *
+ * @param can The selected CAN
+ * @param rules Pointer to the subscriptions
+ * @param count The number of subscriptions
+ * @param first The first bank owned by the CAN
+ * @param banks The number of banks owned by the CAN
+ * @return Banks used, 0 if nothing was programmed
+ */
+uint8_t bxcan_filter_plan(const bxcan_peripheral_t can,
+                          const struct bxCANFilterRule *rules,
+                          const uint8_t count, const uint8_t first,
+                          const uint8_t banks);
+
+/**
+ * @brief Sets a receive dispatch handler by hand
+ *
+ * For banks set up by bxcan_configure_filter(), the
+ * filter match index numbering is described in the
+ * reference manual. Call after bxcan_filter_plan(),
+ * which rebuilds the table.
+ *
+ * @param can The selected CAN
+ * @param FIFO The selected FIFO
+ * @param fmi The filter match index
+ * @param handler The handler (NULL to clear)
+ * @return None
+ */
+void bxcan_set_rx_handler(const bxcan_peripheral_t can, const _Bool FIFO,
+                          const uint8_t fmi, const bxcan_rx_handler_t handler);
+
+/**
+ * @brief Routes received frames to another CAN
+ *
+ * Frames of the given FIFO and filter match index are
+ * forwarded from the RX interrupt as raw mailbox words:
+ * they go straight into a free transmit mailbox of the
+ * target, or into its transmit queue (see
+ * bxcan_tx_queue_start()) while frames are queued there
+ * or all mailboxes are busy. Like bxcan_tx_queue_push(),
+ * the places of frames being aborted are not taken.
+ * Only the identifier is touched on the way. Needs bxcan_rx_ring_start() on the
+ * receiving CAN. The route must stay valid while set.
+ * Call after bxcan_filter_plan(), which clears the
+ * routes of the CAN.
+ *
+ * @param can The receiving CAN
+ * @param FIFO The selected FIFO
+ * @param fmi The filter match index
+ * @param route Pointer to the route (NULL to clear)
+ * @return None
+ */
+void bxcan_set_route(const bxcan_peripheral_t can, const _Bool FIFO,
+                     const uint8_t fmi, const struct bxCANRoute *route);
+
+/**
+ * @brief Hands a received frame to its handler
+ *
+ * The handler is looked up by the FIFO and filter match
+ * index of the frame, no ID searching involved. Works on
+ * buffers of bxcan_rx_frame_fetch() and
+ * bxcan_rx_ring_pop().
+ *
+ * @param can The selected CAN
+ * @param buffer The Mailbox buffer
+ * @return TRUE if handled, FALSE if no handler is set
+ */
+_Bool bxcan_rx_dispatch(const bxcan_peripheral_t can,
+                        const struct bxCANMailboxRegs buffer);
+
 /**
  *  @brief Transmits the specified CAN frame
  *
@@ -379,6 +674,52 @@ void bxcan_rx_frame_fetch(const bxcan_peripheral_t can, const _Bool FIFO,
 void bxcan_rx_frame_process(const struct bxCANMailboxRegs buffer,
                             struct bxCANFrame *frame);
 
+/**
+ *  @brief Transmits a batch of CAN messages
+ *
+ *  Every free mailbox is loaded per status read, waiting
+ *  only while all three are busy. Messages are moved as
+ *  whole words, without per byte packing. Returns early
+ *  at the first message with a DLC above 8.
+ *
+ *  @param can The selected CAN
+ *  @param messages Pointer to the messages
+ *  @param count The number of messages
+ *  @return Messages handed to the mailboxes
+ */
+uint32_t bxcan_tx_frames(const bxcan_peripheral_t can,
+                         const struct bxCANMessage *messages,
+                         const uint32_t count);
+
+/**
+ *  @brief Receives a batch of CAN messages
+ *
+ *  Drains up to count pending messages of a FIFO without
+ *  waiting for more. Not to be used on a FIFO drained by
+ *  the interrupts of bxcan_rx_ring_start().
+ *
+ *  @param can The selected CAN
+ *  @param FIFO The selected FIFO
+ *  @param messages Pointer to the message buffer
+ *  @param count The buffer length in messages
+ *  @return Messages received
+ */
+uint32_t bxcan_rx_frames(const bxcan_peripheral_t can, const _Bool FIFO,
+                         struct bxCANMessage *messages, const uint32_t count);
+
+/**
+ *  @brief Unpacks a Mailbox buffer into a message
+ *
+ *  For buffers of bxcan_rx_frame_fetch() and
+ *  bxcan_rx_ring_pop().
+ *
+ *  @param buffer Pointer to the Mailbox buffer
+ *  @param message Pointer to the message
+ *  @return None
+ */
+void bxcan_rx_message_process(const struct bxCANMailboxRegs *buffer,
+                              struct bxCANMessage *message);
+
 /**
  *  @brief Fetches all CAN errors
  *
@@ -389,4 +730,180 @@ void bxcan_rx_frame_process(const struct bxCANMailboxRegs buffer,
  */
 const struct bxCANErrorInfo bxcan_get_error_info(const bxcan_peripheral_t can);
 
+/**
+ *  @brief Starts interrupt driven reception
+ *
+ *  Both FIFOs are drained by the RX0 / RX1 interrupts
+ *  into a software ring of raw mailbox words, decoding
+ *  is left to the consumer through
+ *  bxcan_rx_frame_process(). The interrupt only copies
+ *  four words per frame, so the three deep hardware
+ *  FIFOs survive back-to-back frames at 1 Mbit/s as long
+ *  as the handlers are not blocked for more than two
+ *  frame times (~100 us). Both handlers of a CAN must
+ *  share the same NVIC priority, the ring has a single
+ *  producer. The ring is emptied and the FIFO pending
+ *  and overrun interrupts are enabled on top of the ones
+ *  set by bxcan_set_interrupts().
+ *
+ *  @param can The selected CAN
+ *  @return None
+ */
+void bxcan_rx_ring_start(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Stops interrupt driven reception
+ *
+ *  Frames already in the ring can still be popped.
+ *
+ *  @param can The selected CAN
+ *  @return None
+ */
+void bxcan_rx_ring_stop(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Pops the oldest frame of the receive ring
+ *
+ *  Safe to call from a single consumer context while
+ *  the interrupts keep filling the ring.
+ *
+ *  @param can The selected CAN
+ *  @param buffer Pointer to the Mailbox buffer
+ *  @return TRUE if a frame was popped, FALSE if empty
+ */
+_Bool bxcan_rx_ring_pop(const bxcan_peripheral_t can,
+                        struct bxCANMailboxRegs *buffer);
+
+/**
+ *  @brief Returns the number of frames in the ring
+ *
+ *  @param can The selected CAN
+ *  @return Pending frame count
+ */
+uint32_t bxcan_rx_ring_pending(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Returns the number of frames lost to a full ring
+ *
+ *  @param can The selected CAN
+ *  @return Dropped frame count
+ */
+uint32_t bxcan_rx_ring_dropped(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Returns the number of hardware FIFO overruns
+ *
+ *  Each count stands for at least one lost frame.
+ *
+ *  @param can The selected CAN
+ *  @return FIFO overrun count
+ */
+uint32_t bxcan_rx_fifo_overruns(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Returns the number of frames lost by routing
+ *
+ *  Counts routed frames of the CAN that found both the
+ *  target mailboxes and transmit queue full, places kept
+ *  for aborted frames included.
+ *
+ *  @param can The receiving CAN
+ *  @return Dropped frame count
+ */
+uint32_t bxcan_route_dropped(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Starts the priority ordered transmit queue
+ *
+ *  Queued frames are kept sorted by their arbitration
+ *  priority (lower ID first, standard before extended,
+ *  data before remote) and fed to the mailboxes from the
+ *  TX interrupt, so the three mailboxes always hold the
+ *  most urgent frames of the node. Do not mix with
+ *  bxcan_tx_frame() on the same CAN. The queue is emptied
+ *  and the mailbox empty interrupt is enabled on top of
+ *  the ones set by bxcan_set_interrupts().
+ *
+ *  @param can The selected CAN
+ *  @return None
+ */
+void bxcan_tx_queue_start(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Queues a CAN frame for transmission
+ *
+ *  Does not block. If all mailboxes are busy and the
+ *  frame outranks one of them, the lowest priority
+ *  mailbox is aborted and its frame goes back into the
+ *  queue. Places are kept free for the frames being
+ *  aborted, a full queue waits for a mailbox instead.
+ *  Safe to call from interrupts.
+ *
+ *  @param can The selected CAN
+ *  @param frame Pointer to the bxCAN frame
+ *  @return TRUE if queued, FALSE if invalid or full
+ */
+_Bool bxcan_tx_queue_push(const bxcan_peripheral_t can,
+                          struct bxCANFrame *frame);
+
+/**
+ *  @brief Returns the number of frames not yet sent
+ *
+ *  Frames loaded in a mailbox are included.
+ *
+ *  @param can The selected CAN
+ *  @return Pending frame count
+ */
+uint32_t bxcan_tx_queue_pending(const bxcan_peripheral_t can);
+
+/**
+ *  @brief Returns the number of failed transmissions
+ *
+ *  Only counts frames given up by the hardware, which
+ *  happens with automatic retransmission disabled.
+ *
+ *  @param can The selected CAN
+ *  @return Failed frame count
+ */
+uint32_t bxcan_tx_queue_failed(const bxcan_peripheral_t can);
+
+#ifdef BXCAN_STATS
+/**
+ *  @brief Takes a snapshot of the bus statistics
+ *
+ *  Only built with BXCAN_STATS. The cycle counter has to
+ *  be running (cycles_init()), the first call with reset
+ *  starts the window. As the counter wraps every ~23 s,
+ *  keep windows shorter than that. Transmissions are
+ *  accounted by the TX interrupt, started with
+ *  bxcan_tx_queue_start(), receptions by every receive
+ *  path. The load only covers frames this node sends or
+ *  accepts. Lost arbitrations only show up with automatic
+ *  retransmission off, otherwise they stretch the latency.
+ *
+ *  @param can The selected CAN
+ *  @param stats The statistics copy
+ *  @param reset Start a new window afterwards
+ *  @return None
+ */
+void bxcan_stats_snapshot(const bxcan_peripheral_t can,
+                          struct bxCANStats *stats, const _Bool reset);
+#endif
+
+/**
+ *  @brief bxCAN interrupt handlers.
+ *
+ *  @return None
+ */
+#ifdef CAN1_BASE
+void CAN1_TX_IRQHandler(void);
+void CAN1_RX0_IRQHandler(void);
+void CAN1_RX1_IRQHandler(void);
+#endif
+#ifdef CAN2_BASE
+void CAN2_TX_IRQHandler(void);
+void CAN2_RX0_IRQHandler(void);
+void CAN2_RX1_IRQHandler(void);
+#endif
+
 #endif
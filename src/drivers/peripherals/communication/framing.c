@@ -0,0 +1,436 @@
+/** @file framing.c
+ *  @brief Function defines for the packet framing layer.
+ *
+ *  This file contains all of the function definitions
+ *  declared in framing.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include "framing.h"
+#include "critical.h"
+
+/* COBS encoder states */
+#define FRAME_STATE_START 0U
+#define FRAME_STATE_BLOCK 1U
+#define FRAME_STATE_DELIM 2U
+#define FRAME_STATE_DONE  3U
+
+/* Longest COBS block, code 0xFF */
+#define FRAME_COBS_BLOCK_LEN 254U
+
+static inline uint16_t frame_next(const struct FrameView *view,
+                                  const uint16_t index) {
+  return (((uint32_t)index + 1U) >= view->Size) ? 0U : (uint16_t)(index + 1U);
+}
+
+static inline _Bool verifyView(const struct FrameView *view) {
+  if (view == NULL) {
+    return FALSE;
+  } else if ((view->Ring == NULL) || (view->Size == 0U)) {
+    return FALSE;
+  } else if ((view->Offset >= view->Size) || (view->Length > view->Size)) {
+    return FALSE;
+  } else {
+    return TRUE;
+  }
+}
+
+static void frame_trailer(uint8_t *trailer, const uint8_t *packet,
+                          const uint16_t length, const frame_crc_t crc) {
+  const uint32_t value = crc(packet, length, FRAME_CRC_INIT);
+
+  /* Big endian, so the CRC over packet + trailer is 0 */
+  trailer[0] = (uint8_t)(value >> 24U);
+  trailer[1] = (uint8_t)(value >> 16U);
+  trailer[2] = (uint8_t)(value >> 8U);
+  trailer[3] = (uint8_t)value;
+}
+
+/* Splits off the frame up to the next delimiter */
+static _Bool frame_split(struct FrameView *input, const uint8_t delimiter,
+                         struct FrameView *frame) {
+  uint16_t index = input->Offset;
+
+  for (uint16_t n = 0U; n < input->Length; n++) {
+    if (input->Ring[index] == delimiter) {
+      *frame = *input;
+      frame->Length = n;
+
+      input->Offset = frame_next(input, index);
+      input->Length -= (n + 1U);
+      return TRUE;
+    }
+    index = frame_next(input, index);
+  }
+
+  return FALSE;
+}
+
+/* Verifies and strips the CRC trailer, the view may wrap */
+static _Bool frame_check_crc(struct FrameView *packet, const frame_crc_t crc) {
+  if (crc == NULL) {
+    return TRUE;
+  } else if (packet->Length < FRAME_CRC_LEN) {
+    return FALSE;
+  } else {
+    uint16_t first = (packet->Size - packet->Offset);
+    if (first > packet->Length) {
+      first = packet->Length;
+    }
+
+    uint32_t value = crc(&packet->Ring[packet->Offset], first, FRAME_CRC_INIT);
+    value = crc(packet->Ring, (packet->Length - first), value);
+    packet->Length -= FRAME_CRC_LEN;
+
+    return (value == 0U);
+  }
+}
+
+static inline uint8_t frame_cobs_byte(const struct FrameCOBSEncoder *encoder,
+                                      const uint32_t index) {
+  return (index < encoder->DataLength)
+             ? encoder->Data[index]
+             : encoder->Trailer[index - encoder->DataLength];
+}
+
+void frame_cobs_encoder_init(struct FrameCOBSEncoder *encoder,
+                             const uint8_t *packet, const uint16_t length,
+                             const frame_crc_t crc) {
+  if (encoder == NULL) {
+    return;
+  } else {
+    encoder->Data = packet;
+    encoder->DataLength = (packet == NULL) ? 0U : length;
+    encoder->Length = encoder->DataLength;
+    encoder->Pos = 0U;
+    encoder->Remaining = 0U;
+    encoder->Code = 0U;
+    encoder->State = FRAME_STATE_START;
+
+    if (crc != NULL) {
+      frame_trailer(encoder->Trailer, packet, encoder->DataLength, crc);
+      encoder->Length += FRAME_CRC_LEN;
+    }
+  }
+}
+
+uint16_t frame_cobs_encode_chunk(struct FrameCOBSEncoder *encoder,
+                                 uint8_t *out, const uint16_t size) {
+  if ((encoder == NULL) || (out == NULL)) {
+    return 0U;
+  }
+
+  uint16_t written = 0U;
+  while (written < size) {
+    if (encoder->Remaining > 0U) {
+      /* Copy the current block */
+      out[written++] = frame_cobs_byte(encoder, encoder->Pos++);
+      encoder->Remaining--;
+    } else if (encoder->State == FRAME_STATE_BLOCK) {
+      /* Block done: a short block replaces a zero, a full
+       * one does not, and the input end closes the frame */
+      if (encoder->Pos >= encoder->Length) {
+        encoder->State = FRAME_STATE_DELIM;
+      } else {
+        encoder->Pos += (encoder->Code != 0xFFU) ? 1U : 0U;
+        encoder->State = FRAME_STATE_START;
+      }
+    } else if (encoder->State == FRAME_STATE_START) {
+      /* Look ahead for the block length */
+      uint32_t n = 0U;
+      while ((n < FRAME_COBS_BLOCK_LEN) &&
+             ((encoder->Pos + n) < encoder->Length) &&
+             (frame_cobs_byte(encoder, (encoder->Pos + n)) != 0U)) {
+        n++;
+      }
+
+      encoder->Code = (uint8_t)(n + 1U);
+      encoder->Remaining = (uint8_t)n;
+      encoder->State = FRAME_STATE_BLOCK;
+      out[written++] = encoder->Code;
+    } else if (encoder->State == FRAME_STATE_DELIM) {
+      out[written++] = FRAME_COBS_DELIM;
+      encoder->State = FRAME_STATE_DONE;
+    } else {
+      break;
+    }
+  }
+
+  return written;
+}
+
+uint32_t frame_cobs_encode(const uint8_t *packet, const uint16_t length,
+                           const frame_crc_t crc, uint8_t *out,
+                           const uint32_t size) {
+  if (out == NULL) {
+    return 0U;
+  } else {
+    struct FrameCOBSEncoder encoder;
+    uint32_t total = 0U;
+
+    frame_cobs_encoder_init(&encoder, packet, length, crc);
+    while (total < size) {
+      const uint32_t space = (size - total);
+      const uint16_t written = frame_cobs_encode_chunk(
+          &encoder, &out[total], (space > 0xFFFFU) ? 0xFFFFU : space);
+      if (written == 0U) {
+        break;
+      }
+      total += written;
+    }
+
+    return (encoder.State == FRAME_STATE_DONE) ? total : 0U;
+  }
+}
+
+/* The output never overtakes the input, decode in place */
+static _Bool frame_cobs_decode(struct FrameView *frame) {
+  uint16_t read = frame->Offset;
+  uint16_t write = frame->Offset;
+  uint16_t remaining = frame->Length;
+  uint16_t length = 0U;
+
+  while (remaining > 0U) {
+    const uint8_t code = frame->Ring[read];
+    read = frame_next(frame, read);
+    remaining--;
+
+    /* No zeros inside a frame, so code >= 1 */
+    if ((uint16_t)(code - 1U) > remaining) {
+      return FALSE;
+    }
+
+    for (uint8_t i = 1U; i < code; i++) {
+      frame->Ring[write] = frame->Ring[read];
+      write = frame_next(frame, write);
+      read = frame_next(frame, read);
+    }
+    remaining -= (code - 1U);
+    length += (code - 1U);
+
+    if ((code != 0xFFU) && (remaining > 0U)) {
+      frame->Ring[write] = 0U;
+      write = frame_next(frame, write);
+      length++;
+    }
+  }
+
+  frame->Length = length;
+  return TRUE;
+}
+
+frame_status_t frame_cobs_next(struct FrameView *input, const frame_crc_t crc,
+                               struct FrameView *packet) {
+  if (!verifyView(input) || (packet == NULL)) {
+    return FRAME_ERROR;
+  } else {
+    struct FrameView frame;
+
+    /* Back to back delimiters are just padding */
+    do {
+      if (!frame_split(input, FRAME_COBS_DELIM, &frame)) {
+        return FRAME_MORE;
+      }
+    } while (frame.Length == 0U);
+
+    if (!frame_cobs_decode(&frame) || !frame_check_crc(&frame, crc)) {
+      return FRAME_ERROR;
+    }
+
+    *packet = frame;
+    return FRAME_OK;
+  }
+}
+
+static void frame_tx_sent(const usart_peripheral_t usart, const uint8_t *buffer,
+                          const uint16_t length, const _Bool error,
+                          void *context);
+
+static _Bool frame_tx_queue(struct FrameTx *tx, const uint8_t stage,
+                            const uint16_t length) {
+  tx->InFlight++;
+  if (!usart_tx_dma(tx->USART, tx->Stage[stage], length, frame_tx_sent, tx)) {
+    tx->InFlight--;
+    tx->Error = TRUE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void frame_tx_sent(const usart_peripheral_t usart, const uint8_t *buffer,
+                          const uint16_t length, const _Bool error,
+                          void *context) {
+  struct FrameTx *tx = (struct FrameTx *)context;
+  const uint8_t stage = (buffer == tx->Stage[0]) ? 0U : 1U;
+  (void)usart;
+  (void)length;
+
+  tx->InFlight--;
+  if (error == TRUE) {
+    tx->Error = TRUE;
+  }
+
+  /* Refill the stage that just went out */
+  if (tx->Error == FALSE) {
+    const uint16_t next = frame_cobs_encode_chunk(
+        &tx->Encoder, tx->Stage[stage], FRAME_STAGE_LEN);
+    if (next > 0U) {
+      (void)frame_tx_queue(tx, stage, next);
+    }
+  }
+
+  if (tx->InFlight == 0U) {
+    tx->Busy = FALSE;
+    if (tx->Callback != NULL) {
+      tx->Callback(tx, tx->Error, tx->Context);
+    }
+  }
+}
+
+_Bool frame_cobs_tx(const usart_peripheral_t usart, struct FrameTx *tx,
+                    const uint8_t *packet, const uint16_t length,
+                    const frame_crc_t crc, const frame_tx_callback_t callback,
+                    void *context) {
+  if (tx == NULL) {
+    return FALSE;
+  } else if ((packet == NULL) && (length > 0U)) {
+    return FALSE;
+  } else if (tx->Busy == TRUE) {
+    return FALSE;
+  } else {
+    frame_cobs_encoder_init(&tx->Encoder, packet, length, crc);
+    tx->Callback = callback;
+    tx->Context = context;
+    tx->USART = usart;
+    tx->InFlight = 0U;
+    tx->Error = FALSE;
+    tx->Busy = TRUE;
+
+    /* Encode both stages up front, the rest is encoded
+     * from the DMA interrupt */
+    const uint16_t first =
+        frame_cobs_encode_chunk(&tx->Encoder, tx->Stage[0], FRAME_STAGE_LEN);
+    const uint16_t second =
+        frame_cobs_encode_chunk(&tx->Encoder, tx->Stage[1], FRAME_STAGE_LEN);
+
+    /* Queue both before the first completion can run */
+    const uint32_t primask = critical_enter();
+    const _Bool started = frame_tx_queue(tx, 0U, first);
+    if ((started == TRUE) && (second > 0U)) {
+      (void)frame_tx_queue(tx, 1U, second);
+    }
+    critical_exit(primask);
+
+    if (started == FALSE) {
+      tx->Busy = FALSE;
+    }
+
+    return started;
+  }
+}
+
+uint32_t frame_slip_encode(const uint8_t *packet, const uint16_t length,
+                           const frame_crc_t crc, uint8_t *out,
+                           const uint32_t size) {
+  if (out == NULL) {
+    return 0U;
+  } else if ((packet == NULL) && (length > 0U)) {
+    return 0U;
+  } else {
+    uint8_t trailer[FRAME_CRC_LEN];
+    const uint32_t total = length + ((crc != NULL) ? FRAME_CRC_LEN : 0U);
+    uint32_t written = 0U;
+
+    if (crc != NULL) {
+      frame_trailer(trailer, packet, length, crc);
+    }
+
+    if (size < 2U) {
+      return 0U;
+    }
+    out[written++] = FRAME_SLIP_END;
+
+    for (uint32_t i = 0U; i < total; i++) {
+      const uint8_t byte = (i < length) ? packet[i] : trailer[i - length];
+
+      /* Keep room for the closing END */
+      if ((byte == FRAME_SLIP_END) || (byte == FRAME_SLIP_ESC)) {
+        if ((written + 3U) > size) {
+          return 0U;
+        }
+        out[written++] = FRAME_SLIP_ESC;
+        out[written++] = (byte == FRAME_SLIP_END) ? FRAME_SLIP_ESCEND
+                                                  : FRAME_SLIP_ESCESC;
+      } else {
+        if ((written + 2U) > size) {
+          return 0U;
+        }
+        out[written++] = byte;
+      }
+    }
+
+    out[written++] = FRAME_SLIP_END;
+    return written;
+  }
+}
+
+/* Escapes only ever shrink, decode in place */
+static _Bool frame_slip_decode(struct FrameView *frame) {
+  uint16_t read = frame->Offset;
+  uint16_t write = frame->Offset;
+  uint16_t length = 0U;
+  _Bool escaped = FALSE;
+
+  for (uint16_t n = 0U; n < frame->Length; n++) {
+    uint8_t byte = frame->Ring[read];
+    read = frame_next(frame, read);
+
+    if (escaped == TRUE) {
+      if (byte == FRAME_SLIP_ESCEND) {
+        byte = FRAME_SLIP_END;
+      } else if (byte == FRAME_SLIP_ESCESC) {
+        byte = FRAME_SLIP_ESC;
+      } else {
+        return FALSE;
+      }
+      escaped = FALSE;
+    } else if (byte == FRAME_SLIP_ESC) {
+      escaped = TRUE;
+      continue;
+    }
+
+    frame->Ring[write] = byte;
+    write = frame_next(frame, write);
+    length++;
+  }
+
+  frame->Length = length;
+  return (escaped == FALSE);
+}
+
+frame_status_t frame_slip_next(struct FrameView *input, const frame_crc_t crc,
+                               struct FrameView *packet) {
+  if (!verifyView(input) || (packet == NULL)) {
+    return FRAME_ERROR;
+  } else {
+    struct FrameView frame;
+
+    /* The opening END shows up as an empty frame */
+    do {
+      if (!frame_split(input, FRAME_SLIP_END, &frame)) {
+        return FRAME_MORE;
+      }
+    } while (frame.Length == 0U);
+
+    if (!frame_slip_decode(&frame) || !frame_check_crc(&frame, crc)) {
+      return FRAME_ERROR;
+    }
+
+    *packet = frame;
+    return FRAME_OK;
+  }
+}
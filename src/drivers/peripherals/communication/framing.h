@@ -0,0 +1,236 @@
+/** @file framing.h
+ *  @brief Function prototypes for the packet framing layer.
+ *
+ *  This file contains all of the structs, enums, macros,
+ *  and function prototypes required for COBS and SLIP
+ *  framing on top of the USART driver.
+ *
+ *  COBS frames end with a 0x00 delimiter, SLIP frames are
+ *  enclosed by 0xC0. Both optionally carry a big endian
+ *  CRC-32 trailer produced by a caller supplied hook, see
+ *  frame_crc_t. Decoding happens in place, also on the
+ *  USART DMA receive ring, so received packets are views
+ *  that may wrap around the end of the ring.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef FRAMING_H
+#define FRAMING_H
+
+/* -- Includes -- */
+#include <stddef.h>
+#include <stdint.h>
+#include "defines.h"
+#include "usart.h"
+
+/* -- Defines -- */
+/** @brief Size of each of the two COBS DMA staging buffers */
+#define FRAME_STAGE_LEN 64U
+
+/** @brief Length of the CRC trailer */
+#define FRAME_CRC_LEN  4U
+#define FRAME_CRC_INIT 0xFFFFFFFFUL
+
+/** @brief Worst case encoded sizes, delimiters included */
+#define FRAME_COBS_MAX(len) ((len) + ((len) / 254U) + 2U)
+#define FRAME_SLIP_MAX(len) (((len) * 2U) + 2U)
+
+/** @brief Special bytes of the framings */
+#define FRAME_COBS_DELIM  0x00U
+#define FRAME_SLIP_END    0xC0U
+#define FRAME_SLIP_ESC    0xDBU
+#define FRAME_SLIP_ESCEND 0xDCU
+#define FRAME_SLIP_ESCESC 0xDDU
+
+/* -- Types -- */
+/**
+ *  @brief CRC hook
+ *
+ *  Must implement a non-reflected CRC-32 without final
+ *  XOR, started with FRAME_CRC_INIT and chainable through
+ *  the crc argument. crc_update() (hardware CRC unit) and
+ *  crc_update_soft() both fit.
+ */
+typedef uint32_t (*frame_crc_t)(const uint8_t *data, const size_t length,
+                                const uint32_t crc);
+
+/**
+ *  @brief Result of extracting a frame
+ */
+typedef enum frame_status {
+  FRAME_OK = 0x00,   /**< Packet decoded */
+  FRAME_MORE = 0x01, /**< No complete frame in the input */
+  FRAME_ERROR = 0x02 /**< Corrupted frame skipped */
+} frame_status_t;
+
+/**
+ *  @brief Contains a view into a (ring) buffer
+ *
+ *  Byte i of the view is located at
+ *  Ring[(Offset + i) % Size]. Plain buffers are views with
+ *  Offset 0 and Size equal to Length.
+ */
+struct FrameView {
+  uint8_t *Ring;
+  uint16_t Size;
+  uint16_t Offset;
+  uint16_t Length;
+};
+
+/**
+ *  @brief Contains the state of a chunked COBS encoder
+ */
+struct FrameCOBSEncoder {
+  const uint8_t *Data;
+  uint32_t Length; /**< Packet plus trailer length */
+  uint32_t Pos;    /**< Next input byte */
+  uint16_t DataLength;
+  uint8_t Trailer[FRAME_CRC_LEN];
+  uint8_t Remaining; /**< Bytes left in the current block */
+  uint8_t Code;      /**< Code of the current block */
+  uint8_t State;
+};
+
+struct FrameTx;
+
+/**
+ *  @brief Streamed frame completion callback
+ *
+ *  Called from the DMA interrupt once the whole frame has
+ *  been handed over to the USART.
+ */
+typedef void (*frame_tx_callback_t)(struct FrameTx *tx, const _Bool error,
+                                    void *context);
+
+/**
+ *  @brief Contains the state of a streamed COBS frame
+ *
+ *  Owned by the caller and busy until the callback fires.
+ */
+struct FrameTx {
+  struct FrameCOBSEncoder Encoder;
+  uint8_t Stage[2][FRAME_STAGE_LEN];
+  frame_tx_callback_t Callback;
+  void *Context;
+  usart_peripheral_t USART;
+  uint8_t InFlight; /**< Stages queued for DMA */
+  _Bool Error;
+  volatile _Bool Busy;
+};
+
+/**
+ * @brief Prepares a chunked COBS encoder.
+ *
+ * @param encoder The encoder state
+ * @param packet Pointer to the packet
+ * @param length The packet length
+ * @param crc CRC hook for the trailer (may be NULL)
+ * @return None
+ */
+void frame_cobs_encoder_init(struct FrameCOBSEncoder *encoder,
+                             const uint8_t *packet, const uint16_t length,
+                             const frame_crc_t crc);
+
+/**
+ * @brief Encodes the next part of a COBS frame.
+ *
+ * The output may be of any size, blocks are split across
+ * chunks as needed. The last chunk ends with the
+ * delimiter.
+ *
+ * @param encoder The encoder state
+ * @param out Pointer to the output buffer
+ * @param size The output buffer size
+ * @return Bytes written, 0 once the frame is complete
+ */
+uint16_t frame_cobs_encode_chunk(struct FrameCOBSEncoder *encoder,
+                                 uint8_t *out, const uint16_t size);
+
+/**
+ * @brief Encodes a whole COBS frame.
+ *
+ * @param packet Pointer to the packet
+ * @param length The packet length
+ * @param crc CRC hook for the trailer (may be NULL)
+ * @param out Pointer to the output buffer
+ * @param size The output buffer size, see FRAME_COBS_MAX
+ * @return Frame length, 0 if it does not fit
+ */
+uint32_t frame_cobs_encode(const uint8_t *packet, const uint16_t length,
+                           const frame_crc_t crc, uint8_t *out,
+                           const uint32_t size);
+
+/**
+ * @brief Extracts the next COBS frame of the input.
+ *
+ * Looks for the next delimiter, decodes the frame in
+ * place and checks the CRC trailer if a hook is given.
+ * The input view is advanced past the delimiter on OK
+ * and ERROR, on MORE it is left alone so the caller can
+ * extend it once more data arrive. Empty frames are
+ * skipped.
+ *
+ * @param input The received data, updated
+ * @param crc CRC hook for the trailer (may be NULL)
+ * @param packet The decoded packet, without trailer
+ * @return The frame status
+ */
+frame_status_t frame_cobs_next(struct FrameView *input, const frame_crc_t crc,
+                               struct FrameView *packet);
+
+/**
+ * @brief Streams a COBS frame through the USART TX DMA.
+ *
+ * The packet is encoded into the two staging buffers of
+ * tx in turns: while DMA sends one of them the completion
+ * interrupt encodes the next chunk into the other, so
+ * the packet is never copied as a whole. The packet must
+ * stay untouched until the callback fires.
+ *
+ * @param usart The selected USART
+ * @param tx Caller owned frame state
+ * @param packet Pointer to the packet
+ * @param length The packet length
+ * @param crc CRC hook for the trailer (may be NULL)
+ * @param callback Completion callback (may be NULL)
+ * @param context User pointer passed to the callback
+ * @return TRUE if started, FALSE if invalid or busy
+ */
+_Bool frame_cobs_tx(const usart_peripheral_t usart, struct FrameTx *tx,
+                    const uint8_t *packet, const uint16_t length,
+                    const frame_crc_t crc, const frame_tx_callback_t callback,
+                    void *context);
+
+/**
+ * @brief Encodes a whole SLIP frame.
+ *
+ * The frame starts and ends with END, so a receiver can
+ * drop line noise before the first packet.
+ *
+ * @param packet Pointer to the packet
+ * @param length The packet length
+ * @param crc CRC hook for the trailer (may be NULL)
+ * @param out Pointer to the output buffer
+ * @param size The output buffer size, see FRAME_SLIP_MAX
+ * @return Frame length, 0 if it does not fit
+ */
+uint32_t frame_slip_encode(const uint8_t *packet, const uint16_t length,
+                           const frame_crc_t crc, uint8_t *out,
+                           const uint32_t size);
+
+/**
+ * @brief Extracts the next SLIP frame of the input.
+ *
+ * Same semantics as frame_cobs_next().
+ *
+ * @param input The received data, updated
+ * @param crc CRC hook for the trailer (may be NULL)
+ * @param packet The decoded packet, without trailer
+ * @return The frame status
+ */
+frame_status_t frame_slip_next(struct FrameView *input, const frame_crc_t crc,
+                               struct FrameView *packet);
+
+#endif
@@ -0,0 +1,427 @@
+/** @file isotp.c
+ *  @brief Function defines for the ISO-TP transport layer.
+ *
+ *  This file contains all of the function definitions
+ *  declared in isotp.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include "isotp.h"
+#include "critical.h"
+
+/* Protocol control information, high nibble of byte 0 */
+#define ISOTP_PCI_SF 0x0U
+#define ISOTP_PCI_FF 0x1U
+#define ISOTP_PCI_CF 0x2U
+#define ISOTP_PCI_FC 0x3U
+
+/* Flow control frames, PCI byte with the flow status */
+#define ISOTP_FC_CTS   0x30U
+#define ISOTP_FC_WAIT  0x31U
+#define ISOTP_FC_OVFLW 0x32U
+
+/* Payload per frame type */
+#define ISOTP_SF_LEN 7U
+#define ISOTP_FF_LEN 6U
+#define ISOTP_CF_LEN 7U
+
+/* Sender states */
+#define ISOTP_TX_IDLE 0U
+#define ISOTP_TX_SF   1U /* Single frame waiting for the queue */
+#define ISOTP_TX_FF   2U /* First frame waiting for the queue */
+#define ISOTP_TX_FC   3U /* Waiting for flow control */
+#define ISOTP_TX_CF   4U /* Sending consecutive frames */
+
+/* Receiver states */
+#define ISOTP_RX_IDLE 0U
+#define ISOTP_RX_CF   1U
+
+static struct ISOTPChannel *isotp_channels = NULL;
+
+/* Timestamp of the last isotp_poll() */
+static volatile uint32_t isotp_time = 0U;
+
+static inline _Bool isotp_due(const uint32_t time) {
+  return ((int32_t)(isotp_time - time) >= 0);
+}
+
+static inline uint32_t isotp_stmin_us(const uint8_t stmin) {
+  if (stmin <= 0x7FU) {
+    return ((uint32_t)stmin * 1000UL);
+  } else if ((stmin >= 0xF1U) && (stmin <= 0xF9U)) {
+    return ((uint32_t)(stmin - 0xF0U) * 100UL);
+  } else {
+    /* Reserved values mean the longest time */
+    return 127000UL;
+  }
+}
+
+/* Queues a padded frame, the payload comes straight from
+ * the caller buffer */
+static _Bool isotp_push(const struct ISOTPChannel *channel,
+                        const uint8_t *pci, const uint8_t pci_len,
+                        const uint8_t *data, const uint8_t data_len) {
+  struct bxCANFrame frame = {
+      .ID = channel->Config.TxID,
+      .IDE = channel->Config.IDE,
+      .DLC = 8U,
+  };
+
+  uint8_t i = 0U;
+  for (uint8_t n = 0U; n < pci_len; n++) {
+    frame.DATA[i++] = pci[n];
+  }
+  for (uint8_t n = 0U; n < data_len; n++) {
+    frame.DATA[i++] = data[n];
+  }
+  while (i < 8U) {
+    frame.DATA[i++] = ISOTP_PADDING;
+  }
+
+  return bxcan_tx_queue_push(channel->CAN, &frame);
+}
+
+/* Sends what is pending, returns the events to report */
+static uint8_t isotp_service(struct ISOTPChannel *channel) {
+  uint8_t events = 0U;
+
+  if (channel->RxFlow != 0U) {
+    const uint8_t fc[3] = {channel->RxFlow, channel->Config.BlockSize,
+                           channel->Config.STmin};
+    if (isotp_push(channel, fc, 3U, NULL, 0U)) {
+      channel->RxFlow = 0U;
+    }
+  }
+
+  switch (channel->TxState) {
+  case ISOTP_TX_SF: {
+    const uint8_t pci = (uint8_t)channel->TxLength;
+    if (isotp_push(channel, &pci, 1U, channel->TxData, pci)) {
+      channel->TxState = ISOTP_TX_IDLE;
+      events |= (uint8_t)BIT(ISOTP_TX_DONE);
+    }
+    break;
+  }
+  case ISOTP_TX_FF: {
+    const uint8_t pci[2] = {
+        (uint8_t)((ISOTP_PCI_FF << 4U) | (channel->TxLength >> 8U)),
+        (uint8_t)channel->TxLength};
+    if (isotp_push(channel, pci, 2U, channel->TxData, ISOTP_FF_LEN)) {
+      channel->TxOffset = ISOTP_FF_LEN;
+      channel->TxSN = 1U;
+      channel->TxWaits = 0U;
+      channel->TxTime = isotp_time + ISOTP_N_BS_US;
+      channel->TxState = ISOTP_TX_FC;
+    }
+    break;
+  }
+  case ISOTP_TX_CF:
+    /* Back to back while STmin is 0 and the queue has room */
+    while (isotp_due(channel->TxTime)) {
+      const uint8_t pci = (uint8_t)((ISOTP_PCI_CF << 4U) | channel->TxSN);
+      const uint16_t left = (channel->TxLength - channel->TxOffset);
+      const uint8_t len = (left < ISOTP_CF_LEN) ? (uint8_t)left : ISOTP_CF_LEN;
+      if (!isotp_push(channel, &pci, 1U, &channel->TxData[channel->TxOffset],
+                      len)) {
+        break;
+      }
+
+      channel->TxOffset += len;
+      channel->TxSN = ((channel->TxSN + 1U) & 0xFU);
+      if (channel->TxOffset >= channel->TxLength) {
+        channel->TxState = ISOTP_TX_IDLE;
+        events |= (uint8_t)BIT(ISOTP_TX_DONE);
+        break;
+      } else if ((channel->TxBlock != 0U) && (--channel->TxLeft == 0U)) {
+        channel->TxTime = isotp_time + ISOTP_N_BS_US;
+        channel->TxState = ISOTP_TX_FC;
+        break;
+      }
+
+      channel->TxTime = isotp_time + channel->TxSTmin;
+      if (channel->TxSTmin != 0U) {
+        break;
+      }
+    }
+    break;
+  default:
+    break;
+  }
+
+  return events;
+}
+
+static void isotp_report(struct ISOTPChannel *channel, const uint8_t events) {
+  if (channel->Callback == NULL) {
+    return;
+  }
+
+  for (uint8_t event = 0U; event <= ISOTP_RX_SEQUENCE; event++) {
+    if (events & BIT(event)) {
+      channel->Callback(channel, (isotp_event_t)event, channel->Context);
+    }
+  }
+}
+
+static uint8_t isotp_rx_flow(struct ISOTPChannel *channel,
+                             const struct bxCANFrame *frame) {
+  if ((channel->TxState != ISOTP_TX_FC) || (frame->DLC < 3U)) {
+    return 0U;
+  }
+
+  switch (frame->DATA[0]) {
+  case ISOTP_FC_CTS:
+    channel->TxBlock = frame->DATA[1];
+    channel->TxLeft = frame->DATA[1];
+    channel->TxSTmin = isotp_stmin_us(frame->DATA[2]);
+    channel->TxWaits = 0U;
+    channel->TxTime = isotp_time;
+    channel->TxState = ISOTP_TX_CF;
+    return 0U;
+  case ISOTP_FC_WAIT:
+    if (++channel->TxWaits <= ISOTP_WFT_MAX) {
+      channel->TxTime = isotp_time + ISOTP_N_BS_US;
+      return 0U;
+    }
+    channel->TxState = ISOTP_TX_IDLE;
+    return (uint8_t)BIT(ISOTP_TX_ERROR);
+  case ISOTP_FC_OVFLW:
+    channel->TxState = ISOTP_TX_IDLE;
+    return (uint8_t)BIT(ISOTP_TX_OVERFLOW);
+  default:
+    channel->TxState = ISOTP_TX_IDLE;
+    return (uint8_t)BIT(ISOTP_TX_ERROR);
+  }
+}
+
+static uint8_t isotp_rx_data(struct ISOTPChannel *channel,
+                             const struct bxCANFrame *frame) {
+  const uint8_t pci = (frame->DATA[0] >> 4U);
+  const uint8_t low = (frame->DATA[0] & 0xFU);
+
+  if (pci == ISOTP_PCI_SF) {
+    if ((low == 0U) || (low >= frame->DLC)) {
+      return 0U;
+    }
+
+    /* A single frame also ends a reception in progress */
+    channel->RxState = ISOTP_RX_IDLE;
+    if (low > channel->RxSize) {
+      return (uint8_t)BIT(ISOTP_RX_OVERFLOW);
+    }
+    for (uint8_t i = 0U; i < low; i++) {
+      channel->RxBuffer[i] = frame->DATA[1U + i];
+    }
+    channel->RxLength = low;
+    return (uint8_t)BIT(ISOTP_RX_DONE);
+  } else if (pci == ISOTP_PCI_FF) {
+    const uint16_t length = (uint16_t)(((uint16_t)low << 8U) | frame->DATA[1]);
+    if ((frame->DLC != 8U) || (length <= ISOTP_SF_LEN)) {
+      return 0U;
+    }
+
+    channel->RxState = ISOTP_RX_IDLE;
+    if (length > channel->RxSize) {
+      channel->RxFlow = ISOTP_FC_OVFLW;
+      return (uint8_t)BIT(ISOTP_RX_OVERFLOW);
+    }
+    for (uint8_t i = 0U; i < ISOTP_FF_LEN; i++) {
+      channel->RxBuffer[i] = frame->DATA[2U + i];
+    }
+    channel->RxLength = length;
+    channel->RxOffset = ISOTP_FF_LEN;
+    channel->RxSN = 1U;
+    channel->RxLeft = channel->Config.BlockSize;
+    channel->RxFlow = ISOTP_FC_CTS;
+    channel->RxTime = isotp_time + ISOTP_N_CR_US;
+    channel->RxState = ISOTP_RX_CF;
+    return 0U;
+  } else if ((pci == ISOTP_PCI_CF) && (channel->RxState == ISOTP_RX_CF)) {
+    if (low != channel->RxSN) {
+      channel->RxState = ISOTP_RX_IDLE;
+      return (uint8_t)BIT(ISOTP_RX_SEQUENCE);
+    }
+
+    const uint16_t left = (channel->RxLength - channel->RxOffset);
+    const uint8_t len = (left < ISOTP_CF_LEN) ? (uint8_t)left : ISOTP_CF_LEN;
+    if (len >= frame->DLC) {
+      return 0U;
+    }
+    for (uint8_t i = 0U; i < len; i++) {
+      channel->RxBuffer[channel->RxOffset + i] = frame->DATA[1U + i];
+    }
+
+    channel->RxOffset += len;
+    channel->RxSN = ((channel->RxSN + 1U) & 0xFU);
+    if (channel->RxOffset >= channel->RxLength) {
+      channel->RxState = ISOTP_RX_IDLE;
+      return (uint8_t)BIT(ISOTP_RX_DONE);
+    }
+
+    channel->RxTime = isotp_time + ISOTP_N_CR_US;
+    if ((channel->Config.BlockSize != 0U) && (--channel->RxLeft == 0U)) {
+      channel->RxLeft = channel->Config.BlockSize;
+      channel->RxFlow = ISOTP_FC_CTS;
+    }
+    return 0U;
+  } else if (pci == ISOTP_PCI_FC) {
+    return isotp_rx_flow(channel, frame);
+  } else {
+    return 0U;
+  }
+}
+
+_Bool isotp_open(struct ISOTPChannel *channel, const bxcan_peripheral_t can,
+                 const struct ISOTPConfig config, uint8_t *buffer,
+                 const uint16_t size, const isotp_callback_t callback,
+                 void *context) {
+  if (channel == NULL) {
+    return FALSE;
+  } else if ((uint32_t)can >= (uint32_t)BXCAN_PERIPH_LEN) {
+    return FALSE;
+  } else if ((buffer == NULL) && (size != 0U)) {
+    return FALSE;
+  } else {
+    const uint32_t primask = critical_enter();
+
+    for (const struct ISOTPChannel *open = isotp_channels; open != NULL;
+         open = open->Next) {
+      if (open == channel) {
+        critical_exit(primask);
+        return FALSE;
+      }
+    }
+
+    *channel = (struct ISOTPChannel){
+        .Config = config,
+        .CAN = can,
+        .Callback = callback,
+        .Context = context,
+        .Next = isotp_channels,
+        .RxBuffer = buffer,
+        .RxSize = size,
+    };
+    isotp_channels = channel;
+
+    critical_exit(primask);
+    return TRUE;
+  }
+}
+
+void isotp_close(struct ISOTPChannel *channel) {
+  if (channel == NULL) {
+    return;
+  } else {
+    const uint32_t primask = critical_enter();
+
+    for (struct ISOTPChannel **link = &isotp_channels; *link != NULL;
+         link = &(*link)->Next) {
+      if (*link == channel) {
+        *link = channel->Next;
+        break;
+      }
+    }
+    channel->Next = NULL;
+    channel->TxState = ISOTP_TX_IDLE;
+    channel->RxState = ISOTP_RX_IDLE;
+    channel->RxFlow = 0U;
+
+    critical_exit(primask);
+  }
+}
+
+_Bool isotp_send(struct ISOTPChannel *channel, const uint8_t *data,
+                 const uint16_t length) {
+  if ((channel == NULL) || (data == NULL)) {
+    return FALSE;
+  } else if ((length == 0U) || (length > ISOTP_MAX_LEN)) {
+    return FALSE;
+  } else {
+    const uint32_t primask = critical_enter();
+
+    if (channel->TxState != ISOTP_TX_IDLE) {
+      critical_exit(primask);
+      return FALSE;
+    }
+
+    channel->TxData = data;
+    channel->TxLength = length;
+    channel->TxOffset = 0U;
+    channel->TxState = (length <= ISOTP_SF_LEN) ? ISOTP_TX_SF : ISOTP_TX_FF;
+    const uint8_t events = isotp_service(channel);
+
+    critical_exit(primask);
+
+    isotp_report(channel, events);
+    return TRUE;
+  }
+}
+
+_Bool isotp_tx_busy(const struct ISOTPChannel *channel) {
+  if (channel == NULL) {
+    return FALSE;
+  } else {
+    return (channel->TxState != ISOTP_TX_IDLE);
+  }
+}
+
+void isotp_rx_frame(const bxcan_peripheral_t can,
+                    const struct bxCANFrame *frame) {
+  if (frame == NULL) {
+    return;
+  } else if (frame->RTR || (frame->DLC == 0U) || (frame->DLC > 8U)) {
+    return;
+  } else {
+    const uint32_t primask = critical_enter();
+
+    struct ISOTPChannel *channel = isotp_channels;
+    while ((channel != NULL) &&
+           ((channel->CAN != can) || (channel->Config.RxID != frame->ID) ||
+            (channel->Config.IDE != frame->IDE))) {
+      channel = channel->Next;
+    }
+
+    uint8_t events = 0U;
+    if (channel != NULL) {
+      events = isotp_rx_data(channel, frame);
+      events |= isotp_service(channel);
+    }
+
+    critical_exit(primask);
+
+    if (channel != NULL) {
+      isotp_report(channel, events);
+    }
+  }
+}
+
+void isotp_poll(const uint32_t now) {
+  isotp_time = now;
+
+  struct ISOTPChannel *channel = isotp_channels;
+  while (channel != NULL) {
+    const uint32_t primask = critical_enter();
+
+    uint8_t events = 0U;
+    if ((channel->TxState == ISOTP_TX_FC) && isotp_due(channel->TxTime)) {
+      channel->TxState = ISOTP_TX_IDLE;
+      events |= (uint8_t)BIT(ISOTP_TX_TIMEOUT);
+    }
+    if ((channel->RxState == ISOTP_RX_CF) && isotp_due(channel->RxTime)) {
+      channel->RxState = ISOTP_RX_IDLE;
+      channel->RxFlow = 0U;
+      events |= (uint8_t)BIT(ISOTP_RX_TIMEOUT);
+    }
+    events |= isotp_service(channel);
+
+    /* The callback may close the channel */
+    struct ISOTPChannel *next = channel->Next;
+    critical_exit(primask);
+
+    isotp_report(channel, events);
+    channel = next;
+  }
+}
@@ -0,0 +1,211 @@
+/** @file isotp.h
+ *  @brief Function prototypes for the ISO-TP transport layer.
+ *
+ *  This file contains all of the structs, enums, macros,
+ *  and function prototypes required for ISO 15765-2
+ *  (ISO-TP) transfers on top of the bxCAN driver.
+ *
+ *  Classic CAN with normal addressing: every channel sends
+ *  on one ID and listens on another, frames are padded to
+ *  8 bytes. Messages are segmented straight from the
+ *  caller buffer into the bxCAN transmit queue and
+ *  reassembled in place into a caller supplied buffer,
+ *  nothing is copied in between.
+ *
+ *  Timing is driven by isotp_poll(), called with a
+ *  microsecond timestamp (e.g. a free running 32-bit timer
+ *  at 1 MHz such as TIM2). Separation times, block sizes
+ *  and the N_Bs / N_Cr timeouts are checked there, so no
+ *  call ever busy waits. Their resolution is the poll
+ *  period.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef ISOTP_H
+#define ISOTP_H
+
+/* -- Includes -- */
+#include <stddef.h>
+#include <stdint.h>
+#include "defines.h"
+#include "bxcan.h"
+
+/* -- Defines -- */
+/** @brief Largest message with a 12-bit first frame length */
+#define ISOTP_MAX_LEN 4095U
+
+/** @brief Timeouts in microseconds */
+#define ISOTP_N_BS_US 1000000UL /**< Sender waiting for flow control */
+#define ISOTP_N_CR_US 1000000UL /**< Receiver waiting for a frame */
+
+/** @brief Flow control WAIT frames accepted in a row */
+#define ISOTP_WFT_MAX 8U
+
+/** @brief Value of the unused bytes of padded frames */
+#define ISOTP_PADDING 0xCCU
+
+/* -- Enums -- */
+/**
+ *  @brief Events reported through the channel callback
+ */
+typedef enum isotp_event {
+  ISOTP_TX_DONE = 0x00,     /**< Last frame queued for the bus */
+  ISOTP_RX_DONE = 0x01,     /**< Message complete in the buffer */
+  ISOTP_TX_TIMEOUT = 0x02,  /**< N_Bs expired */
+  ISOTP_TX_OVERFLOW = 0x03, /**< Receiver rejected the length */
+  ISOTP_TX_ERROR = 0x04,    /**< Invalid or too many WAIT frames */
+  ISOTP_RX_TIMEOUT = 0x05,  /**< N_Cr expired */
+  ISOTP_RX_OVERFLOW = 0x06, /**< Message larger than the buffer */
+  ISOTP_RX_SEQUENCE = 0x07  /**< Consecutive frame out of order */
+} isotp_event_t;
+
+/* -- Types -- */
+struct ISOTPChannel;
+
+/**
+ *  @brief Channel event callback
+ *
+ *  Called from isotp_rx_frame() or isotp_poll(). On
+ *  ISOTP_RX_DONE the message occupies the first RxLength
+ *  bytes of the receive buffer, which is reused by the
+ *  next message once the callback returns.
+ */
+typedef void (*isotp_callback_t)(struct ISOTPChannel *channel,
+                                 const isotp_event_t event, void *context);
+
+/**
+ *  @brief Contains the addressing and flow control setup
+ */
+struct __attribute__((packed)) ISOTPConfig {
+  uint32_t TxID;     /**< ID of the frames sent */
+  uint32_t RxID;     /**< ID of the frames received */
+  uint8_t BlockSize; /**< Frames per block we accept, 0 for all */
+  uint8_t STmin;     /**< Separation time we request, ISO coded */
+  _Bool IDE : 1;     /**< Extended (29-bit) IDs */
+};
+
+_Static_assert((sizeof(struct ISOTPConfig)) == (sizeof(uint8_t) * 11U),
+               "ISO-TP config struct size mismatch. Is it aligned?");
+
+/**
+ *  @brief Contains the state of an ISO-TP channel
+ *
+ *  Owned by the caller and linked into the channel list
+ *  by isotp_open(). Sending and receiving run
+ *  independently, so a channel is full duplex.
+ */
+struct ISOTPChannel {
+  struct ISOTPConfig Config;
+  bxcan_peripheral_t CAN;
+  isotp_callback_t Callback;
+  void *Context;
+  struct ISOTPChannel *Next;
+  /* --- Sender --- */
+  const uint8_t *TxData;
+  uint16_t TxLength;
+  uint16_t TxOffset; /**< Next byte to send */
+  uint32_t TxTime;   /**< Deadline or next frame time */
+  uint32_t TxSTmin;  /**< Receiver separation time in us */
+  uint8_t TxBlock;   /**< Receiver block size */
+  uint8_t TxLeft;    /**< Frames left in the block */
+  uint8_t TxSN;      /**< Next sequence number */
+  uint8_t TxWaits;   /**< WAIT frames in a row */
+  uint8_t TxState;
+  /* --- Receiver --- */
+  uint8_t *RxBuffer;
+  uint16_t RxSize;
+  uint16_t RxLength; /**< Announced message length */
+  uint16_t RxOffset; /**< Bytes received */
+  uint32_t RxTime;   /**< Deadline */
+  uint8_t RxLeft;    /**< Frames left before flow control */
+  uint8_t RxSN;      /**< Expected sequence number */
+  uint8_t RxFlow;    /**< Flow status waiting to be sent */
+  uint8_t RxState;
+};
+
+/**
+ * @brief Opens an ISO-TP channel.
+ *
+ * Links the channel into the list searched by
+ * isotp_rx_frame() and isotp_poll(). The receive buffer
+ * bounds the accepted message length. The transmit queue
+ * of the CAN must be started with bxcan_tx_queue_start().
+ *
+ * @param channel Caller owned channel state
+ * @param can The selected CAN
+ * @param config The addressing and flow control setup
+ * @param buffer Pointer to the receive buffer
+ * @param size The receive buffer size
+ * @param callback Event callback (may be NULL)
+ * @param context User pointer passed to the callback
+ * @return TRUE if opened, FALSE if invalid or open
+ */
+_Bool isotp_open(struct ISOTPChannel *channel, const bxcan_peripheral_t can,
+                 const struct ISOTPConfig config, uint8_t *buffer,
+                 const uint16_t size, const isotp_callback_t callback,
+                 void *context);
+
+/**
+ * @brief Closes an ISO-TP channel.
+ *
+ * Transfers in progress are dropped without a callback.
+ *
+ * @param channel The channel
+ * @return None
+ */
+void isotp_close(struct ISOTPChannel *channel);
+
+/**
+ * @brief Starts sending a message.
+ *
+ * Single frames are queued right away, longer messages
+ * continue from isotp_rx_frame() and isotp_poll(). The
+ * data must stay untouched until ISOTP_TX_DONE or an
+ * error is reported.
+ *
+ * @param channel The channel
+ * @param data Pointer to the message
+ * @param length The message length, 1 to ISOTP_MAX_LEN
+ * @return TRUE if started, FALSE if invalid or busy
+ */
+_Bool isotp_send(struct ISOTPChannel *channel, const uint8_t *data,
+                 const uint16_t length);
+
+/**
+ * @brief Returns whether a message is being sent.
+ *
+ * @param channel The channel
+ * @return TRUE while busy
+ */
+_Bool isotp_tx_busy(const struct ISOTPChannel *channel);
+
+/**
+ * @brief Feeds a received frame to the open channels.
+ *
+ * Fits bxcan_rx_handler_t, so it can be the Handler of
+ * the filter rules of the receive IDs. Frames of other
+ * IDs are ignored.
+ *
+ * @param can The CAN the frame came from
+ * @param frame Pointer to the frame
+ * @return None
+ */
+void isotp_rx_frame(const bxcan_peripheral_t can,
+                    const struct bxCANFrame *frame);
+
+/**
+ * @brief Advances the timers of the open channels.
+ *
+ * Sends the consecutive frames that are due, retries
+ * frames the transmit queue had no room for and reports
+ * timeouts. Call it periodically, the poll period bounds
+ * the STmin resolution.
+ *
+ * @param now Timestamp in microseconds, may wrap
+ * @return None
+ */
+void isotp_poll(const uint32_t now);
+
+#endif
@@ -9,8 +9,11 @@
  */
 
 /* -- Includes -- */
+#include <stddef.h>
 #include "spi.h"
 #include "defines.h"
+#include "critical.h"
+#include "exti.h"
 
 /**
  *  @brief SPI address look up table
@@ -39,6 +42,54 @@ static uint32_t SPI_LUT[] = {
     0UL, // Safety value
 };
 
+/**
+ *  @brief Contains the DMA streams of a SPI
+ */
+struct SPIDMARoute {
+  dma_peripheral_t DMA;
+  uint8_t RXStream;
+  uint8_t RXChannel;
+  uint8_t TXStream;
+  uint8_t TXChannel;
+};
+
+/**
+ *  @brief SPI DMA stream look up table
+ *
+ *  Same order as SPI_LUT, taken from the DMA request
+ *  mapping tables of the reference manual.
+ */
+static const struct SPIDMARoute SPI_DMA_LUT[] = {
+#ifdef SPI1_BASE
+    {DMA_PERIPH_2, 2U, 3U, 3U, 3U},
+#endif
+#ifdef SPI2_BASE
+    {DMA_PERIPH_1, 3U, 0U, 4U, 0U},
+#endif
+#ifdef SPI3_BASE
+    {DMA_PERIPH_1, 0U, 0U, 5U, 0U},
+#endif
+#ifdef SPI4_BASE
+    {DMA_PERIPH_2, 0U, 4U, 4U, 5U},
+#endif
+};
+
+/**
+ *  @brief Contains the DMA transfer state of a SPI
+ */
+struct SPIDMATransfer {
+  spi_dma_callback_t Callback;
+  void *Context;
+  spi_peripheral_t SPI;
+  volatile _Bool Busy;
+};
+
+static struct SPIDMATransfer spi_dma_transfers[SPI_PERIPH_LEN];
+
+/* Dummy source / sink of one-sided transfers */
+static const uint16_t spi_dma_dummy_tx = 0xFFFFU;
+static volatile uint16_t spi_dma_dummy_rx;
+
 static inline _Bool validateSPI(const spi_peripheral_t spi) {
   if (spi < SPI_PERIPH_LEN && spi >= 0U) {
     return TRUE;
@@ -194,6 +245,55 @@ void spi_configure_options(const spi_peripheral_t spi,
   }
 }
 
+struct SPIImage spi_build_image(const spi_prescaler_t div,
+                                const _Bool polarity, const _Bool phase,
+                                const struct SPIConfig config) {
+  struct SPIImage image = {0};
+
+  /* Make sure the divide value is valid */
+  if (div > SPI_PRESC_DIV256) {
+    return image;
+  }
+
+  image.CR1 = ((div << SPI_CR1_BR_Pos) | (polarity << SPI_CR1_CPOL_Pos) |
+               (phase << SPI_CR1_CPHA_Pos) | SPI_CR1_MSTR_Msk |
+               SPI_CR1_SSM_Msk | SPI_CR1_SSI_Msk |
+               (config.UseCRC << SPI_CR1_CRCEN_Pos) |
+               (config.Use16Bits << SPI_CR1_DFF_Pos) |
+               (config.LSBFirst << SPI_CR1_LSBFIRST_Pos));
+  image.CR2 = (config.TIMode << SPI_CR2_FRF_Pos);
+  image.CRCPoly = config.CRCPoly;
+
+  return image;
+}
+
+void spi_apply_image(const spi_peripheral_t spi, const struct SPIImage image) {
+  if (!validateSPI(spi)) {
+    return;
+  } else {
+    struct SPIRegs *regs = SPI(SPI_LUT[spi]);
+
+    /* Let the last frame finish before disabling */
+    if (regs->CR1 & SPI_CR1_SPE_Msk) {
+      while (regs->SR & SPI_SR_BSY_Msk) { ASM_NOP; }
+      regs->CR1 &= ~(SPI_CR1_SPE_Msk);
+    }
+
+    REG32 cr2 = regs->CR2;
+    cr2 &= ~(SPI_CR2_FRF_Msk | SPI_CR2_SSOE_Msk);
+    cr2 |= image.CR2;
+    regs->CR2 = cr2;
+
+    if (image.CRCPoly != 0U) {
+      regs->CRCPR = image.CRCPoly;
+    }
+
+    /* SSI first, a low internal NSS would fault the master */
+    regs->CR1 = image.CR1;
+    regs->CR1 = (image.CR1 | SPI_CR1_SPE_Msk);
+  }
+}
+
 void spi_tx_data(const spi_peripheral_t spi, const uint16_t data) {
   if (!validateSPI(spi)) {
     return;
@@ -234,6 +334,352 @@ uint16_t spi_trx_data(const spi_peripheral_t spi, const uint16_t data) {
   }
 }
 
+void spi_transfer_block(const spi_peripheral_t spi, const void *tx, void *rx,
+                        const uint16_t len) {
+  if (!validateSPI(spi)) {
+    return;
+  } else {
+    struct SPIRegs *regs = SPI(SPI_LUT[spi]);
+    const _Bool wide = ((regs->CR1 & SPI_CR1_DFF_Msk) != 0U);
+    const uint8_t *tx8 = (const uint8_t *)tx;
+    const uint16_t *tx16 = (const uint16_t *)tx;
+    uint8_t *rx8 = (uint8_t *)rx;
+    uint16_t *rx16 = (uint16_t *)rx;
+    uint16_t sent = 0U;
+    uint16_t received = 0U;
+
+    /* Drop a stale frame, it would shift the answers */
+    if (regs->SR & SPI_SR_RXNE_Msk) {
+      (void)regs->DR;
+    }
+
+    while (received < len) {
+      const uint32_t sr = regs->SR;
+
+      /* Drain first, it frees a slot for the next frame */
+      if ((sr & SPI_SR_RXNE_Msk) && (received < sent)) {
+        const uint16_t data = (uint16_t)(regs->DR & 0xFFFFUL);
+        if (rx16 == NULL) {
+          // Discard
+        } else if (wide) {
+          rx16[received] = data;
+        } else {
+          rx8[received] = (uint8_t)data;
+        }
+        received++;
+      }
+
+      /* Keep one frame queued behind the shift register */
+      if ((sr & SPI_SR_TXE_Msk) && (sent < len) &&
+          ((uint16_t)(sent - received) < 2U)) {
+        if (tx16 == NULL) {
+          regs->DR = 0xFFFFUL;
+        } else if (wide) {
+          regs->DR = tx16[sent];
+        } else {
+          regs->DR = tx8[sent];
+        }
+        sent++;
+      }
+    }
+  }
+}
+
+static spi_status_t spi_dma_check_crc(struct SPIRegs *regs,
+                                      const spi_status_t status) {
+  spi_status_t result = status;
+
+  /* The CRC frame follows the last data frame, DMA only
+   * counted the data. It is at most one frame away. */
+  if (result == SPI_STATUS_OK) {
+    while (!(regs->SR & SPI_SR_RXNE_Msk)) { ASM_NOP; }
+    (void)regs->DR;
+    while (regs->SR & SPI_SR_BSY_Msk) { ASM_NOP; }
+
+    if (regs->SR & SPI_SR_CRCERR_Msk) {
+      result = SPI_STATUS_CRC;
+    }
+  }
+  regs->SR &= ~(SPI_SR_CRCERR_Msk);
+
+  /* Clearing CRCEN resets both CRC registers, which is
+   * only allowed with the SPI disabled */
+  const uint32_t cr1 = regs->CR1;
+  regs->CR1 = (cr1 & ~(SPI_CR1_SPE_Msk));
+  regs->CR1 = (cr1 & ~(SPI_CR1_SPE_Msk | SPI_CR1_CRCEN_Msk));
+  regs->CR1 = (cr1 & ~(SPI_CR1_SPE_Msk));
+  regs->CR1 = cr1;
+
+  return result;
+}
+
+static void spi_dma_complete(const dma_peripheral_t dma, const uint8_t stream,
+                             const struct DMAStreamISR flags, void *context) {
+  struct SPIDMATransfer *transfer = (struct SPIDMATransfer *)context;
+  const struct SPIDMARoute route = SPI_DMA_LUT[transfer->SPI];
+  (void)dma;
+
+  /* RX TC means every frame has been shifted in */
+  if (flags.TEI) {
+    dma_disable(route.DMA, route.RXStream);
+    dma_disable(route.DMA, route.TXStream);
+  } else if (!(flags.TCI && (stream == route.RXStream))) {
+    return;
+  }
+
+  struct SPIRegs *regs = SPI(SPI_LUT[transfer->SPI]);
+  regs->CR2 &= ~(SPI_CR2_TXDMAEN_Msk | SPI_CR2_RXDMAEN_Msk);
+
+  spi_status_t status = flags.TEI ? SPI_STATUS_ERROR : SPI_STATUS_OK;
+  if (regs->CR1 & SPI_CR1_CRCEN_Msk) {
+    status = spi_dma_check_crc(regs, status);
+  }
+
+  transfer->Busy = FALSE;
+  if (transfer->Callback != NULL) {
+    transfer->Callback(transfer->SPI, status, transfer->Context);
+  }
+}
+
+uint32_t spi_get_data_address(const spi_peripheral_t spi) {
+  if (!validateSPI(spi)) {
+    return 0UL;
+  } else {
+    struct SPIRegs *regs = SPI(SPI_LUT[spi]);
+    return (uint32_t)(uintptr_t)&regs->DR;
+  }
+}
+
+_Bool spi_dma_claim(const spi_peripheral_t spi) {
+  if (!validateSPI(spi)) {
+    return FALSE;
+  } else {
+    struct SPIDMATransfer *transfer = &spi_dma_transfers[spi];
+
+    const uint32_t primask = critical_enter();
+    const _Bool busy = transfer->Busy;
+    transfer->Busy = TRUE;
+    critical_exit(primask);
+
+    return (busy == FALSE);
+  }
+}
+
+void spi_dma_release(const spi_peripheral_t spi) {
+  if (!validateSPI(spi)) {
+    return;
+  } else {
+    spi_dma_transfers[spi].Busy = FALSE;
+  }
+}
+
+_Bool spi_transfer_dma(const spi_peripheral_t spi, const void *tx, void *rx,
+                       const uint16_t len, const spi_dma_callback_t callback,
+                       void *context) {
+  if (!validateSPI(spi)) {
+    return FALSE;
+  } else if (len == 0U) {
+    return FALSE;
+  } else {
+    struct SPIDMATransfer *transfer = &spi_dma_transfers[spi];
+    const struct SPIDMARoute route = SPI_DMA_LUT[spi];
+    struct SPIRegs *regs = SPI(SPI_LUT[spi]);
+
+    if (!spi_dma_claim(spi)) {
+      return FALSE;
+    }
+
+    transfer->Callback = callback;
+    transfer->Context = context;
+    transfer->SPI = spi;
+
+    /* Frame size follows DFF */
+    const dma_datasize_t size =
+        (regs->CR1 & SPI_CR1_DFF_Msk) ? DMA_DATASIZE_HWRD : DMA_DATASIZE_BYTE;
+    const struct DMAStreamConfig rx_config = {.MemIncrement = (rx != NULL)};
+    const struct DMAStreamConfig tx_config = {.MemIncrement = (tx != NULL)};
+    const struct DMAStreamISR rx_isr = {.TCI = TRUE, .TEI = TRUE};
+    const struct DMAStreamISR tx_isr = {.TEI = TRUE};
+    const uint32_t dr = (uint32_t)(uintptr_t)&regs->DR;
+    const void *rx_mem = (rx != NULL) ? rx : (void *)&spi_dma_dummy_rx;
+    const void *tx_mem = (tx != NULL) ? tx : (const void *)&spi_dma_dummy_tx;
+
+    /* Receive stream, completes the transfer */
+    dma_disable(route.DMA, route.RXStream);
+    dma_set_channel(route.DMA, route.RXStream, route.RXChannel,
+                    DMA_PRIORITY_VHI);
+    dma_set_direction(route.DMA, route.RXStream, DMA_DIR_PER2MEM);
+    dma_configure_stream(route.DMA, route.RXStream, rx_config);
+    dma_set_interrupts(route.DMA, route.RXStream, rx_isr);
+    dma_set_callback(route.DMA, route.RXStream, spi_dma_complete, transfer);
+    dma_set_addresses(route.DMA, route.RXStream, dr,
+                      (uint32_t)(uintptr_t)rx_mem, 0U);
+    dma_configure_data(route.DMA, route.RXStream, len, size, size);
+
+    /* Transmit stream, only reports errors */
+    dma_disable(route.DMA, route.TXStream);
+    dma_set_channel(route.DMA, route.TXStream, route.TXChannel,
+                    DMA_PRIORITY_HIG);
+    dma_set_direction(route.DMA, route.TXStream, DMA_DIR_MEM2PER);
+    dma_configure_stream(route.DMA, route.TXStream, tx_config);
+    dma_set_interrupts(route.DMA, route.TXStream, tx_isr);
+    dma_set_callback(route.DMA, route.TXStream, spi_dma_complete, transfer);
+    dma_set_addresses(route.DMA, route.TXStream, dr,
+                      (uint32_t)(uintptr_t)tx_mem, 0U);
+    dma_configure_data(route.DMA, route.TXStream, len, size, size);
+
+    /* Enable order from the reference manual: RX requests,
+     * both streams, then TX requests start the clock */
+    regs->CR2 |= SPI_CR2_RXDMAEN_Msk;
+    dma_enable(route.DMA, route.RXStream);
+    dma_enable(route.DMA, route.TXStream);
+    regs->CR2 |= SPI_CR2_TXDMAEN_Msk;
+
+    return TRUE;
+  }
+}
+
+_Bool spi_transfer_dma_busy(const spi_peripheral_t spi) {
+  if (!validateSPI(spi)) {
+    return FALSE;
+  } else {
+    return spi_dma_transfers[spi].Busy;
+  }
+}
+
+static void spi_slave_nss(const uint8_t line, void *context) {
+  struct SPISlaveStream *stream = (struct SPISlaveStream *)context;
+  const struct SPIDMARoute route = SPI_DMA_LUT[stream->SPI];
+  (void)line;
+
+  /* The last frame has been moved long before the edge
+   * interrupt runs, NDTR tells where the frame ends */
+  uint16_t head =
+      (uint16_t)(stream->Size - dma_get_count(route.DMA, route.RXStream));
+  if (head >= stream->Size) {
+    head = 0U;
+  }
+
+  const uint16_t tail = stream->Tail;
+  const uint16_t length =
+      (uint16_t)((head >= tail) ? (head - tail) : (stream->Size - tail + head));
+  stream->Tail = head;
+
+  if ((length != 0U) && (stream->Callback != NULL)) {
+    stream->Callback(stream, tail, length, stream->Context);
+  }
+}
+
+static void spi_slave_error(const dma_peripheral_t dma, const uint8_t stream,
+                            const struct DMAStreamISR flags, void *context) {
+  (void)dma;
+  (void)stream;
+
+  /* The stream stops itself on errors, only count them */
+  if (flags.TEI) {
+    ((struct SPISlaveStream *)context)->Errors++;
+  }
+}
+
+_Bool spi_slave_stream_start(struct SPISlaveStream *stream,
+                             const spi_peripheral_t spi, void *rx,
+                             const uint16_t rx_len, const void *tx,
+                             const uint16_t tx_len, const gp_bank_t nss_bank,
+                             const uint8_t nss_pin,
+                             const spi_slave_callback_t callback,
+                             void *context) {
+  if (!validateSPI(spi)) {
+    return FALSE;
+  } else if ((stream == NULL) || (rx == NULL) || (rx_len == 0U)) {
+    return FALSE;
+  } else if ((tx != NULL) && (tx_len == 0U)) {
+    return FALSE;
+  } else {
+    const struct SPIDMARoute route = SPI_DMA_LUT[spi];
+    struct SPIRegs *regs = SPI(SPI_LUT[spi]);
+
+    /* Claim the SPI DMA for the whole stream */
+    if (!spi_dma_claim(spi)) {
+      return FALSE;
+    }
+
+    stream->Callback = callback;
+    stream->Context = context;
+    stream->Size = rx_len;
+    stream->Tail = 0U;
+    stream->Errors = 0U;
+    stream->SPI = spi;
+    stream->NSSPin = nss_pin;
+
+    /* Frame size follows DFF */
+    const dma_datasize_t size =
+        (regs->CR1 & SPI_CR1_DFF_Msk) ? DMA_DATASIZE_HWRD : DMA_DATASIZE_BYTE;
+    const struct DMAStreamConfig config = {.Circular = TRUE,
+                                           .MemIncrement = TRUE};
+    const struct DMAStreamISR isr = {.TEI = TRUE};
+    const uint32_t dr = (uint32_t)(uintptr_t)&regs->DR;
+
+    /* Receive ring */
+    dma_disable(route.DMA, route.RXStream);
+    dma_set_channel(route.DMA, route.RXStream, route.RXChannel,
+                    DMA_PRIORITY_VHI);
+    dma_set_direction(route.DMA, route.RXStream, DMA_DIR_PER2MEM);
+    dma_configure_stream(route.DMA, route.RXStream, config);
+    dma_set_interrupts(route.DMA, route.RXStream, isr);
+    dma_set_callback(route.DMA, route.RXStream, spi_slave_error, stream);
+    dma_set_addresses(route.DMA, route.RXStream, dr, (uint32_t)(uintptr_t)rx,
+                      0U);
+    dma_configure_data(route.DMA, route.RXStream, rx_len, size, size);
+
+    /* Response data, repeated */
+    if (tx != NULL) {
+      dma_disable(route.DMA, route.TXStream);
+      dma_set_channel(route.DMA, route.TXStream, route.TXChannel,
+                      DMA_PRIORITY_HIG);
+      dma_set_direction(route.DMA, route.TXStream, DMA_DIR_MEM2PER);
+      dma_configure_stream(route.DMA, route.TXStream, config);
+      dma_set_interrupts(route.DMA, route.TXStream, isr);
+      dma_set_callback(route.DMA, route.TXStream, spi_slave_error, stream);
+      dma_set_addresses(route.DMA, route.TXStream, dr,
+                        (uint32_t)(uintptr_t)tx, 0U);
+      dma_configure_data(route.DMA, route.TXStream, tx_len, size, size);
+    }
+
+    /* Drop a stale frame, then arm the frame delimiter */
+    (void)regs->DR;
+    exti_configure(nss_bank, nss_pin, TRUE, FALSE, spi_slave_nss, stream);
+
+    regs->CR2 |= SPI_CR2_RXDMAEN_Msk;
+    dma_enable(route.DMA, route.RXStream);
+    if (tx != NULL) {
+      dma_enable(route.DMA, route.TXStream);
+      regs->CR2 |= SPI_CR2_TXDMAEN_Msk;
+    }
+
+    return TRUE;
+  }
+}
+
+void spi_slave_stream_stop(struct SPISlaveStream *stream) {
+  if (stream == NULL) {
+    return;
+  } else if (!validateSPI(stream->SPI)) {
+    return;
+  } else {
+    const struct SPIDMARoute route = SPI_DMA_LUT[stream->SPI];
+    struct SPIRegs *regs = SPI(SPI_LUT[stream->SPI]);
+
+    exti_disable(stream->NSSPin);
+    regs->CR2 &= ~(SPI_CR2_TXDMAEN_Msk | SPI_CR2_RXDMAEN_Msk);
+    dma_disable(route.DMA, route.RXStream);
+    dma_disable(route.DMA, route.TXStream);
+    dma_set_callback(route.DMA, route.RXStream, NULL, NULL);
+    dma_set_callback(route.DMA, route.TXStream, NULL, NULL);
+
+    spi_dma_release(stream->SPI);
+  }
+}
+
 void spi_start(const spi_peripheral_t spi, const _Bool master) {
   if (!validateSPI(spi)) {
     return;
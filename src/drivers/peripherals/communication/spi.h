@@ -12,10 +12,15 @@
  *  @bug None, yet.
  */
 
+#ifndef SPI_H
+#define SPI_H
+
 /* -- Includes -- */
 #include <stdint.h>
 #include "stm32f4xx.h"
 #include "defines.h"
+#include "dma.h"
+#include "gpio.h"
 
 /* -- Structs -- */
 /**
@@ -36,7 +41,11 @@ struct __attribute__((packed)) SPIRegs {
 _Static_assert((sizeof(struct SPIRegs)) == (sizeof(uint32_t) * 9U),
                "SPI Register struct size mismatch. Is it aligned?");
 
-#define SPI(ADDR) (struct SPIRegs *)(ADDR);
+#ifndef UTEST
+#define SPI(ADDR) (struct SPIRegs *)(ADDR)
+#else
+extern struct SPIRegs *SPI(const uint32_t base);
+#endif
 
 /**
  *  @brief Contains SPI interrupt configuration
@@ -66,6 +75,19 @@ struct __attribute__((packed)) SPIConfig {
 _Static_assert((sizeof(struct SPIConfig)) == (sizeof(uint8_t) * 3U),
                "SPI Config struct size mismatch. Is it aligned?");
 
+/**
+ *  @brief Contains a precomputed SPI register image
+ *
+ *  Built once by spi_build_image() and written as a whole
+ *  by spi_apply_image(), for buses shared by devices with
+ *  different settings.
+ */
+struct SPIImage {
+  uint32_t CR1;
+  uint32_t CR2;
+  uint16_t CRCPoly; /**< Zero is ignored */
+};
+
 /* -- Enums -- */
 /**
  *  @brief Available SPI peripherals
@@ -126,6 +148,53 @@ typedef enum spi_prescaler {
   SPI_PRESC_DIV256
 } spi_prescaler_t;
 
+/**
+ *  @brief Available SPI transfer results
+ */
+typedef enum spi_status {
+  SPI_STATUS_OK = 0x0,
+  SPI_STATUS_ERROR, /**< DMA transfer error */
+  SPI_STATUS_CRC    /**< Received CRC mismatch */
+} spi_status_t;
+
+/**
+ *  @brief SPI DMA transfer completion callback
+ *
+ *  Called from the DMA interrupt once the last frame has
+ *  been received, the buffers may be reused from here on.
+ */
+typedef void (*spi_dma_callback_t)(const spi_peripheral_t spi,
+                                   const spi_status_t status, void *context);
+
+struct SPISlaveStream;
+
+/**
+ *  @brief SPI slave frame callback
+ *
+ *  Called from the EXTI interrupt on every NSS rising
+ *  edge that ends a non-empty frame. Frame item i is
+ *  located at rx[(offset + i) % size] of the receive ring
+ *  and stays valid until the ring wraps over it.
+ */
+typedef void (*spi_slave_callback_t)(struct SPISlaveStream *stream,
+                                     const uint16_t offset,
+                                     const uint16_t length, void *context);
+
+/**
+ *  @brief Contains the state of a SPI slave stream
+ *
+ *  Owned by the caller while the stream is running.
+ */
+struct SPISlaveStream {
+  spi_slave_callback_t Callback;
+  void *Context;
+  uint16_t Size; /**< Receive ring length in frames */
+  uint16_t Tail; /**< Start of the current frame */
+  uint32_t Errors;
+  spi_peripheral_t SPI;
+  uint8_t NSSPin;
+};
+
 /**
  *  @brief Enables specified SPI interrupts
  *
@@ -206,6 +275,39 @@ void spi_set_dma(const spi_peripheral_t spi, const _Bool forTX,
 void spi_configure_options(const spi_peripheral_t spi,
                            const struct SPIConfig config);
 
+/**
+ *  @brief Builds a master register image
+ *
+ *  The image holds a full-duplex master with software NSS
+ *  and the given clock and frame options, the same
+ *  settings spi_configure_clk(), spi_configure_options()
+ *  and spi_start() would produce one by one. An invalid
+ *  prescaler results in an empty image.
+ *
+ *  @param div The prescale divider
+ *  @param polarity The default state of the clock
+ *  @param phase Capture data on first or second pulse
+ *  @param config The SPI configuration
+ *  @return The register image
+ */
+struct SPIImage spi_build_image(const spi_prescaler_t div,
+                                const _Bool polarity, const _Bool phase,
+                                const struct SPIConfig config);
+
+/**
+ *  @brief Programs a register image and enables the SPI
+ *
+ *  Waits for the bus to go idle and disables the SPI while
+ *  CR1, CR2 and the CRC polynomial are rewritten, as the
+ *  frame format can't change while it is enabled. The
+ *  interrupt and DMA enable bits of CR2 are kept.
+ *
+ *  @param spi The selected SPI
+ *  @param image The register image
+ *  @return None
+ */
+void spi_apply_image(const spi_peripheral_t spi, const struct SPIImage image);
+
 /**
  *  @brief Transmits specified SPI data
  *
@@ -243,6 +345,164 @@ uint16_t spi_rx_data(const spi_peripheral_t spi);
  */
 uint16_t spi_trx_data(const spi_peripheral_t spi, const uint16_t data);
 
+/**
+ *  @brief Runs a full-duplex SPI block transfer by polling
+ *
+ *  Unlike a spi_trx_data() loop, which waits for every
+ *  frame to come back before sending the next one, the
+ *  next frame is written as soon as TXE is set, so the TX
+ *  buffer is always loaded one frame ahead of the shift
+ *  register and SCK runs without gaps between frames. At
+ *  most two frames are in flight, so RX can't overrun as
+ *  long as the loop keeps up with the bus. At DIV2 this
+ *  leaves 16 bus clocks per 8-bit frame, keep interrupts
+ *  short or masked there.
+ *
+ *  The frame size follows the DFF setting, the buffers
+ *  hold len bytes or len half-words. Either buffer may be
+ *  NULL: a NULL tx clocks out 0xFF(FF), a NULL rx discards
+ *  the received frames. The SPI has to be configured and
+ *  started as a full-duplex master by the caller.
+ *
+ *  @param spi The selected SPI
+ *  @param tx Pointer to the data to send (may be NULL)
+ *  @param rx Pointer to the receive buffer (may be NULL)
+ *  @param len The number of frames
+ *  @return None
+ */
+void spi_transfer_block(const spi_peripheral_t spi, const void *tx, void *rx,
+                        const uint16_t len);
+
+/**
+ *  @brief Returns the data register address of a SPI
+ *
+ *  For DMA streams set up outside of spi_transfer_dma().
+ *
+ *  @param spi The selected SPI
+ *  @return The address of DR, 0 if invalid
+ */
+uint32_t spi_get_data_address(const spi_peripheral_t spi);
+
+/**
+ *  @brief Claims the DMA streams of a SPI
+ *
+ *  For DMA users outside of spi_transfer_dma(), which
+ *  fails while the SPI is claimed. Claimed SPIs show up
+ *  as busy in spi_transfer_dma_busy().
+ *
+ *  @param spi The selected SPI
+ *  @return TRUE if claimed, FALSE if invalid or busy
+ */
+_Bool spi_dma_claim(const spi_peripheral_t spi);
+
+/**
+ *  @brief Releases the DMA streams claimed by spi_dma_claim()
+ *
+ *  @param spi The selected SPI
+ *  @return None
+ */
+void spi_dma_release(const spi_peripheral_t spi);
+
+/**
+ *  @brief Runs a full-duplex SPI transfer through DMA
+ *
+ *  Arms the RX and TX DMA streams of the SPI as a pair and
+ *  returns right away, the callback reports the end of the
+ *  transfer. The frame size follows the DFF setting, so
+ *  the buffers hold len bytes or len half-words. Either
+ *  buffer may be NULL: TX-only transfers discard the
+ *  received frames into a dummy sink, RX-only transfers
+ *  clock out 0xFF(FF) from a dummy source, both without
+ *  memory increment. The SPI has to be configured and
+ *  started by the caller, CS is left to the caller too.
+ *
+ *  With CRCEN set the hardware sends the TX CRC right
+ *  after the last frame, len counts the data frames only.
+ *  The received CRC frame is not part of the RX DMA count,
+ *  so the completion interrupt spins for up to one more
+ *  frame until it arrives and BSY clears. Only then the
+ *  CRC is checked, a mismatch is reported as
+ *  SPI_STATUS_CRC, the CRC unit is reset by toggling
+ *  CRCEN with the SPI disabled, and the callback runs.
+ *  At slow prescalers that spin delays other interrupts
+ *  of the same or lower priority.
+ *
+ *  The streams used are fixed: SPI1 DMA2 S2/S3, SPI2 DMA1
+ *  S3/S4, SPI3 DMA1 S0/S5 and SPI4 DMA2 S0/S4 (RX/TX).
+ *  SPI2 and SPI3 share their DMA1 streams with the USART
+ *  DMA routes of USART3/UART4 and USART2/UART5, only one
+ *  owner may use a stream at a time.
+ *
+ *  @param spi The selected SPI
+ *  @param tx Pointer to the data to send (may be NULL)
+ *  @param rx Pointer to the receive buffer (may be NULL)
+ *  @param len The number of frames (1..65535)
+ *  @param callback Completion callback (may be NULL)
+ *  @param context User pointer passed to the callback
+ *  @return TRUE if started, FALSE if invalid or busy
+ */
+_Bool spi_transfer_dma(const spi_peripheral_t spi, const void *tx, void *rx,
+                       const uint16_t len, const spi_dma_callback_t callback,
+                       void *context);
+
+/**
+ *  @brief Checks whether a SPI DMA transfer is running
+ *
+ *  @param spi The selected SPI
+ *  @return TRUE until the transfer completes
+ */
+_Bool spi_transfer_dma_busy(const spi_peripheral_t spi);
+
+/**
+ *  @brief Streams SPI slave data through circular DMA
+ *
+ *  The RX DMA stream keeps filling the receive ring, so
+ *  the master can send at full SCK rate without any
+ *  software per frame. NSS rising edges are caught through
+ *  the EXTI line of the NSS pin and delimit the frames
+ *  reported to the callback. Frames longer than the ring
+ *  can't be told apart from short ones and are lost.
+ *
+ *  If tx is given, the TX DMA stream loops over it in
+ *  circular mode as the response data, otherwise MISO
+ *  repeats the last value. The SPI has to be configured as
+ *  a slave with hardware NSS (pin in AF mode) by the
+ *  caller and started before or after this call. SYSCFG
+ *  has to be clocked for the EXTI routing. The SPI DMA
+ *  streams are claimed until the stream is stopped, see
+ *  spi_transfer_dma() for the routes.
+ *
+ *  @param stream Caller owned stream state
+ *  @param spi The selected SPI
+ *  @param rx Pointer to the receive ring
+ *  @param rx_len The receive ring length in frames
+ *  @param tx Pointer to the response data (may be NULL)
+ *  @param tx_len The response data length in frames
+ *  @param nss_bank The GPIO bank of the NSS pin
+ *  @param nss_pin The NSS pin
+ *  @param callback Frame callback
+ *  @param context User pointer passed to the callback
+ *  @return TRUE if started, FALSE if invalid or busy
+ */
+_Bool spi_slave_stream_start(struct SPISlaveStream *stream,
+                             const spi_peripheral_t spi, void *rx,
+                             const uint16_t rx_len, const void *tx,
+                             const uint16_t tx_len, const gp_bank_t nss_bank,
+                             const uint8_t nss_pin,
+                             const spi_slave_callback_t callback,
+                             void *context);
+
+/**
+ *  @brief Stops a SPI slave stream
+ *
+ *  A frame in progress is dropped, the DMA streams are
+ *  released.
+ *
+ *  @param stream The stream state
+ *  @return None
+ */
+void spi_slave_stream_stop(struct SPISlaveStream *stream);
+
 /**
  *  @brief Initiates the SPI peripheral with specified options.
  *
@@ -259,3 +519,5 @@ void spi_start(const spi_peripheral_t spi, const _Bool master);
  *  @return None
  */
 void spi_stop(const spi_peripheral_t spi);
+
+#endif
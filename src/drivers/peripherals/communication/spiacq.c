@@ -0,0 +1,181 @@
+/** @file spiacq.c
+ *  @brief Function defines for the SPI ADC acquisition chain.
+ *
+ *  This file contains all of the function definitions
+ *  declared in spiacq.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include <stddef.h>
+#include "spiacq.h"
+#include "dma.h"
+
+/* Fixed resources of the chain */
+#define SPIACQ_DMA        DMA_PERIPH_2
+#define SPIACQ_RX_STREAM  0U
+#define SPIACQ_RX_CHANNEL 3U
+#define SPIACQ_TR_STREAM  2U
+#define SPIACQ_TR_CHANNEL 6U
+
+/**
+ *  @brief Contains the acquisition state
+ */
+struct SPIAcq {
+  spiacq_callback_t Callback;
+  void *Context;
+  uint16_t *Blocks;
+  uint16_t Length;
+  volatile uint32_t Count;
+  _Bool Running;
+};
+
+static struct SPIAcq spiacq = {0};
+
+/* Clocked out for every sample, the ADC ignores MOSI */
+static const uint16_t spiacq_dummy = 0xFFFFU;
+
+static void spiacq_event(const dma_peripheral_t dma, const uint8_t stream,
+                         const struct DMAStreamISR flags, void *context) {
+  (void)context;
+
+  if (flags.TEI) {
+    spiacq_stop();
+    if (spiacq.Callback != NULL) {
+      spiacq.Callback(NULL, 0U, SPI_STATUS_ERROR, spiacq.Context);
+    }
+  } else if (flags.TCI && (stream == SPIACQ_RX_STREAM)) {
+    /* The stream already moved on to the other block */
+    const uint16_t *block = (dma_get_target(dma, stream) == 1U)
+                                ? spiacq.Blocks
+                                : &spiacq.Blocks[spiacq.Length];
+    spiacq.Count++;
+    if (spiacq.Callback != NULL) {
+      spiacq.Callback(block, spiacq.Length, SPI_STATUS_OK, spiacq.Context);
+    }
+  }
+}
+
+_Bool spiacq_start(const struct SPIAcqConfig *config, uint16_t *blocks,
+                   const uint16_t length, const spiacq_callback_t callback,
+                   void *context) {
+  if ((config == NULL) || (blocks == NULL) || (length == 0U)) {
+    return FALSE;
+  } else if (spiacq.Running == TRUE) {
+    return FALSE;
+  }
+
+  const uint32_t clock = tim_get_clock(TIM_PERIPH_1);
+  if ((config->Rate == 0U) || (config->Rate > (clock / 2U))) {
+    return FALSE;
+  }
+
+  /* Fit the period in the 16-bit counter */
+  const uint32_t period = (clock / config->Rate);
+  const uint32_t prescaler = ((period - 1U) / 0x10000UL);
+  const uint32_t tick_hz = (clock / (prescaler + 1U));
+  const uint32_t reload = ((period / (prescaler + 1U)) - 1U);
+  const uint32_t pulse =
+      (uint32_t)(((uint64_t)config->PulseNs * tick_hz) / 1000000000ULL);
+  const uint32_t read =
+      (uint32_t)(((uint64_t)config->ReadNs * tick_hz) / 1000000000ULL);
+  if ((pulse > reload) || (read > reload)) {
+    return FALSE;
+  }
+
+  /* Keep spi_transfer_dma() away from the streams */
+  if (!spi_dma_claim(SPI_PERIPH_1)) {
+    return FALSE;
+  }
+#ifdef SPI4_BASE
+  if (!spi_dma_claim(SPI_PERIPH_4)) {
+    spi_dma_release(SPI_PERIPH_1);
+    return FALSE;
+  }
+#endif
+
+  spiacq.Callback = callback;
+  spiacq.Context = context;
+  spiacq.Blocks = blocks;
+  spiacq.Length = length;
+  spiacq.Count = 0U;
+  spiacq.Running = TRUE;
+
+  /* Time base, pulse and read trigger */
+  tim_stop(TIM_PERIPH_1);
+  tim_configure_base(TIM_PERIPH_1, (uint16_t)prescaler, reload);
+  tim_configure_pwm(TIM_PERIPH_1, TIM_CHANNEL_1, pulse, config->InvertPulse);
+  tim_set_compare(TIM_PERIPH_1, TIM_CHANNEL_2, read);
+
+  const uint32_t dr = spi_get_data_address(SPI_PERIPH_1);
+  const struct DMAStreamISR isr_rx = {.TCI = TRUE, .TEI = TRUE};
+  const struct DMAStreamISR isr_tr = {.TEI = TRUE};
+
+  /* Sample storage, the hardware swaps the two blocks */
+  const struct DMAStreamConfig rx_config = {
+      .Circular = TRUE, .DoubleBuffer = TRUE, .MemIncrement = TRUE};
+  dma_disable(SPIACQ_DMA, SPIACQ_RX_STREAM);
+  dma_set_channel(SPIACQ_DMA, SPIACQ_RX_STREAM, SPIACQ_RX_CHANNEL,
+                  DMA_PRIORITY_VHI);
+  dma_set_direction(SPIACQ_DMA, SPIACQ_RX_STREAM, DMA_DIR_PER2MEM);
+  dma_configure_stream(SPIACQ_DMA, SPIACQ_RX_STREAM, rx_config);
+  dma_set_interrupts(SPIACQ_DMA, SPIACQ_RX_STREAM, isr_rx);
+  dma_set_callback(SPIACQ_DMA, SPIACQ_RX_STREAM, spiacq_event, NULL);
+  dma_set_addresses(SPIACQ_DMA, SPIACQ_RX_STREAM, dr,
+                    (uint32_t)(uintptr_t)blocks,
+                    (uint32_t)(uintptr_t)&blocks[length]);
+  dma_configure_data(SPIACQ_DMA, SPIACQ_RX_STREAM, length, DMA_DATASIZE_HWRD,
+                     DMA_DATASIZE_HWRD);
+
+  /* Read trigger, one dummy frame per compare event */
+  const struct DMAStreamConfig tr_config = {.Circular = TRUE};
+  dma_disable(SPIACQ_DMA, SPIACQ_TR_STREAM);
+  dma_set_channel(SPIACQ_DMA, SPIACQ_TR_STREAM, SPIACQ_TR_CHANNEL,
+                  DMA_PRIORITY_HIG);
+  dma_set_direction(SPIACQ_DMA, SPIACQ_TR_STREAM, DMA_DIR_MEM2PER);
+  dma_configure_stream(SPIACQ_DMA, SPIACQ_TR_STREAM, tr_config);
+  dma_set_interrupts(SPIACQ_DMA, SPIACQ_TR_STREAM, isr_tr);
+  dma_set_callback(SPIACQ_DMA, SPIACQ_TR_STREAM, spiacq_event, NULL);
+  dma_set_addresses(SPIACQ_DMA, SPIACQ_TR_STREAM, dr,
+                    (uint32_t)(uintptr_t)&spiacq_dummy, 0U);
+  dma_configure_data(SPIACQ_DMA, SPIACQ_TR_STREAM, 1U, DMA_DATASIZE_HWRD,
+                     DMA_DATASIZE_HWRD);
+
+  /* Receive side first, the timer starts the chain */
+  spi_set_dma(SPI_PERIPH_1, FALSE, TRUE);
+  dma_enable(SPIACQ_DMA, SPIACQ_RX_STREAM);
+  dma_enable(SPIACQ_DMA, SPIACQ_TR_STREAM);
+
+  const struct TIMDMARequests requests = {.CC2 = TRUE};
+  tim_set_dma(TIM_PERIPH_1, requests);
+  tim_start(TIM_PERIPH_1);
+
+  return TRUE;
+}
+
+void spiacq_stop(void) {
+  const struct TIMDMARequests none = {0};
+
+  /* The streams may belong to spi_transfer_dma() now */
+  if (spiacq.Running == FALSE) {
+    return;
+  }
+
+  tim_stop(TIM_PERIPH_1);
+  tim_set_dma(TIM_PERIPH_1, none);
+  dma_disable(SPIACQ_DMA, SPIACQ_TR_STREAM);
+  dma_disable(SPIACQ_DMA, SPIACQ_RX_STREAM);
+  dma_set_callback(SPIACQ_DMA, SPIACQ_TR_STREAM, NULL, NULL);
+  dma_set_callback(SPIACQ_DMA, SPIACQ_RX_STREAM, NULL, NULL);
+  spi_set_dma(SPI_PERIPH_1, FALSE, FALSE);
+
+  spiacq.Running = FALSE;
+  spi_dma_release(SPI_PERIPH_1);
+#ifdef SPI4_BASE
+  spi_dma_release(SPI_PERIPH_4);
+#endif
+}
+
+uint32_t spiacq_blocks(void) { return spiacq.Count; }
@@ -0,0 +1,97 @@
+/** @file spiacq.h
+ *  @brief Function prototypes for the SPI ADC acquisition chain.
+ *
+ *  This file contains all of the structs and function
+ *  prototypes required to sample an external SPI ADC at a
+ *  fixed rate without per-sample software.
+ *
+ *  Every sample period TIM1 drives the CS/CONVST pulse on
+ *  channel 1 (PA8, AF1) and its channel 2 compare raises
+ *  a DMA request (DMA2 S2 ch6) that writes a dummy frame
+ *  to SPI1 DR, which clocks one sample in. The SPI1 RX
+ *  DMA stream (DMA2 S0 ch3) stores the samples in double
+ *  buffer mode and swaps the two blocks in hardware, the
+ *  callback gets each block once it is full.
+ *
+ *  DMA2 S0 is also the SPI4 RX route of spi_transfer_dma()
+ *  and S2 the SPI1 one. Both SPIs are claimed through
+ *  spi_dma_claim() while running, so spi_transfer_dma()
+ *  refuses them, and starting fails if either is busy.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef SPIACQ_H
+#define SPIACQ_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "defines.h"
+#include "spi.h"
+#include "tim.h"
+
+/* -- Structs -- */
+/**
+ *  @brief Contains the acquisition timing
+ *
+ *  Times are measured from the start of every sample
+ *  period and rounded down to timer ticks.
+ */
+struct SPIAcqConfig {
+  uint32_t Rate;     /**< Samples per second */
+  uint32_t PulseNs;  /**< Width of the CS/CONVST pulse */
+  uint32_t ReadNs;   /**< Start of the SPI read */
+  _Bool InvertPulse; /**< Active low pulse */
+};
+
+/**
+ *  @brief Acquisition block callback
+ *
+ *  Called from the DMA interrupt once a block is full.
+ *  The block is overwritten again after one more block
+ *  time, it has to be consumed or copied by then. On
+ *  SPI_STATUS_ERROR the chain has been stopped and block
+ *  is NULL.
+ */
+typedef void (*spiacq_callback_t)(const uint16_t *block, const uint16_t length,
+                                  const spi_status_t status, void *context);
+
+/**
+ * @brief Starts the acquisition chain.
+ *
+ * SPI1 has to be configured as a 16-bit master and
+ * started, TIM1, SPI1, DMA2 and the pins have to be
+ * clocked and set up by the caller. The read has to
+ * start after the pulse if the ADC needs the conversion
+ * time, and the frame has to fit in the period.
+ *
+ * @param config The acquisition timing
+ * @param blocks Storage for two blocks (2 * length samples)
+ * @param length The samples per block
+ * @param callback Block callback
+ * @param context User pointer passed to the callback
+ * @return TRUE if started, FALSE if invalid or busy
+ */
+_Bool spiacq_start(const struct SPIAcqConfig *config, uint16_t *blocks,
+                   const uint16_t length, const spiacq_callback_t callback,
+                   void *context);
+
+/**
+ * @brief Stops the acquisition chain.
+ *
+ * The block being filled is dropped. Does nothing if the
+ * chain is not running.
+ *
+ * @return None
+ */
+void spiacq_stop(void);
+
+/**
+ * @brief Returns the number of blocks delivered.
+ *
+ * @return Block count since the last start
+ */
+uint32_t spiacq_blocks(void);
+
+#endif
@@ -0,0 +1,165 @@
+/** @file spibus.c
+ *  @brief Function defines for the shared SPI bus manager.
+ *
+ *  This file contains all of the function definitions
+ *  declared in spibus.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include <stddef.h>
+#include "spibus.h"
+#include "critical.h"
+
+static void spibus_run(struct SPIBus *bus);
+
+static void spibus_deselect(struct SPIBus *bus) {
+  if (bus->Selected != NULL) {
+    gp_set_val(bus->Selected->CSBank, bus->Selected->CSPin, TRUE);
+    bus->Selected = NULL;
+  }
+}
+
+static struct SPITransaction *spibus_pop(struct SPIBus *bus) {
+  const uint32_t primask = critical_enter();
+  struct SPITransaction *done = bus->Head;
+  bus->Head = done->Next;
+  if (bus->Head == NULL) {
+    bus->Tail = NULL;
+  }
+  done->Next = NULL;
+  critical_exit(primask);
+
+  return done;
+}
+
+static void spibus_finish(struct SPIBus *bus, const spi_status_t status) {
+  struct SPITransaction *done = spibus_pop(bus);
+  if ((done->KeepCS == FALSE) || (status != SPI_STATUS_OK)) {
+    spibus_deselect(bus);
+  }
+
+  if (done->Callback != NULL) {
+    done->Callback(done, status, done->Context);
+  }
+}
+
+static void spibus_complete(const spi_peripheral_t spi,
+                            const spi_status_t status, void *context) {
+  struct SPIBus *bus = (struct SPIBus *)context;
+  (void)spi;
+
+  spibus_finish(bus, status);
+  spibus_run(bus);
+}
+
+static void spibus_run(struct SPIBus *bus) {
+  while (TRUE) {
+    /* Going idle must be atomic with the emptiness check,
+     * otherwise a submitter could miss the kick */
+    const uint32_t primask = critical_enter();
+    struct SPITransaction *next = bus->Head;
+    if (next == NULL) {
+      bus->Busy = FALSE;
+    }
+    critical_exit(primask);
+    if (next == NULL) {
+      return;
+    }
+
+    struct SPIDevice *device = next->Device;
+    if (bus->Selected != device) {
+      spibus_deselect(bus);
+    }
+
+    /* Only reprogram on device switches */
+    if (bus->Current != device) {
+      spi_apply_image(bus->SPI, device->Image);
+      bus->Current = device;
+    }
+
+    gp_set_val(device->CSBank, device->CSPin, FALSE);
+    bus->Selected = device;
+
+    if (spi_transfer_dma(bus->SPI, next->TX, next->RX, next->Length,
+                         spibus_complete, bus)) {
+      return;
+    }
+
+    /* DMA claimed by someone else, fail this one only */
+    spibus_finish(bus, SPI_STATUS_ERROR);
+  }
+}
+
+void spibus_device_init(struct SPIDevice *device, const spi_prescaler_t div,
+                        const _Bool polarity, const _Bool phase,
+                        const struct SPIConfig config, const gp_bank_t bank,
+                        const uint8_t pin) {
+  if (device == NULL) {
+    return;
+  } else {
+    device->Image = spi_build_image(div, polarity, phase, config);
+    device->CSBank = bank;
+    device->CSPin = pin;
+
+    /* Deselected until the first transaction */
+    gp_set_val(bank, pin, TRUE);
+    gp_set_output_type(bank, pin, GP_OTYPE_PP);
+    gp_set_direction(bank, pin, GP_DIR_OU);
+  }
+}
+
+void spibus_init(struct SPIBus *bus, const spi_peripheral_t spi) {
+  if (bus == NULL) {
+    return;
+  } else {
+    bus->Head = NULL;
+    bus->Tail = NULL;
+    bus->Current = NULL;
+    bus->Selected = NULL;
+    bus->SPI = spi;
+    bus->Busy = FALSE;
+  }
+}
+
+_Bool spibus_submit(struct SPIBus *bus, struct SPITransaction *transaction) {
+  if ((bus == NULL) || (transaction == NULL)) {
+    return FALSE;
+  } else if ((transaction->Device == NULL) || (transaction->Length == 0U)) {
+    return FALSE;
+  } else if (bus->SPI >= SPI_PERIPH_LEN) {
+    return FALSE;
+  } else {
+    transaction->Next = NULL;
+
+    const uint32_t primask = critical_enter();
+    if (bus->Tail == NULL) {
+      bus->Head = transaction;
+    } else {
+      bus->Tail->Next = transaction;
+    }
+    bus->Tail = transaction;
+
+    const _Bool kick = (bus->Busy == FALSE);
+    bus->Busy = TRUE;
+    critical_exit(primask);
+
+    /* Only an idle bus is started here, the completion
+     * interrupt picks up the rest */
+    if (kick) {
+      spibus_run(bus);
+    }
+
+    return TRUE;
+  }
+}
+
+_Bool spibus_busy(const struct SPIBus *bus) {
+  if (bus == NULL) {
+    return FALSE;
+  } else {
+    return bus->Busy;
+  }
+}
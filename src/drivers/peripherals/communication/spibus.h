@@ -0,0 +1,134 @@
+/** @file spibus.h
+ *  @brief Function prototypes for the shared SPI bus manager.
+ *
+ *  This file contains all of the structs and function
+ *  prototypes required to share a SPI between several
+ *  devices.
+ *
+ *  Every device is described once by a profile holding a
+ *  precomputed register image and its CS pin. Transfers
+ *  are queued on the bus as caller owned transactions and
+ *  run back to back through the SPI DMA, the completion
+ *  interrupt releases CS, reports the result and starts
+ *  the next transaction. The registers are only rewritten
+ *  when the device changes between two transactions.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef SPIBUS_H
+#define SPIBUS_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "defines.h"
+#include "gpio.h"
+#include "spi.h"
+
+/* -- Structs -- */
+/**
+ *  @brief Contains the profile of a SPI device
+ */
+struct SPIDevice {
+  struct SPIImage Image;
+  gp_bank_t CSBank;
+  uint8_t CSPin;
+};
+
+struct SPITransaction;
+
+/**
+ *  @brief SPI transaction completion callback
+ *
+ *  Called from the DMA interrupt after CS has been
+ *  handled, the transaction may be resubmitted from here.
+ */
+typedef void (*spibus_callback_t)(struct SPITransaction *transaction,
+                                  const spi_status_t status, void *context);
+
+/**
+ *  @brief Contains a queued SPI transfer
+ *
+ *  Owned by the caller and busy until the callback fires.
+ *  Buffers follow the frame size of the device, see
+ *  spi_transfer_dma().
+ */
+struct SPITransaction {
+  struct SPIDevice *Device;
+  const void *TX; /**< May be NULL */
+  void *RX;       /**< May be NULL */
+  uint16_t Length;
+  _Bool KeepCS; /**< Leave CS low for the next transaction */
+  spibus_callback_t Callback;
+  void *Context;
+  struct SPITransaction *Next;
+};
+
+/**
+ *  @brief Contains the state of a shared SPI
+ */
+struct SPIBus {
+  struct SPITransaction *Head;
+  struct SPITransaction *Tail;
+  struct SPIDevice *Current;  /**< Device of the active image */
+  struct SPIDevice *Selected; /**< Device holding CS low */
+  spi_peripheral_t SPI;
+  volatile _Bool Busy;
+};
+
+/**
+ * @brief Prepares a device profile and its CS pin.
+ *
+ * CS is configured as a push-pull output and driven high.
+ * The GPIO clock has to be enabled by the caller.
+ *
+ * @param device The device profile
+ * @param div The prescale divider
+ * @param polarity The default state of the clock
+ * @param phase Capture data on first or second pulse
+ * @param config The frame and CRC options
+ * @param bank The GPIO bank of the CS pin
+ * @param pin The CS pin
+ * @return None
+ */
+void spibus_device_init(struct SPIDevice *device, const spi_prescaler_t div,
+                        const _Bool polarity, const _Bool phase,
+                        const struct SPIConfig config, const gp_bank_t bank,
+                        const uint8_t pin);
+
+/**
+ * @brief Prepares a bus on top of a SPI.
+ *
+ * The SPI pins and clock have to be set up by the caller,
+ * the SPI itself is configured by the first transaction.
+ *
+ * @param bus The bus state
+ * @param spi The selected SPI
+ * @return None
+ */
+void spibus_init(struct SPIBus *bus, const spi_peripheral_t spi);
+
+/**
+ * @brief Queues a transaction on the bus.
+ *
+ * Starts it right away if the bus is idle. A transaction
+ * with KeepCS set keeps its device selected until a
+ * transaction without it completes, other devices
+ * release it when they take over the bus.
+ *
+ * @param bus The bus state
+ * @param transaction The transaction, filled in
+ * @return TRUE if queued, FALSE if invalid
+ */
+_Bool spibus_submit(struct SPIBus *bus, struct SPITransaction *transaction);
+
+/**
+ * @brief Checks whether the bus has queued work.
+ *
+ * @param bus The bus state
+ * @return TRUE until the queue is empty
+ */
+_Bool spibus_busy(const struct SPIBus *bus);
+
+#endif
@@ -0,0 +1,130 @@
+/** @file tlog.c
+ *  @brief Function defines for the tokenized logger.
+ *
+ *  This file contains all of the function definitions
+ *  declared in tlog.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include <stddef.h>
+#include "tlog.h"
+#include "critical.h"
+
+/**
+ *  @brief Contains the log ring state
+ *
+ *  Head and Tail are free running word counters, the ring
+ *  index is their value modulo TLOG_RING_LEN. Writers
+ *  advance Head, the DMA completion advances Tail.
+ */
+struct TLogRing {
+  uint32_t Ring[TLOG_RING_LEN];
+  volatile uint32_t Head;
+  volatile uint32_t Tail;
+  uint32_t Dropped;
+  usart_peripheral_t USART;
+  _Bool Ready; /**< A USART has been selected */
+  _Bool Busy;  /**< A chunk is queued for DMA */
+};
+
+static struct TLogRing tlog = {0};
+
+static void tlog_drain(void);
+
+static void tlog_sent(const usart_peripheral_t usart, const uint8_t *buffer,
+                      const uint16_t length, const _Bool error,
+                      void *context) {
+  (void)usart;
+  (void)buffer;
+  (void)error;
+  (void)context;
+
+  /* Errors lose the chunk either way, move on */
+  tlog.Tail += (length / sizeof(uint32_t));
+  tlog_drain();
+}
+
+static void tlog_drain(void) {
+  const uint32_t primask = critical_enter();
+  const uint32_t tail = tlog.Tail;
+  const uint32_t pending = (tlog.Head - tail);
+
+  /* Going idle must be atomic with the emptiness check,
+   * otherwise a writer could miss the kick */
+  if (pending == 0U) {
+    tlog.Busy = FALSE;
+    critical_exit(primask);
+    return;
+  }
+  critical_exit(primask);
+
+  /* Send up to the end of the ring, the rest follows */
+  const uint32_t index = (tail & (TLOG_RING_LEN - 1U));
+  uint32_t words = (TLOG_RING_LEN - index);
+  if (pending < words) {
+    words = pending;
+  }
+
+  if (!usart_tx_dma(tlog.USART, (const uint8_t *)&tlog.Ring[index],
+                    (uint16_t)(words * sizeof(uint32_t)), tlog_sent, NULL)) {
+    /* Queue full, the next record retries */
+    tlog.Busy = FALSE;
+  }
+}
+
+void tlog_init(const usart_peripheral_t usart) {
+  const uint32_t primask = critical_enter();
+  const _Bool kick = ((tlog.Busy == FALSE) && (tlog.Head != tlog.Tail));
+  tlog.USART = usart;
+  tlog.Ready = TRUE;
+  tlog.Busy = (tlog.Busy || kick);
+  critical_exit(primask);
+
+  if (kick) {
+    tlog_drain();
+  }
+}
+
+void tlog_write(const uint32_t *words, const uint8_t nargs) {
+  if (words == NULL) {
+    return;
+  } else if (nargs > TLOG_MAX_ARGS) {
+    return;
+  } else {
+    const uint32_t count = (nargs + 1U);
+    _Bool kick = FALSE;
+
+    const uint32_t primask = critical_enter();
+    uint32_t head = tlog.Head;
+
+    if ((TLOG_RING_LEN - (head - tlog.Tail)) < count) {
+      tlog.Dropped++;
+    } else {
+      /* Header first, then the raw arguments */
+      tlog.Ring[head++ & (TLOG_RING_LEN - 1U)] =
+          (TLOG_SYNC | ((uint32_t)nargs << TLOG_ARGS_Pos) |
+           (words[0] & TLOG_ID_Msk));
+      for (uint32_t i = 1U; i < count; i++) {
+        tlog.Ring[head++ & (TLOG_RING_LEN - 1U)] = words[i];
+      }
+      tlog.Head = head;
+
+      kick = ((tlog.Ready == TRUE) && (tlog.Busy == FALSE));
+      tlog.Busy = (tlog.Busy || kick);
+    }
+    critical_exit(primask);
+
+    /* Only the first record of a burst starts the DMA,
+     * the completion callback picks up the rest */
+    if (kick) {
+      tlog_drain();
+    }
+  }
+}
+
+uint32_t tlog_pending(void) { return (tlog.Head - tlog.Tail); }
+
+uint32_t tlog_dropped(void) { return tlog.Dropped; }
@@ -0,0 +1,140 @@
+/** @file tlog.h
+ *  @brief Function prototypes for the tokenized logger.
+ *
+ *  This file contains all of the macros and function
+ *  prototypes required for deferred binary logging over
+ *  a USART.
+ *
+ *  A log call does not format anything on the target. The
+ *  format string is placed in the non-loaded .tlog section
+ *  and only its address (the ID) plus the raw argument
+ *  words are copied into a RAM ring. The ring is drained
+ *  in the background through the USART DMA transmit queue
+ *  and tools/tlog_decode.py turns the records back into
+ *  text using the ELF file.
+ *
+ *  Record layout (little endian 32-bit words):
+ *  | 31..28 | 27..24 | 23..0  |
+ *  |  SYNC  | NARGS  |   ID   |  followed by NARGS words.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef TLOG_H
+#define TLOG_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "defines.h"
+#include "usart.h"
+
+/* -- Defines -- */
+/** @brief Ring size in words, must be a power of two */
+#define TLOG_RING_LEN 256U
+
+_Static_assert(((TLOG_RING_LEN & (TLOG_RING_LEN - 1U)) == 0U),
+               "TLOG ring length must be a power of two.");
+
+/** @brief Maximum number of arguments per record */
+#define TLOG_MAX_ARGS 8U
+
+/** @brief Marker in the top nibble of every header */
+#define TLOG_SYNC     0xA0000000UL
+#define TLOG_ID_Msk   0x00FFFFFFUL
+#define TLOG_ARGS_Pos (24U)
+
+/* Argument counting, the format string is not counted */
+#define TLOG_ARGC_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define TLOG_ARGC(...) TLOG_ARGC_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+
+/* Format string and the remaining arguments */
+#define TLOG_FIRST_(first, ...) first
+#define TLOG_FIRST(...)         TLOG_FIRST_(__VA_ARGS__, 0)
+#define TLOG_REST_ONE(first)
+#define TLOG_REST_MORE(first, ...) , __VA_ARGS__
+#define TLOG_REST_SEL(...)                                                     \
+  TLOG_ARGC_(__VA_ARGS__, MORE, MORE, MORE, MORE, MORE, MORE, MORE, MORE, ONE, \
+             0)
+#define TLOG_REST_(sel, ...) TLOG_REST_##sel(__VA_ARGS__)
+#define TLOG_REST__(sel, ...) TLOG_REST_(sel, __VA_ARGS__)
+#define TLOG_REST(...)                                                         \
+  TLOG_REST__(TLOG_REST_SEL(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ *  @brief Logs a printf-like message.
+ *
+ *  Usage: TLOG("adc %u out of range (%d)\n", channel, value);
+ *
+ *  The format must be a string literal. Up to 8 integer
+ *  arguments are stored as 32-bit words, floats have to
+ *  be wrapped in tlog_float() and are decoded through
+ *  %f / %e / %g. Safe to call from interrupts. Records
+ *  that don't fit in the ring are dropped as a whole.
+ */
+#define TLOG(...)                                                              \
+  do {                                                                         \
+    _Static_assert(TLOG_ARGC(__VA_ARGS__) <= TLOG_MAX_ARGS,                    \
+                   "Too many TLOG arguments.");                                \
+    static const char tlog_fmt_[]                                              \
+        __attribute__((section(".tlog"), used)) = TLOG_FIRST(__VA_ARGS__);     \
+    const uint32_t tlog_words_[] = {                                           \
+        (uint32_t)(uintptr_t)tlog_fmt_ TLOG_REST(__VA_ARGS__)};                \
+    tlog_write(tlog_words_, (uint8_t)TLOG_ARGC(__VA_ARGS__));                  \
+  } while (0)
+
+/**
+ * @brief Reinterprets a float as a TLOG argument word.
+ *
+ * @param value The float to log
+ * @return The raw IEEE-754 bits
+ */
+static inline uint32_t tlog_float(const float value) {
+  union {
+    float F;
+    uint32_t U;
+  } word = {.F = value};
+
+  return word.U;
+}
+
+/**
+ * @brief Selects the USART the log records are sent to.
+ *
+ * The USART has to be started in transmit mode by the
+ * caller. The transmit DMA queue is shared, other
+ * usart_tx_dma() users may interleave whole buffers.
+ * Records logged before the call are kept and sent.
+ *
+ * @param usart The selected USART
+ * @return None
+ */
+void tlog_init(const usart_peripheral_t usart);
+
+/**
+ * @brief Stores a record into the log ring.
+ *
+ * Used by the TLOG() macro, words[0] holds the format
+ * string address and words[1..nargs] the arguments.
+ *
+ * @param words Pointer to the record words
+ * @param nargs The number of arguments
+ * @return None
+ */
+void tlog_write(const uint32_t *words, const uint8_t nargs);
+
+/**
+ * @brief Returns the number of words not yet sent.
+ *
+ * @return Pending words in the ring
+ */
+uint32_t tlog_pending(void);
+
+/**
+ * @brief Returns the number of records lost to a full ring.
+ *
+ * @return Dropped record count
+ */
+uint32_t tlog_dropped(void);
+
+#endif
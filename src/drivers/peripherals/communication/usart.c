@@ -9,7 +9,10 @@
  */
 
 /* -- Includes -- */
+#include <stddef.h>
 #include "usart.h"
+#include "critical.h"
+#include "isr.h"
 
 /** @brief USART address look up table
  *
@@ -37,6 +40,180 @@ static uint32_t USART_LUT[] = {
 #endif
 };
 
+#define USART_COUNT (sizeof(USART_LUT) / sizeof(USART_LUT[0]))
+
+/** @brief USART kernel clock look up table
+ *
+ * Same order as USART_LUT.
+ */
+static const uint32_t USART_CLK_LUT[] = {
+#ifdef USART1_BASE
+    USART_APB2_HZ,
+#endif
+#ifdef USART2_BASE
+    USART_APB1_HZ,
+#endif
+#ifdef USART3_BASE
+    USART_APB1_HZ,
+#endif
+#ifdef USART6_BASE
+    USART_APB2_HZ,
+#endif
+#ifdef UART4_BASE
+    USART_APB1_HZ,
+#endif
+#ifdef UART5_BASE
+    USART_APB1_HZ
+#endif
+};
+
+/**
+ *  @brief Contains a fixed DMA request route
+ */
+struct USARTDMARoute {
+  dma_peripheral_t DMA;
+  uint8_t Stream;
+  uint8_t Channel;
+};
+
+/** @brief USART TX DMA stream look up table
+ *
+ * Same order as USART_LUT, taken from the DMA request
+ * mapping tables of the reference manual.
+ */
+static const struct USARTDMARoute USART_TX_DMA_LUT[] = {
+#ifdef USART1_BASE
+    {DMA_PERIPH_2, 7U, 4U},
+#endif
+#ifdef USART2_BASE
+    {DMA_PERIPH_1, 6U, 4U},
+#endif
+#ifdef USART3_BASE
+    {DMA_PERIPH_1, 3U, 4U},
+#endif
+#ifdef USART6_BASE
+    {DMA_PERIPH_2, 6U, 5U},
+#endif
+#ifdef UART4_BASE
+    {DMA_PERIPH_1, 4U, 4U},
+#endif
+#ifdef UART5_BASE
+    {DMA_PERIPH_1, 7U, 4U}
+#endif
+};
+
+/** @brief USART RX DMA stream look up table
+ *
+ * Same order as USART_LUT.
+ */
+static const struct USARTDMARoute USART_RX_DMA_LUT[] = {
+#ifdef USART1_BASE
+    {DMA_PERIPH_2, 5U, 4U},
+#endif
+#ifdef USART2_BASE
+    {DMA_PERIPH_1, 5U, 4U},
+#endif
+#ifdef USART3_BASE
+    {DMA_PERIPH_1, 1U, 4U},
+#endif
+#ifdef USART6_BASE
+    {DMA_PERIPH_2, 1U, 5U},
+#endif
+#ifdef UART4_BASE
+    {DMA_PERIPH_1, 2U, 4U},
+#endif
+#ifdef UART5_BASE
+    {DMA_PERIPH_1, 0U, 4U}
+#endif
+};
+
+/** @brief USART interrupt look up table
+ *
+ * Same order as USART_LUT.
+ */
+static const IRQn_Type USART_IRQ_LUT[] = {
+#ifdef USART1_BASE
+    USART1_IRQn,
+#endif
+#ifdef USART2_BASE
+    USART2_IRQn,
+#endif
+#ifdef USART3_BASE
+    USART3_IRQn,
+#endif
+#ifdef USART6_BASE
+    USART6_IRQn,
+#endif
+#ifdef UART4_BASE
+    UART4_IRQn,
+#endif
+#ifdef UART5_BASE
+    UART5_IRQn
+#endif
+};
+
+/**
+ *  @brief Contains a queued DMA transmission
+ */
+struct USARTDMADescriptor {
+  const uint8_t *Buffer;
+  usart_dma_callback_t Callback;
+  void *Context;
+  uint16_t Length;
+};
+
+/**
+ *  @brief Contains the DMA transmit queue of a USART
+ *
+ *  Head is only moved by usart_tx_dma() and Tail only by
+ *  the DMA interrupt.
+ */
+struct USARTTxQueue {
+  struct USARTDMADescriptor Slots[USART_DMA_QUEUE_LEN];
+  volatile uint8_t Head;
+  volatile uint8_t Tail;
+  volatile _Bool Active;
+  usart_peripheral_t USART;
+};
+
+static struct USARTTxQueue usart_tx_queues[USART_COUNT];
+
+/**
+ *  @brief Contains the DMA receive ring state of a USART
+ *
+ *  Only touched from the DMA and USART interrupts, which
+ *  both run at USART_RX_IRQ_PRIORITY and never preempt
+ *  each other.
+ */
+struct USARTRxRing {
+  uint8_t *Ring;
+  usart_rx_frame_callback_t Callback;
+  void *Context;
+  uint32_t Length;  /**< Bytes in the current frame */
+  uint32_t Dropped; /**< Frames longer than the ring */
+  uint32_t Pending; /**< Bytes not yet released */
+  uint16_t Size;
+  uint16_t Start;    /**< Ring offset of the current frame */
+  uint16_t Position; /**< Last seen DMA write offset */
+  uint16_t High;     /**< RTS pause watermark */
+  uint16_t Low;      /**< RTS resume watermark */
+  usart_peripheral_t USART;
+  gp_bank_t RTSBank;
+  uint8_t RTSPin;
+  _Bool RTS;     /**< Software RTS in use */
+  _Bool RTSHeld; /**< Remote is paused */
+};
+
+static struct USARTRxRing usart_rx_rings[USART_COUNT];
+
+/**
+ *  @brief Registered USART interrupt callbacks
+ */
+static struct {
+  usart_callback_t Callback;
+  void *Context;
+} usart_handlers[USART_COUNT];
+
 static inline _Bool verifyUSART(const usart_peripheral_t usart) {
   switch (usart) {
 #ifdef USART1_BASE
@@ -65,18 +242,69 @@ static inline _Bool verifyUSART(const usart_peripheral_t usart) {
   return TRUE;
 }
 
+static inline _Bool hasFlowControl(const usart_peripheral_t usart) {
+  switch (usart) {
+#ifdef USART1_BASE
+    case USART_PERIPH_1:
+#endif
+#ifdef USART2_BASE
+    case USART_PERIPH_2:
+#endif
+#ifdef USART3_BASE
+    case USART_PERIPH_3:
+#endif
+#ifdef USART6_BASE
+    case USART_PERIPH_6:
+#endif
+      break;
+
+    default: return FALSE;
+  };
+
+  return TRUE;
+}
+
+struct USARTBaudConfig usart_calc_baud(const usart_peripheral_t usart,
+                                       const uint32_t baudrate) {
+  struct USARTBaudConfig config = {0};
+
+  if (!verifyUSART(usart)) {
+    return config;
+  } else if (baudrate == 0U) {
+    return config;
+  } else {
+    const uint32_t clk = USART_CLK_LUT[usart];
+
+    if (USART_BAUD_VALID(clk, baudrate)) {
+      config.BRR = (uint16_t)USART_BAUD_BRR(clk, baudrate);
+      config.Over8 = USART_BAUD_OVER8(clk, baudrate);
+      config.Actual = USART_BAUD_ACTUAL(clk, baudrate);
+      config.ErrorPPM = USART_BAUD_ERROR_PPM(clk, baudrate);
+    }
+
+    return config;
+  }
+}
+
 void usart_start(const usart_peripheral_t usart, const uint32_t baudrate,
                  const usart_mode_t mode) {
+  const struct USARTBaudConfig baud = usart_calc_baud(usart, baudrate);
+
   if (!verifyUSART(usart)) {
     return;
+  } else if (baud.Actual == 0U) {
+    return;
   } else {
     struct USARTRegs *regs = USART(USART_LUT[usart]);
 
-    /* Calculate USART div accurately */
-    regs->BRR = ((APB1_CLK * 1000000) / baudrate);
+    /* Oversampling must be set before the divider */
+    REG32 cr1 = regs->CR1;
+    cr1 &= ~(USART_CR1_OVER8_Msk); // Clear first
+    cr1 |= ((1UL & baud.Over8) << USART_CR1_OVER8_Pos);
+    regs->CR1 = cr1;
+    regs->BRR = baud.BRR;
 
     /* Setup communication modes */
-    REG32 cr1 = regs->CR1;
     cr1 &= ~(USART_CR1_TE_Msk | USART_CR1_RE_Msk); // Clear first
     if (mode == USART_MODE_TX) {
       cr1 |= USART_CR1_TE_Msk;
@@ -142,6 +370,19 @@ void usart_set_interrupts(const usart_peripheral_t usart,
   }
 }
 
+void usart_set_callback(const usart_peripheral_t usart,
+                        const usart_callback_t callback, void *context) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else {
+    /* Keep the handler away while swapping the callback */
+    NVIC_DisableIRQ(USART_IRQ_LUT[usart]);
+    usart_handlers[usart].Callback = callback;
+    usart_handlers[usart].Context = context;
+    NVIC_EnableIRQ(USART_IRQ_LUT[usart]);
+  }
+}
+
 void usart_set_databits(const usart_peripheral_t usart,
                         const usart_stopbits_t stopbits,
                         const usart_databits_t databits) {
@@ -217,6 +458,85 @@ inline static void usart_tx_byte(struct USARTRegs *regs, const char character) {
   regs->DR = character;
 }
 
+void usart_set_mute_mode(const usart_peripheral_t usart,
+                         const usart_wakeup_t wakeup, const uint8_t address) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else if ((wakeup != USART_WAKEUP_IDLE) && (wakeup != USART_WAKEUP_ADDR)) {
+    return;
+  } else if (address > USART_ADDRESS_MAX) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+
+    /* Set the node address */
+    REG32 cr2 = regs->CR2;
+    cr2 &= ~(USART_CR2_ADD_Msk); // Clear first
+    cr2 |= (address << USART_CR2_ADD_Pos);
+
+    regs->CR2 = cr2;
+
+    /* Set the wakeup method */
+    REG32 cr1 = regs->CR1;
+    cr1 &= ~(USART_CR1_WAKE_Msk); // Clear first
+    cr1 |= (wakeup << USART_CR1_WAKE_Pos);
+
+    regs->CR1 = cr1;
+  }
+}
+
+void usart_mute(const usart_peripheral_t usart) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+    regs->CR1 |= USART_CR1_RWU_Msk;
+  }
+}
+
+_Bool usart_is_muted(const usart_peripheral_t usart) {
+  if (!verifyUSART(usart)) {
+    return FALSE;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+    return ((regs->CR1 & USART_CR1_RWU_Msk) != 0U);
+  }
+}
+
+void usart_tx_address(const usart_peripheral_t usart, const uint8_t address) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else if (address > USART_ADDRESS_MAX) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+
+    /* The mark is the MSB of the frame */
+    const uint32_t mark =
+        (regs->CR1 & USART_CR1_M_Msk) ? USART_ADDRESS_MARK9 : 0x80U;
+
+    while (!(regs->SR & USART_SR_TXE_Msk)) { ASM_NOP; };
+    regs->DR = (mark | address);
+  }
+}
+
+void usart_set_flow_control(const usart_peripheral_t usart, const _Bool rts,
+                            const _Bool cts) {
+  if (!hasFlowControl(usart)) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+
+    /* Set the flow control lines */
+    REG32 cr3 = regs->CR3;
+    cr3 &= ~(USART_CR3_RTSE_Msk | USART_CR3_CTSE_Msk); // Clear first
+    cr3 |= (((1UL & rts) << USART_CR3_RTSE_Pos) |
+            ((1UL & cts) << USART_CR3_CTSE_Pos));
+
+    regs->CR3 = cr3;
+  }
+}
+
 void usart_tx_message(const usart_peripheral_t usart, const char *message) {
   if (!verifyUSART(usart)) {
     return;
@@ -231,6 +551,382 @@ void usart_tx_message(const usart_peripheral_t usart, const char *message) {
   }
 }
 
+void usart_write(const usart_peripheral_t usart, const uint8_t *buf,
+                 const size_t len) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else if (buf == NULL) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+    const uint8_t *end = (buf + len);
+
+    /* Only TXE gates the next byte, TC is left alone */
+    while (buf != end) {
+      while (!(regs->SR & USART_SR_TXE_Msk)) { ASM_NOP; };
+      regs->DR = *buf++;
+    }
+  }
+}
+
+size_t usart_read(const usart_peripheral_t usart, uint8_t *buf,
+                  const size_t len, const uint32_t timeout_ticks,
+                  struct USARTErrors *errors) {
+  if (!verifyUSART(usart)) {
+    return 0U;
+  } else if (buf == NULL) {
+    return 0U;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+    const uint32_t start = ticks;
+    uint32_t flags = 0U;
+    size_t count = 0U;
+
+    while (count < len) {
+      const uint32_t sr = regs->SR;
+
+      /* The SR read above plus the DR read clear the errors */
+      if (sr & USART_SR_RXNE_Msk) {
+        flags |= sr;
+        buf[count++] = (uint8_t)regs->DR;
+      } else if ((ticks - start) >= timeout_ticks) {
+        break; // Wraparound safe
+      }
+    }
+
+    if (errors != NULL) {
+      errors->Overrun = ((flags & USART_SR_ORE_Msk) != 0U);
+      errors->Framing = ((flags & USART_SR_FE_Msk) != 0U);
+      errors->Noise = ((flags & USART_SR_NE_Msk) != 0U);
+      errors->Parity = ((flags & USART_SR_PE_Msk) != 0U);
+    }
+
+    return count;
+  }
+}
+
+void usart_flush(const usart_peripheral_t usart) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+
+    /* Wait for transmission complete flag */
+    while (!(regs->SR & USART_SR_TC_Msk)) { ASM_NOP; };
+  }
+}
+
+static void usart_tx_dma_complete(const dma_peripheral_t dma,
+                                  const uint8_t stream,
+                                  const struct DMAStreamISR flags,
+                                  void *context);
+
+static void usart_tx_dma_start(struct USARTTxQueue *queue) {
+  const struct USARTDMADescriptor *desc = &queue->Slots[queue->Tail];
+  const struct USARTDMARoute route = USART_TX_DMA_LUT[queue->USART];
+  struct USARTRegs *regs = USART(USART_LUT[queue->USART]);
+
+  /* Point the stream at the next caller buffer */
+  dma_set_addresses(route.DMA, route.Stream, (uint32_t)(uintptr_t)&regs->DR,
+                    (uint32_t)(uintptr_t)desc->Buffer, 0U);
+  dma_configure_data(route.DMA, route.Stream, desc->Length, DMA_DATASIZE_BYTE,
+                     DMA_DATASIZE_BYTE);
+
+  /* TC is rc_w0, writing ones elsewhere leaves them be */
+  regs->SR = (uint32_t)~(USART_SR_TC_Msk);
+  dma_enable(route.DMA, route.Stream);
+}
+
+static void usart_tx_dma_setup(const usart_peripheral_t usart) {
+  const struct USARTDMARoute route = USART_TX_DMA_LUT[usart];
+  const struct DMAStreamConfig config = {.MemIncrement = TRUE};
+  const struct DMAStreamISR isr = {.TCI = TRUE, .TEI = TRUE};
+
+  /* The stream may still be owned by someone else */
+  dma_disable(route.DMA, route.Stream);
+  dma_set_channel(route.DMA, route.Stream, route.Channel, DMA_PRIORITY_MED);
+  dma_set_direction(route.DMA, route.Stream, DMA_DIR_MEM2PER);
+  dma_configure_stream(route.DMA, route.Stream, config);
+  dma_set_interrupts(route.DMA, route.Stream, isr);
+  dma_set_callback(route.DMA, route.Stream, usart_tx_dma_complete,
+                   &usart_tx_queues[usart]);
+
+  /* Let the USART issue TX DMA requests */
+  struct USARTRegs *regs = USART(USART_LUT[usart]);
+  regs->CR3 |= USART_CR3_DMAT_Msk;
+}
+
+static void usart_tx_dma_complete(const dma_peripheral_t dma,
+                                  const uint8_t stream,
+                                  const struct DMAStreamISR flags,
+                                  void *context) {
+  (void)dma;
+  (void)stream;
+  struct USARTTxQueue *queue = (struct USARTTxQueue *)context;
+
+  if (!(flags.TCI || flags.TEI)) {
+    return;
+  } else {
+    /* Retire the finished buffer and chain the next one
+     * before running the callback, to keep the line busy */
+    const struct USARTDMADescriptor done = queue->Slots[queue->Tail];
+    queue->Tail = ((queue->Tail + 1U) & (USART_DMA_QUEUE_LEN - 1U));
+
+    if (queue->Tail != queue->Head) {
+      usart_tx_dma_start(queue);
+    } else {
+      queue->Active = FALSE;
+    }
+
+    if (done.Callback != NULL) {
+      done.Callback(queue->USART, done.Buffer, done.Length, flags.TEI,
+                    done.Context);
+    }
+  }
+}
+
+_Bool usart_tx_dma(const usart_peripheral_t usart, const uint8_t *buffer,
+                   const uint16_t length, const usart_dma_callback_t callback,
+                   void *context) {
+  if (!verifyUSART(usart)) {
+    return FALSE;
+  } else if ((buffer == NULL) || (length == 0U)) {
+    return FALSE;
+  } else {
+    struct USARTTxQueue *queue = &usart_tx_queues[usart];
+    _Bool queued = FALSE;
+
+    const uint32_t primask = critical_enter();
+    const uint8_t next = ((queue->Head + 1U) & (USART_DMA_QUEUE_LEN - 1U));
+    if (next != queue->Tail) {
+      struct USARTDMADescriptor *desc = &queue->Slots[queue->Head];
+      desc->Buffer = buffer;
+      desc->Length = length;
+      desc->Callback = callback;
+      desc->Context = context;
+      queue->Head = next;
+      queued = TRUE;
+
+      /* Kick the stream if nothing is in flight */
+      if (!queue->Active) {
+        queue->Active = TRUE;
+        queue->USART = usart;
+        usart_tx_dma_setup(usart);
+        usart_tx_dma_start(queue);
+      }
+    }
+    critical_exit(primask);
+
+    return queued;
+  }
+}
+
+_Bool usart_tx_dma_busy(const usart_peripheral_t usart) {
+  if (!verifyUSART(usart)) {
+    return FALSE;
+  } else {
+    return usart_tx_queues[usart].Active;
+  }
+}
+
+static void usart_rx_dma_backpressure(struct USARTRxRing *rx) {
+  if (rx->RTS == FALSE) {
+    return;
+  }
+
+  /* Hysteresis between the two watermarks */
+  if ((rx->RTSHeld == FALSE) && (rx->Pending >= rx->High)) {
+    gp_set_val(rx->RTSBank, rx->RTSPin, TRUE);
+    rx->RTSHeld = TRUE;
+  } else if ((rx->RTSHeld == TRUE) && (rx->Pending <= rx->Low)) {
+    gp_set_val(rx->RTSBank, rx->RTSPin, FALSE);
+    rx->RTSHeld = FALSE;
+  }
+}
+
+static void usart_rx_dma_update(struct USARTRxRing *rx, const _Bool idle) {
+  const struct USARTDMARoute route = USART_RX_DMA_LUT[rx->USART];
+  uint32_t received;
+
+  /* Current DMA write offset inside the ring */
+  uint16_t position = (rx->Size - dma_get_count(route.DMA, route.Stream));
+  if (position >= rx->Size) {
+    position = 0U;
+  }
+
+  /* HT / TC fire at least every half ring, so the distance
+   * since the last event never exceeds one lap */
+  if (position >= rx->Position) {
+    received = (position - rx->Position);
+  } else {
+    received = ((rx->Size - rx->Position) + position);
+  }
+  rx->Length += received;
+  rx->Pending += received;
+  rx->Position = position;
+
+  /* The remote ignored RTS and unreleased bytes got lost */
+  if ((rx->RTS == TRUE) && (rx->Pending > rx->Size)) {
+    rx->Pending = rx->Size;
+    rx->Dropped++;
+  }
+
+  /* Line went idle, close the frame */
+  if ((idle == TRUE) && (rx->Length > 0U)) {
+    if (rx->Length < rx->Size) {
+      rx->Callback(rx->USART, rx->Ring, rx->Start, (uint16_t)rx->Length,
+                   rx->Context);
+    } else {
+      /* Never delivered, so never released either */
+      rx->Pending -= (rx->Length < rx->Pending) ? rx->Length : rx->Pending;
+      rx->Dropped++;
+    }
+
+    rx->Start = position;
+    rx->Length = 0U;
+  }
+
+  usart_rx_dma_backpressure(rx);
+}
+
+static void usart_rx_dma_event(const dma_peripheral_t dma,
+                               const uint8_t stream,
+                               const struct DMAStreamISR flags,
+                               void *context) {
+  (void)dma;
+  (void)stream;
+
+  if (flags.HTI || flags.TCI) {
+    usart_rx_dma_update((struct USARTRxRing *)context, FALSE);
+  }
+}
+
+_Bool usart_rx_dma_start(const usart_peripheral_t usart, uint8_t *ring,
+                         const uint16_t size,
+                         const usart_rx_frame_callback_t callback,
+                         void *context) {
+  if (!verifyUSART(usart)) {
+    return FALSE;
+  } else if ((ring == NULL) || (size < 2U) || (callback == NULL)) {
+    return FALSE;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+    struct USARTRxRing *rx = &usart_rx_rings[usart];
+    const struct USARTDMARoute route = USART_RX_DMA_LUT[usart];
+    const struct DMAStreamConfig config = {.Circular = TRUE,
+                                           .MemIncrement = TRUE};
+    const struct DMAStreamISR isr = {.HTI = TRUE, .TCI = TRUE};
+
+    /* Reset the ring state */
+    NVIC_DisableIRQ(USART_IRQ_LUT[usart]);
+    NVIC_SetPriority(USART_IRQ_LUT[usart], USART_RX_IRQ_PRIORITY);
+    rx->Ring = ring;
+    rx->Size = size;
+    rx->Callback = callback;
+    rx->Context = context;
+    rx->Length = 0U;
+    rx->Dropped = 0U;
+    rx->Start = 0U;
+    rx->Position = 0U;
+    rx->Pending = 0U;
+    rx->RTS = FALSE;
+    rx->USART = usart;
+
+    /* Arm the RX stream permanently over the ring */
+    dma_disable(route.DMA, route.Stream);
+    dma_set_channel(route.DMA, route.Stream, route.Channel, DMA_PRIORITY_HIG);
+    dma_set_direction(route.DMA, route.Stream, DMA_DIR_PER2MEM);
+    dma_configure_stream(route.DMA, route.Stream, config);
+    dma_set_interrupts(route.DMA, route.Stream, isr);
+    dma_set_irq_priority(route.DMA, route.Stream, USART_RX_IRQ_PRIORITY);
+    dma_set_callback(route.DMA, route.Stream, usart_rx_dma_event, rx);
+    dma_set_addresses(route.DMA, route.Stream, (uint32_t)(uintptr_t)&regs->DR,
+                      (uint32_t)(uintptr_t)ring, 0U);
+    dma_configure_data(route.DMA, route.Stream, size, DMA_DATASIZE_BYTE,
+                       DMA_DATASIZE_BYTE);
+    dma_enable(route.DMA, route.Stream);
+    regs->CR3 |= USART_CR3_DMAR_Msk;
+
+    /* The idle line closes each frame, RXNE would race the DMA */
+    REG32 cr1 = regs->CR1;
+    cr1 &= ~(USART_CR1_RXNEIE_Msk); // Clear first
+    regs->CR1 = (cr1 | USART_CR1_IDLEIE_Msk);
+    NVIC_EnableIRQ(USART_IRQ_LUT[usart]);
+
+    return TRUE;
+  }
+}
+
+void usart_rx_dma_stop(const usart_peripheral_t usart) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else {
+    struct USARTRegs *regs = USART(USART_LUT[usart]);
+    const struct USARTDMARoute route = USART_RX_DMA_LUT[usart];
+
+    regs->CR1 &= ~(USART_CR1_IDLEIE_Msk);
+    regs->CR3 &= ~(USART_CR3_DMAR_Msk);
+    dma_disable(route.DMA, route.Stream);
+    dma_set_callback(route.DMA, route.Stream, NULL, NULL);
+    usart_rx_rings[usart].Callback = NULL;
+    usart_rx_rings[usart].RTS = FALSE;
+  }
+}
+
+uint32_t usart_rx_dma_dropped(const usart_peripheral_t usart) {
+  if (!verifyUSART(usart)) {
+    return 0U;
+  } else {
+    return usart_rx_rings[usart].Dropped;
+  }
+}
+
+_Bool usart_rx_dma_set_rts(const usart_peripheral_t usart,
+                           const gp_bank_t bank, const uint8_t pin,
+                           const uint16_t high, const uint16_t low) {
+  if (!verifyUSART(usart)) {
+    return FALSE;
+  } else if (usart_rx_rings[usart].Callback == NULL) {
+    return FALSE;
+  } else if ((high > (usart_rx_rings[usart].Size / 2U)) || (low >= high)) {
+    return FALSE;
+  } else {
+    struct USARTRxRing *rx = &usart_rx_rings[usart];
+
+    /* Start out ready to receive */
+    gp_set_val(bank, pin, FALSE);
+    gp_set_output_type(bank, pin, GP_OTYPE_PP);
+    gp_set_direction(bank, pin, GP_DIR_OU);
+
+    const uint32_t primask = critical_enter();
+    rx->RTSBank = bank;
+    rx->RTSPin = pin;
+    rx->High = high;
+    rx->Low = low;
+    rx->Pending = 0U;
+    rx->RTSHeld = FALSE;
+    rx->RTS = TRUE;
+    critical_exit(primask);
+
+    return TRUE;
+  }
+}
+
+void usart_rx_dma_release(const usart_peripheral_t usart,
+                          const uint16_t length) {
+  if (!verifyUSART(usart)) {
+    return;
+  } else {
+    struct USARTRxRing *rx = &usart_rx_rings[usart];
+
+    /* Shared with the DMA and USART interrupts */
+    const uint32_t primask = critical_enter();
+    rx->Pending -= (length < rx->Pending) ? length : rx->Pending;
+    usart_rx_dma_backpressure(rx);
+    critical_exit(primask);
+  }
+}
+
 uint16_t usart_rx_byte(const usart_peripheral_t usart) {
   if (!verifyUSART(usart)) {
     return '\0';
@@ -256,3 +952,76 @@ void usart_stop(const usart_peripheral_t usart) {
     regs->CR1 &= ~(USART_CR1_UE_Msk);
   }
 }
+
+static uint32_t usart_irq_sources(const struct USARTRegs *regs) {
+  const uint32_t cr1 = regs->CR1;
+  const uint32_t cr3 = regs->CR3;
+  uint32_t sources = 0U;
+
+  /* SR flags that raise the interrupt with their enable bit */
+  sources |= (cr1 & USART_CR1_TXEIE_Msk) ? USART_SR_TXE_Msk : 0U;
+  sources |= (cr1 & USART_CR1_TCIE_Msk) ? USART_SR_TC_Msk : 0U;
+  sources |= (cr1 & USART_CR1_RXNEIE_Msk)
+                 ? (USART_SR_RXNE_Msk | USART_SR_ORE_Msk)
+                 : 0U;
+  sources |= (cr1 & USART_CR1_IDLEIE_Msk) ? USART_SR_IDLE_Msk : 0U;
+  sources |= (cr1 & USART_CR1_PEIE_Msk) ? USART_SR_PE_Msk : 0U;
+  sources |= (regs->CR2 & USART_CR2_LBDIE_Msk) ? USART_SR_LBD_Msk : 0U;
+  sources |= (cr3 & USART_CR3_CTSIE_Msk) ? USART_SR_CTS_Msk : 0U;
+  sources |= (cr3 & USART_CR3_EIE_Msk)
+                 ? (USART_SR_FE_Msk | USART_SR_NE_Msk | USART_SR_ORE_Msk)
+                 : 0U;
+
+  return sources;
+}
+
+static void usart_irq_dispatch(const usart_peripheral_t usart) {
+  struct USARTRegs *regs = USART(USART_LUT[usart]);
+  uint32_t pending = (regs->SR & usart_irq_sources(regs));
+
+  /* Idle line: the SR read above plus a DR read clear it */
+  if ((pending & USART_SR_IDLE_Msk) &&
+      (usart_rx_rings[usart].Callback != NULL)) {
+    (void)regs->DR;
+    usart_rx_dma_update(&usart_rx_rings[usart], TRUE);
+    pending &= ~(USART_SR_IDLE_Msk);
+  }
+
+  if (pending == 0U) {
+    return;
+  } else if (usart_handlers[usart].Callback != NULL) {
+    usart_handlers[usart].Callback(usart, pending,
+                                   usart_handlers[usart].Context);
+  } else {
+    /* Nobody would clear the flags, mute the sources instead */
+    REG32 cr1 = regs->CR1;
+    cr1 &= ~(USART_CR1_PEIE_Msk | USART_CR1_TXEIE_Msk | USART_CR1_TCIE_Msk |
+             USART_CR1_RXNEIE_Msk);
+    if (usart_rx_rings[usart].Callback == NULL) {
+      cr1 &= ~(USART_CR1_IDLEIE_Msk); // Not owned by a receive ring
+    }
+    regs->CR1 = cr1;
+    regs->CR2 &= ~(USART_CR2_LBDIE_Msk);
+    regs->CR3 &= ~(USART_CR3_CTSIE_Msk | USART_CR3_EIE_Msk);
+  }
+}
+
+/* USART interrupt routine overrides */
+#ifdef USART1_BASE
+void USART1_IRQHandler(void) { usart_irq_dispatch(USART_PERIPH_1); }
+#endif
+#ifdef USART2_BASE
+void USART2_IRQHandler(void) { usart_irq_dispatch(USART_PERIPH_2); }
+#endif
+#ifdef USART3_BASE
+void USART3_IRQHandler(void) { usart_irq_dispatch(USART_PERIPH_3); }
+#endif
+#ifdef USART6_BASE
+void USART6_IRQHandler(void) { usart_irq_dispatch(USART_PERIPH_6); }
+#endif
+#ifdef UART4_BASE
+void UART4_IRQHandler(void) { usart_irq_dispatch(UART_PERIPH_4); }
+#endif
+#ifdef UART5_BASE
+void UART5_IRQHandler(void) { usart_irq_dispatch(UART_PERIPH_5); }
+#endif
@@ -13,9 +13,12 @@
 #define USART_H
 
 /* -- Includes -- */
+#include <stddef.h>
 #include <stdint.h>
 #include "stm32f4xx.h"
 #include "defines.h"
+#include "dma.h"
+#include "gpio.h"
 
 /* -- Structs -- */
 /**
@@ -34,7 +37,24 @@ struct __attribute__((packed)) USARTRegs {
 _Static_assert((sizeof(struct USARTRegs)) == (sizeof(uint32_t) * 7U),
                "USART register struct size mismatch. Is it aligned?");
 
+#ifndef UTEST
 #define USART(x) (struct USARTRegs *)(x)
+#else
+extern struct USARTRegs *USART(const uint32_t base);
+#endif
+
+/**
+ *  @brief Contains a computed USART baudrate setting
+ */
+struct __attribute__((packed)) USARTBaudConfig {
+  uint32_t Actual;  /**< Achieved baudrate (0 if unreachable) */
+  int32_t ErrorPPM; /**< Achieved rate error in ppm */
+  uint16_t BRR;     /**< Value for the BRR register */
+  _Bool Over8;      /**< Needs x8 oversampling */
+};
+
+_Static_assert((sizeof(struct USARTBaudConfig)) == (sizeof(uint8_t) * 11U),
+               "USART baud config struct size mismatch. Is it aligned?");
 
 /**
  *  @brief Contains USART interrupt configuration
@@ -53,6 +73,19 @@ struct __attribute__((packed)) USARTISR {
 _Static_assert((sizeof(struct USARTISR)) == (sizeof(uint8_t) * 1U),
                "USART interrupt struct size mismatch. Is it aligned?");
 
+/**
+ *  @brief Contains USART receive errors
+ */
+struct __attribute__((packed)) USARTErrors {
+  _Bool Overrun : 1;
+  _Bool Framing : 1;
+  _Bool Noise   : 1;
+  _Bool Parity  : 1;
+};
+
+_Static_assert((sizeof(struct USARTErrors)) == (sizeof(uint8_t) * 1U),
+               "USART error struct size mismatch. Is it aligned?");
+
 /* -- Enums -- */
 /**
  *  @brief Available USART peripherals
@@ -114,16 +147,148 @@ typedef enum usart_parity {
   USART_PARITY_OFF = 0x02
 } usart_parity_t;
 
+/**
+ *  @brief Available USART mute mode wakeup methods
+ */
+typedef enum usart_wakeup {
+  USART_WAKEUP_IDLE = 0x00,
+  USART_WAKEUP_ADDR = 0x01
+} usart_wakeup_t;
+
+/** @brief Highest node address for address mark wakeup */
+#define USART_ADDRESS_MAX 0x0FU
+
+/** @brief Address mark bit of a received 9-bit word */
+#define USART_ADDRESS_MARK9 0x100U
+
+/* -- Baudrate -- */
+/* USART1 / USART6 sit on APB2, the rest on APB1 */
+#define USART_APB1_HZ (APB1_CLK * 1000000UL)
+#define USART_APB2_HZ (APB2_CLK * 1000000UL)
+
+/**
+ *  @brief Rounded USART clock divider
+ *
+ *  With x16 oversampling BRR holds USARTDIV * 16, with x8
+ *  oversampling the mantissa holds USARTDIV and the 3-bit
+ *  fraction USARTDIV eighths. Either way the bit time is
+ *  DIV = round(clk / baud) kernel clocks, x16 just needs
+ *  DIV >= 16 and x8 needs DIV >= 8. The macros below are
+ *  constant expressions for constant inputs, so they may
+ *  be used in _Static_assert().
+ */
+#define USART_BAUD_DIV(clk, baud) (((clk) + ((baud) / 2UL)) / (baud))
+
+/** @brief x8 oversampling is only used when x16 can't reach */
+#define USART_BAUD_OVER8(clk, baud) (USART_BAUD_DIV(clk, baud) < 16UL)
+
+/** @brief The baudrate can be generated at all */
+#define USART_BAUD_VALID(clk, baud)                                            \
+  ((USART_BAUD_DIV(clk, baud) >= 8UL) &&                                       \
+   (USART_BAUD_DIV(clk, baud) <= 0xFFFFUL))
+
+/** @brief BRR register value */
+#define USART_BAUD_BRR(clk, baud)                                              \
+  (USART_BAUD_OVER8(clk, baud) ? (((USART_BAUD_DIV(clk, baud) >> 3U) << 4U) | \
+                                  (USART_BAUD_DIV(clk, baud) & 0x7UL))         \
+                               : USART_BAUD_DIV(clk, baud))
+
+/** @brief Achieved baudrate */
+#define USART_BAUD_ACTUAL(clk, baud)                                           \
+  (((clk) + (USART_BAUD_DIV(clk, baud) / 2UL)) / USART_BAUD_DIV(clk, baud))
+
+/** @brief Achieved baudrate error in ppm */
+#define USART_BAUD_ERROR_PPM(clk, baud)                                        \
+  ((int32_t)((((int64_t)USART_BAUD_ACTUAL(clk, baud) - (int64_t)(baud)) *      \
+              1000000LL) /                                                     \
+             (int64_t)(baud)))
+
+/**
+ *  @brief Number of DMA transmit descriptors per USART
+ *
+ *  One slot is always kept free, so at most LEN - 1
+ *  buffers can be waiting at the same time.
+ */
+#define USART_DMA_QUEUE_LEN 8U
+
+_Static_assert(((USART_DMA_QUEUE_LEN & (USART_DMA_QUEUE_LEN - 1U)) == 0U),
+               "USART DMA queue length must be a power of two.");
+
+/**
+ *  @brief NVIC priority of the DMA receive ring interrupts
+ *
+ *  Given to both the USART and the RX DMA stream
+ *  interrupts, so that they never preempt each other.
+ */
+#define USART_RX_IRQ_PRIORITY 5U
+
+/**
+ *  @brief USART interrupt callback
+ *
+ *  Called from the USART interrupt with the SR flags of
+ *  the enabled sources that are pending. The callback has
+ *  to clear them (e.g. read DR for RXNE, write DR or
+ *  disable TXEIE for TXE), otherwise the interrupt fires
+ *  again right away.
+ */
+typedef void (*usart_callback_t)(const usart_peripheral_t usart,
+                                 const uint32_t flags, void *context);
+
+/**
+ *  @brief USART DMA transmit completion callback
+ *
+ *  Called from the DMA interrupt once the buffer has been
+ *  handed over to the peripheral and may be reused.
+ */
+typedef void (*usart_dma_callback_t)(const usart_peripheral_t usart,
+                                     const uint8_t *buffer,
+                                     const uint16_t length, const _Bool error,
+                                     void *context);
+
+/**
+ *  @brief USART DMA frame reception callback
+ *
+ *  Called from interrupt context when the line goes idle
+ *  after a frame. The frame is a view into the receive
+ *  ring: it starts at ring[offset] and may wrap around
+ *  the end of the ring, so byte i of the frame is located
+ *  at ring[(offset + i) % size]. The data stay valid
+ *  until the DMA laps over them.
+ */
+typedef void (*usart_rx_frame_callback_t)(const usart_peripheral_t usart,
+                                          const uint8_t *ring,
+                                          const uint16_t offset,
+                                          const uint16_t length,
+                                          void *context);
+
+/**
+ * @brief Computes the baudrate setting of a USART.
+ *
+ * Uses the bus clock the USART is attached to and picks
+ * x8 oversampling only for rates x16 can not reach (up to
+ * APB / 8, i.e. 11.25 Mbit/s on APB2). For constant rates
+ * prefer the USART_BAUD_* macros, which fold at compile
+ * time.
+ *
+ * @param usart The selected USART
+ * @param baudrate The desired communication bitrate
+ * @return The baud configuration (Actual is 0 if invalid)
+ */
+struct USARTBaudConfig usart_calc_baud(const usart_peripheral_t usart,
+                                       const uint32_t baudrate);
+
 /**
  * @brief Initiates the USART peripheral with specified options.
  *
  * The available modes for the USART peripheral are specified in
- * the usart_mode_t enum. Any other value will be ignored.
+ * the usart_mode_t enum. Any other value will be ignored. The
+ * baudrate is derived from the bus clock of the USART (see
+ * usart_calc_baud()) and x8 oversampling is selected when
+ * needed. Unreachable baudrates will be ignored.
  *
  * @param usart The selected USART
  * @param baudrate The desired communication bitrate
  * @param mode The desired communication mode
- * @param x8_oversample Use x8 oversampling instead of x16
  * @return None
  */
 void usart_start(const usart_peripheral_t usart, const uint32_t baudrate,
@@ -153,6 +318,24 @@ void usart_set_dma(const usart_peripheral_t usart, const _Bool forTX,
 void usart_set_interrupts(const usart_peripheral_t usart,
                           const struct USARTISR config);
 
+/**
+ * @brief Registers a callback for the USART interrupt.
+ *
+ * The USART interrupt handlers belong to the driver, so
+ * this is how the sources enabled with
+ * usart_set_interrupts() are serviced. While no callback
+ * is registered, a pending source other than the idle
+ * line of a receive ring gets disabled instead, so it
+ * can not keep the interrupt firing.
+ *
+ * @param usart The selected USART
+ * @param callback The interrupt callback (NULL to remove)
+ * @param context User pointer passed to the callback
+ * @return None
+ */
+void usart_set_callback(const usart_peripheral_t usart,
+                        const usart_callback_t callback, void *context);
+
 /**
  * @brief Sets the USART databits to the specified values.
  *
@@ -185,12 +368,89 @@ void usart_set_databits(const usart_peripheral_t usart,
 void usart_set_parity(const usart_peripheral_t usart,
                       const usart_parity_t parity);
 
+/**
+ * @brief Configures the USART multiprocessor mute mode.
+ *
+ * With address mark wakeup the receiver, once muted by
+ * usart_mute(), ignores every frame (no RXNE, no
+ * interrupt, no DMA request) until an address frame with
+ * the given 4-bit address arrives. Address frames have the
+ * MSB set, so with USART_DATABITS_DB9 (and parity off)
+ * the data bytes keep all 8 bits, see usart_tx_address().
+ * A non-matching address mutes the receiver again in
+ * hardware. With idle line wakeup the receiver wakes on
+ * the next idle line and the address is not used.
+ *
+ * @param usart The selected USART
+ * @param wakeup The wakeup method
+ * @param address The node address (0..15)
+ * @return None
+ */
+void usart_set_mute_mode(const usart_peripheral_t usart,
+                         const usart_wakeup_t wakeup, const uint8_t address);
+
+/**
+ * @brief Puts the USART receiver into mute mode.
+ *
+ * Sets the RWU bit, hardware clears it on wakeup. With
+ * idle line wakeup, the USART must have received a byte
+ * before it can be muted.
+ *
+ * @param usart The selected USART
+ * @return None
+ */
+void usart_mute(const usart_peripheral_t usart);
+
+/**
+ * @brief Checks whether the USART receiver is muted.
+ *
+ * @param usart The selected USART
+ * @return TRUE while muted
+ */
+_Bool usart_is_muted(const usart_peripheral_t usart);
+
+/**
+ * @brief Sends an address frame to a multidrop bus.
+ *
+ * The address mark is bit 8 in 9-bit mode and bit 7 in
+ * 8-bit mode, the node address is compared on the lower
+ * four bits by the receivers. Data that follow can be
+ * sent with usart_write(), which leaves the mark clear.
+ *
+ * @param usart The selected USART
+ * @param address The node address (0..15)
+ * @return None
+ */
+void usart_tx_address(const usart_peripheral_t usart, const uint8_t address);
+
+/**
+ * @brief Configures the USART hardware flow control.
+ *
+ * With RTS enabled the USART deasserts nRTS while the
+ * receive data register is full, with CTS enabled it only
+ * starts a transmission while nCTS is low. The TX DMA
+ * queue is paused by CTS transparently. Note that with
+ * DMA reception the data register is drained right away,
+ * so hardware RTS can't reflect the receive ring fill
+ * level, see usart_rx_dma_set_rts() for that. The UARTs
+ * have no flow control lines and will be ignored.
+ *
+ * @param usart The selected USART
+ * @param rts Enable / Disable the RTS output
+ * @param cts Enable / Disable the CTS input
+ * @return None
+ */
+void usart_set_flow_control(const usart_peripheral_t usart, const _Bool rts,
+                            const _Bool cts);
+
 /**
  * @brief Writes specified message to USART buffer.
  *
  * In transmit/transceive mode the data will be written to the
  * DR register and be shifted out of the TX pin when ready.
  * Using it without DMA is not recommended for multibyte messages.
+ * The function waits for the line to go idle before returning,
+ * use usart_write() for binary data or back to back messages.
  *
  * @param usart The selected USART
  * @param character Pointer to the message
@@ -198,6 +458,187 @@ void usart_set_parity(const usart_peripheral_t usart,
  */
 void usart_tx_message(const usart_peripheral_t usart, const char *message);
 
+/**
+ * @brief Writes a binary buffer to the USART.
+ *
+ * Every byte is written to DR as soon as TXE is set, so
+ * zero bytes are sent like any other. The function does
+ * not wait for transmission complete: consecutive writes
+ * keep the shift register busy without gaps. Call
+ * usart_flush() when the line must be idle.
+ *
+ * @param usart The selected USART
+ * @param buf Pointer to the data
+ * @param len The number of bytes to send
+ * @return None
+ */
+void usart_write(const usart_peripheral_t usart, const uint8_t *buf,
+                 const size_t len);
+
+/**
+ * @brief Reads a buffer from the USART with a deadline.
+ *
+ * Polls RXNE in a tight loop and stores every received
+ * byte until the buffer is full or timeout_ticks SysTick
+ * ticks have passed since the call, so a silent line
+ * can't hang the caller. The error flags of every
+ * received byte are accumulated into errors, an overrun
+ * means at least one byte was lost before it could be
+ * read. Only the lower 8 bits of 9-bit words are kept.
+ *
+ * @param usart The selected USART
+ * @param buf Pointer to the receive buffer
+ * @param len The number of bytes to read
+ * @param timeout_ticks Maximum time to wait in ticks
+ * @param errors Receive errors seen (may be NULL)
+ * @return The number of bytes received
+ */
+size_t usart_read(const usart_peripheral_t usart, uint8_t *buf,
+                  const size_t len, const uint32_t timeout_ticks,
+                  struct USARTErrors *errors);
+
+/**
+ * @brief Waits until all USART transmissions are complete.
+ *
+ * Blocks until the TC flag is set, i.e. the last written
+ * frame has left the shift register.
+ *
+ * @param usart The selected USART
+ * @return None
+ */
+void usart_flush(const usart_peripheral_t usart);
+
+/**
+ * @brief Queues a buffer for transmission through DMA.
+ *
+ * The buffer is not copied, it is handed to the TX DMA
+ * stream of the USART as-is, so it must stay untouched
+ * until the callback fires. Queued buffers are chained
+ * back to back from the DMA transfer complete interrupt.
+ * The DMAT bit and the stream are configured on demand.
+ *
+ * The streams used are fixed (see the reference manual
+ * DMA request mapping): USART1 DMA2 S7, USART2 DMA1 S6,
+ * USART3 DMA1 S3, UART4 DMA1 S4, UART5 DMA1 S7 and
+ * USART6 DMA2 S6.
+ *
+ * @param usart The selected USART
+ * @param buffer Pointer to the caller owned data
+ * @param length The number of bytes to send (1..65535)
+ * @param callback Completion callback (may be NULL)
+ * @param context User pointer passed to the callback
+ * @return TRUE if queued, FALSE if invalid or queue full
+ */
+_Bool usart_tx_dma(const usart_peripheral_t usart, const uint8_t *buffer,
+                   const uint16_t length, const usart_dma_callback_t callback,
+                   void *context);
+
+/**
+ * @brief Checks whether USART DMA transmissions are pending.
+ *
+ * @param usart The selected USART
+ * @return TRUE while queued buffers are being sent
+ */
+_Bool usart_tx_dma_busy(const usart_peripheral_t usart);
+
+/**
+ * @brief Starts circular DMA reception with frame detection.
+ *
+ * The RX DMA stream is armed permanently in circular mode
+ * over the caller provided ring. The DMA half / full
+ * transfer interrupts keep track of the write position and
+ * the USART IDLE interrupt closes the current frame, which
+ * is then delivered through the callback as a view into
+ * the ring. No bytes are copied and the CPU is not
+ * involved per byte. Frames longer than the ring can not
+ * be delivered and are counted as dropped instead.
+ *
+ * This takes over the IDLEIE interrupt bit and the DMAR
+ * bit of the USART, and clears RXNEIE as the DMA owns DR.
+ * Both interrupts get USART_RX_IRQ_PRIORITY. Other USART
+ * interrupt sources are still handed to the callback of
+ * usart_set_callback(). The streams used are fixed: USART1
+ * DMA2 S5, USART2 DMA1 S5, USART3 DMA1 S1, UART4 DMA1 S2,
+ * UART5 DMA1 S0 and USART6 DMA2 S1.
+ *
+ * @param usart The selected USART
+ * @param ring Pointer to the caller owned ring buffer
+ * @param size The ring size in bytes (2..65535)
+ * @param callback Frame callback
+ * @param context User pointer passed to the callback
+ * @return TRUE if reception was started
+ */
+_Bool usart_rx_dma_start(const usart_peripheral_t usart, uint8_t *ring,
+                         const uint16_t size,
+                         const usart_rx_frame_callback_t callback,
+                         void *context);
+
+/**
+ * @brief Stops circular DMA reception.
+ *
+ * @param usart The selected USART
+ * @return None
+ */
+void usart_rx_dma_stop(const usart_peripheral_t usart);
+
+/**
+ * @brief Returns the number of frames dropped so far.
+ *
+ * A frame is dropped when it is longer than the ring and
+ * its beginning has been overwritten by the DMA. With
+ * usart_rx_dma_set_rts() in use, every overwrite of
+ * bytes not yet released counts as well.
+ *
+ * @param usart The selected USART
+ * @return The dropped frame count
+ */
+uint32_t usart_rx_dma_dropped(const usart_peripheral_t usart);
+
+/**
+ * @brief Drives an RTS pin from the receive ring fill level.
+ *
+ * The pin is set up as a push-pull output and driven low
+ * (ready). From then on every received byte counts as
+ * pending until the application hands it back with
+ * usart_rx_dma_release(). Once the pending bytes reach
+ * the high watermark the pin goes high and the remote
+ * side has to pause, once they drop to the low watermark
+ * the pin goes low again.
+ *
+ * The fill level is only evaluated on the DMA half /
+ * transfer complete events, on idle line and on release,
+ * so up to half a ring can arrive between two checks.
+ * The high watermark is thus limited to half the ring,
+ * keep it lower by the bytes the remote needs to react.
+ * The pin must be muxed as a GPIO, not as the USART RTS
+ * alternate function. The configuration is dropped by
+ * usart_rx_dma_stop().
+ *
+ * @param usart The selected USART
+ * @param bank The GPIO bank of the RTS pin
+ * @param pin The GPIO pin of the RTS pin
+ * @param high Pending bytes that pause the remote (<= size / 2)
+ * @param low Pending bytes that resume the remote
+ * @return TRUE if configured, FALSE if invalid or not started
+ */
+_Bool usart_rx_dma_set_rts(const usart_peripheral_t usart,
+                           const gp_bank_t bank, const uint8_t pin,
+                           const uint16_t high, const uint16_t low);
+
+/**
+ * @brief Hands received bytes back to the receive ring.
+ *
+ * Only needed when usart_rx_dma_set_rts() is in use: call
+ * it once the bytes of a delivered frame have been
+ * consumed, so the ring can accept more data.
+ *
+ * @param usart The selected USART
+ * @param length The number of consumed bytes
+ * @return None
+ */
+void usart_rx_dma_release(const usart_peripheral_t usart,
+                          const uint16_t length);
+
 /**
  * @brief Reads the received data from the USART buffer.
  *
@@ -222,4 +663,31 @@ uint16_t usart_rx_byte(const usart_peripheral_t usart);
  */
 void usart_stop(const usart_peripheral_t usart);
 
+/**
+ * @brief USART interrupt handlers.
+ *
+ * They are owned by the driver, hook into them through
+ * usart_set_callback() instead.
+ *
+ * @return None
+ */
+#ifdef USART1_BASE
+void USART1_IRQHandler(void);
+#endif
+#ifdef USART2_BASE
+void USART2_IRQHandler(void);
+#endif
+#ifdef USART3_BASE
+void USART3_IRQHandler(void);
+#endif
+#ifdef USART6_BASE
+void USART6_IRQHandler(void);
+#endif
+#ifdef UART4_BASE
+void UART4_IRQHandler(void);
+#endif
+#ifdef UART5_BASE
+void UART5_IRQHandler(void);
+#endif
+
 #endif
@@ -0,0 +1,71 @@
+/** @file crc.c
+ *  @brief Function defines for the CRC driver.
+ *
+ *  This file contains all of the function definitions
+ *  declared in crc.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include "crc.h"
+
+uint32_t crc_seed(uint32_t crc) {
+  /* One word step is invertible: run the 32 shifts
+   * backwards from the wanted value and XOR out the reset
+   * value */
+  for (uint8_t i = 0U; i < 32U; i++) {
+    if (crc & 1UL) {
+      crc = (((crc ^ CRC_POLY) >> 1U) | 0x80000000UL);
+    } else {
+      crc >>= 1U;
+    }
+  }
+
+  return (crc ^ CRC_INIT);
+}
+
+uint32_t crc_update_soft(const uint8_t *data, const size_t length,
+                         uint32_t crc) {
+  if (data == NULL) {
+    return crc;
+  }
+
+  for (size_t i = 0U; i < length; i++) {
+    crc ^= ((uint32_t)data[i] << 24U);
+    for (uint8_t bit = 0U; bit < 8U; bit++) {
+      crc = (crc & 0x80000000UL) ? ((crc << 1U) ^ CRC_POLY) : (crc << 1U);
+    }
+  }
+
+  return crc;
+}
+
+uint32_t crc_update(const uint8_t *data, const size_t length,
+                    const uint32_t crc) {
+  if (data == NULL) {
+    return crc;
+  } else if (length < sizeof(uint32_t)) {
+    return crc_update_soft(data, length, crc);
+  } else {
+    struct CRCRegs *regs = CRC_PTR;
+    const size_t words = (length / sizeof(uint32_t));
+
+    /* Start from the running value */
+    regs->CR = CRC_CR_RESET_Msk;
+    if (crc != CRC_INIT) {
+      regs->DR = crc_seed(crc);
+    }
+
+    /* Bytes go in MSB first, whatever the alignment */
+    for (size_t i = 0U; i < words; i++) {
+      const uint8_t *word = &data[i * sizeof(uint32_t)];
+      regs->DR = (((uint32_t)word[0] << 24U) | ((uint32_t)word[1] << 16U) |
+                  ((uint32_t)word[2] << 8U) | (uint32_t)word[3]);
+    }
+
+    return crc_update_soft(&data[words * sizeof(uint32_t)],
+                           (length - (words * sizeof(uint32_t))), regs->DR);
+  }
+}
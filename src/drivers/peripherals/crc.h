@@ -0,0 +1,93 @@
+/** @file crc.h
+ *  @brief Function prototypes for the CRC driver.
+ *
+ *  This file contains all of the structs, macros, and
+ *  function prototypes required for a functional CRC
+ *  driver.
+ *
+ *  The CRC unit computes CRC-32/MPEG-2 (poly 0x04C11DB7,
+ *  init 0xFFFFFFFF, no reflection, no final XOR) over
+ *  32-bit words. Byte streams are fed MSB first, so the
+ *  results match a plain bytewise CRC-32/MPEG-2 and a
+ *  message followed by its CRC (big endian) yields 0.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+/* -- Includes -- */
+#include <stddef.h>
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "defines.h"
+
+/* -- Structs -- */
+/**
+ *  @brief Contains CRC registers
+ */
+struct __attribute__((packed)) CRCRegs {
+  REG32 DR;
+  REG32 IDR;
+  REG32 CR;
+};
+
+_Static_assert((sizeof(struct CRCRegs)) == (sizeof(uint32_t) * 3U),
+               "CRC register struct size mismatch. Is it aligned?");
+
+#ifndef UTEST
+#define CRC_PTR (struct CRCRegs *)CRC_BASE
+#else
+extern struct CRCRegs *CRC_PTR;
+#endif
+
+/* -- Defines -- */
+#define CRC_INIT 0xFFFFFFFFUL
+#define CRC_POLY 0x04C11DB7UL
+
+/**
+ * @brief Finds the word that moves a reset unit to a CRC.
+ *
+ * The data register can't be loaded directly. Writing
+ * the returned word right after a reset leaves crc in
+ * it, so a running CRC can be continued in hardware.
+ *
+ * @param crc The wanted CRC
+ * @return The word to write after the reset
+ */
+uint32_t crc_seed(uint32_t crc);
+
+/**
+ * @brief Updates a CRC with the CRC unit.
+ *
+ * Whole words go through the hardware, up to three tail
+ * bytes are handled in software. A running CRC other
+ * than CRC_INIT is loaded into the unit first, so split
+ * buffers may be chained. The CRC clock has to be
+ * enabled by the caller (RCC_CLK_CRC). Not reentrant.
+ *
+ * @param data Pointer to the data
+ * @param length The number of bytes
+ * @param crc CRC_INIT or the result of a previous call
+ * @return The updated CRC
+ */
+uint32_t crc_update(const uint8_t *data, const size_t length,
+                    const uint32_t crc);
+
+/**
+ * @brief Updates a CRC in software.
+ *
+ * Same algorithm as crc_update(), for contexts where the
+ * CRC unit is busy or missing.
+ *
+ * @param data Pointer to the data
+ * @param length The number of bytes
+ * @param crc CRC_INIT or the result of a previous call
+ * @return The updated CRC
+ */
+uint32_t crc_update_soft(const uint8_t *data, const size_t length,
+                         uint32_t crc);
+
+#endif
@@ -5,14 +5,48 @@
  *  declared in dma.h.
  *
  *  @author Vasileios Ch. (BillisC)
- *  @bug There is a case where DMA1 clears EN SxCR bit
- *  when the peripheral address is USART2 DR. There is no
- *  workaround at the moment (is it errata?).
+ *  @bug None, yet.
  */
 
 /* -- Includes -- */
+#include <stddef.h>
 #include "dma.h"
 
+/* Event flag bits inside a stream's xISR / xIFCR slot */
+#define DMA_FLAG_FE  (1UL << 0U)
+#define DMA_FLAG_DME (1UL << 2U)
+#define DMA_FLAG_TE  (1UL << 3U)
+#define DMA_FLAG_HT  (1UL << 4U)
+#define DMA_FLAG_TC  (1UL << 5U)
+
+/**
+ *  @brief Offset of each stream slot in xISR / xIFCR
+ *
+ *  Streams 0..3 live in the low registers and 4..7 in the
+ *  high ones, using the same offsets.
+ */
+static const uint8_t DMA_FLAG_OFFSET[4] = {0U, 6U, 16U, 22U};
+
+/**
+ *  @brief DMA stream interrupt look up table
+ */
+static const IRQn_Type DMA_IRQ_LUT[2][8] = {
+    {DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn,
+     DMA1_Stream3_IRQn, DMA1_Stream4_IRQn, DMA1_Stream5_IRQn,
+     DMA1_Stream6_IRQn, DMA1_Stream7_IRQn},
+    {DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn,
+     DMA2_Stream3_IRQn, DMA2_Stream4_IRQn, DMA2_Stream5_IRQn,
+     DMA2_Stream6_IRQn, DMA2_Stream7_IRQn},
+};
+
+/**
+ *  @brief Registered stream callbacks
+ */
+static struct {
+  dma_callback_t Callback;
+  void *Context;
+} dma_handlers[2][8];
+
 static inline _Bool verifyDMA(const dma_peripheral_t dma,
                               const uint8_t stream) {
   /* Make sure that the peripheral and stream exist */
@@ -33,10 +67,10 @@ void dma_set_addresses(const dma_peripheral_t dma, const uint8_t stream,
   } else {
     struct DMARegs *regs = DMA(dma);
 
-    /* Set memory addresses */
-    regs->S[stream].PAR |= PA;
-    regs->S[stream].M0AR |= M0A;
-    regs->S[stream].M1AR |= M1A;
+    /* Set memory addresses (never merge with the old ones) */
+    regs->S[stream].PAR = PA;
+    regs->S[stream].M0AR = M0A;
+    regs->S[stream].M1AR = M1A;
   }
 }
 
@@ -182,12 +216,105 @@ void dma_set_interrupts(const dma_peripheral_t dma, const uint8_t stream,
   }
 }
 
+uint8_t dma_get_target(const dma_peripheral_t dma, const uint8_t stream) {
+  if (!(verifyDMA(dma, stream))) {
+    return 0U;
+  } else {
+    struct DMARegs *regs = DMA(dma);
+    return ((regs->S[stream].CR & DMA_SxCR_CT_Msk) != 0U);
+  }
+}
+
+uint16_t dma_get_count(const dma_peripheral_t dma, const uint8_t stream) {
+  if (!(verifyDMA(dma, stream))) {
+    return 0U;
+  } else {
+    struct DMARegs *regs = DMA(dma);
+    return (uint16_t)(0xFFFFUL & regs->S[stream].NDTR);
+  }
+}
+
+struct DMAStreamISR dma_get_flags(const dma_peripheral_t dma,
+                                  const uint8_t stream) {
+  struct DMAStreamISR flags = {0};
+
+  if (!(verifyDMA(dma, stream))) {
+    return flags;
+  } else {
+    struct DMARegs *regs = DMA(dma);
+
+    /* Pick the stream slot of the right register */
+    const uint32_t isr = (stream < 4U) ? regs->LISR : regs->HISR;
+    const uint32_t slot = (isr >> DMA_FLAG_OFFSET[stream & 3U]);
+
+    flags.FEI = ((slot & DMA_FLAG_FE) != 0U);
+    flags.DMEI = ((slot & DMA_FLAG_DME) != 0U);
+    flags.TEI = ((slot & DMA_FLAG_TE) != 0U);
+    flags.HTI = ((slot & DMA_FLAG_HT) != 0U);
+    flags.TCI = ((slot & DMA_FLAG_TC) != 0U);
+
+    return flags;
+  }
+}
+
+void dma_clear_flags(const dma_peripheral_t dma, const uint8_t stream,
+                     const struct DMAStreamISR flags) {
+  if (!(verifyDMA(dma, stream))) {
+    return;
+  } else {
+    struct DMARegs *regs = DMA(dma);
+
+    /* Clear register is write 1 to clear, no RMW needed */
+    const uint32_t slot = (((1UL & flags.FEI) * DMA_FLAG_FE) |
+                           ((1UL & flags.DMEI) * DMA_FLAG_DME) |
+                           ((1UL & flags.TEI) * DMA_FLAG_TE) |
+                           ((1UL & flags.HTI) * DMA_FLAG_HT) |
+                           ((1UL & flags.TCI) * DMA_FLAG_TC));
+    const uint32_t ifcr = (slot << DMA_FLAG_OFFSET[stream & 3U]);
+
+    if (stream < 4U) {
+      regs->LIFCR = ifcr;
+    } else {
+      regs->HIFCR = ifcr;
+    }
+  }
+}
+
+void dma_set_callback(const dma_peripheral_t dma, const uint8_t stream,
+                      const dma_callback_t callback, void *context) {
+  if (!(verifyDMA(dma, stream))) {
+    return;
+  } else {
+    /* Keep the handler away while swapping the callback */
+    NVIC_DisableIRQ(DMA_IRQ_LUT[dma][stream]);
+    dma_handlers[dma][stream].Callback = callback;
+    dma_handlers[dma][stream].Context = context;
+
+    if (callback != NULL) {
+      NVIC_EnableIRQ(DMA_IRQ_LUT[dma][stream]);
+    }
+  }
+}
+
+void dma_set_irq_priority(const dma_peripheral_t dma, const uint8_t stream,
+                          const uint8_t priority) {
+  if (!(verifyDMA(dma, stream))) {
+    return;
+  } else {
+    NVIC_SetPriority(DMA_IRQ_LUT[dma][stream], priority);
+  }
+}
+
 void dma_enable(const dma_peripheral_t dma, const uint8_t stream) {
   if (!(verifyDMA(dma, stream))) {
     return;
   } else {
     struct DMARegs *regs = DMA(dma);
 
+    /* Stale event flags must be cleared before enabling */
+    const struct DMAStreamISR all = {1U, 1U, 1U, 1U, 1U};
+    dma_clear_flags(dma, stream, all);
+
     /* Enable the specified stream */
     regs->S[stream].CR |= DMA_SxCR_EN_Msk;
   }
@@ -204,3 +331,41 @@ void dma_disable(const dma_peripheral_t dma, const uint8_t stream) {
     while (regs->S[stream].CR & DMA_SxCR_EN_Msk) {};
   }
 }
+
+_Bool dma_is_enabled(const dma_peripheral_t dma, const uint8_t stream) {
+  if (!(verifyDMA(dma, stream))) {
+    return FALSE;
+  } else {
+    const struct DMARegs *regs = DMA(dma);
+    return ((regs->S[stream].CR & DMA_SxCR_EN_Msk) != 0U);
+  }
+}
+
+static void dma_irq_dispatch(const dma_peripheral_t dma, const uint8_t stream) {
+  /* Acknowledge first so that a new event is not lost */
+  const struct DMAStreamISR flags = dma_get_flags(dma, stream);
+  dma_clear_flags(dma, stream, flags);
+
+  if (dma_handlers[dma][stream].Callback != NULL) {
+    dma_handlers[dma][stream].Callback(dma, stream, flags,
+                                       dma_handlers[dma][stream].Context);
+  }
+}
+
+/* DMA stream interrupt routine overrides */
+void DMA1_Stream0_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 0U); }
+void DMA1_Stream1_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 1U); }
+void DMA1_Stream2_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 2U); }
+void DMA1_Stream3_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 3U); }
+void DMA1_Stream4_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 4U); }
+void DMA1_Stream5_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 5U); }
+void DMA1_Stream6_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 6U); }
+void DMA1_Stream7_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_1, 7U); }
+void DMA2_Stream0_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 0U); }
+void DMA2_Stream1_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 1U); }
+void DMA2_Stream2_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 2U); }
+void DMA2_Stream3_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 3U); }
+void DMA2_Stream4_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 4U); }
+void DMA2_Stream5_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 5U); }
+void DMA2_Stream6_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 6U); }
+void DMA2_Stream7_IRQHandler(void) { dma_irq_dispatch(DMA_PERIPH_2, 7U); }
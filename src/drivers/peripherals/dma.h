@@ -7,10 +7,17 @@
  *
  *  DISCLAIMER: No burst or FIFO for the time being!
  *
+ *  NOTE: DMA1 used to clear the EN SxCR bit right after
+ *  enabling a stream that targets USART2 DR. It was not
+ *  errata: dma_set_addresses() OR'ed the new addresses on
+ *  top of the old ones, so a re-armed stream pointed at a
+ *  bogus location and the bus error (TEIF) made hardware
+ *  drop EN. The addresses are now written as-is and the
+ *  stream event flags are cleared before every enable, as
+ *  the reference manual requires.
+ *
  *  @author Vasileios Ch. (BillisC)
- *  @bug There is a case where DMA1 clears EN SxCR bit
- *  when the peripheral address is USART2 DR. There is no
- *  workaround at the moment (is it errata?).
+ *  @bug None, yet.
  */
 
 #ifndef DMA_H
@@ -52,7 +59,11 @@ _Static_assert((sizeof(struct DMARegs)) ==
                    (sizeof(uint32_t) * (4U + (6U * 8U))),
                "DMA register struct size mismatch. Is it aligned?");
 
+#ifndef UTEST
 #define DMA(x) (struct DMARegs *)(DMA1_BASE + (x * 0x400UL))
+#else
+extern struct DMARegs *DMA(const uint8_t num);
+#endif
 
 /**
  *  @brief Contains DMA stream options
@@ -91,6 +102,15 @@ typedef enum dma_peripheral {
   DMA_PERIPH_2 = 0x01
 } dma_peripheral_t;
 
+/**
+ *  @brief DMA stream event callback
+ *
+ *  Called from the stream interrupt with the event flags
+ *  that were pending (and have already been cleared).
+ */
+typedef void (*dma_callback_t)(const dma_peripheral_t dma, const uint8_t stream,
+                               const struct DMAStreamISR flags, void *context);
+
 /**
  *  @brief Available DMA directions
  */
@@ -212,9 +232,91 @@ void dma_set_channel(const dma_peripheral_t dma, const uint8_t stream,
 void dma_set_interrupts(const dma_peripheral_t dma, const uint8_t stream,
                         const struct DMAStreamISR config);
 
+/**
+ * @brief Reads the current double buffer target.
+ *
+ * In double buffer mode the stream switches to the other
+ * memory at every transfer complete, so from the TC
+ * callback on the buffer that just completed is the
+ * other one.
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @return 0 while filling M0, 1 while filling M1
+ */
+uint8_t dma_get_target(const dma_peripheral_t dma, const uint8_t stream);
+
+/**
+ * @brief Reads the remaining DMA transfer count.
+ *
+ * In circular mode the counter is reloaded after every
+ * lap, so this also tells where the stream is inside the
+ * memory buffer.
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @return The number of data items left (NDTR)
+ */
+uint16_t dma_get_count(const dma_peripheral_t dma, const uint8_t stream);
+
+/**
+ * @brief Reads the pending DMA stream event flags.
+ *
+ * The flags are reported using the same layout as the
+ * DMAStreamISR struct.
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @return The pending event flags
+ */
+struct DMAStreamISR dma_get_flags(const dma_peripheral_t dma,
+                                  const uint8_t stream);
+
+/**
+ * @brief Clears the specified DMA stream event flags.
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @param flags The event flags to clear
+ * @return None
+ */
+void dma_clear_flags(const dma_peripheral_t dma, const uint8_t stream,
+                     const struct DMAStreamISR flags);
+
+/**
+ * @brief Registers a callback for the DMA stream interrupt.
+ *
+ * The stream interrupt is enabled in the NVIC when a
+ * callback is registered and disabled when it is NULL.
+ * The stream interrupt sources themselves still have to
+ * be selected with dma_set_interrupts().
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @param callback The event callback (NULL to remove)
+ * @param context User pointer passed to the callback
+ * @return None
+ */
+void dma_set_callback(const dma_peripheral_t dma, const uint8_t stream,
+                      const dma_callback_t callback, void *context);
+
+/**
+ * @brief Sets the NVIC priority of the stream interrupt.
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @param priority The NVIC priority, lower is more urgent
+ * @return None
+ */
+void dma_set_irq_priority(const dma_peripheral_t dma, const uint8_t stream,
+                          const uint8_t priority);
+
 /**
  * @brief Enables DMA stream transfers.
  *
+ * Any stale event flags of the stream are cleared first,
+ * otherwise the new transfer may be cut short.
+ *
  * @param dma The selected DMA
  * @param stream The selected stream (0..7)
  * @return None
@@ -230,4 +332,41 @@ void dma_enable(const dma_peripheral_t dma, const uint8_t stream);
  */
 void dma_disable(const dma_peripheral_t dma, const uint8_t stream);
 
+/**
+ * @brief Returns whether a DMA stream is enabled.
+ *
+ * Normal mode streams disable themselves at the end of
+ * the transfer, so an enabled stream is still in use.
+ *
+ * @param dma The selected DMA
+ * @param stream The selected stream (0..7)
+ * @return TRUE if enabled, FALSE if not or invalid
+ */
+_Bool dma_is_enabled(const dma_peripheral_t dma, const uint8_t stream);
+
+/**
+ * @brief DMA stream interrupt handlers.
+ *
+ * They are owned by the driver, hook into them through
+ * dma_set_callback() instead.
+ *
+ * @return None
+ */
+void DMA1_Stream0_IRQHandler(void);
+void DMA1_Stream1_IRQHandler(void);
+void DMA1_Stream2_IRQHandler(void);
+void DMA1_Stream3_IRQHandler(void);
+void DMA1_Stream4_IRQHandler(void);
+void DMA1_Stream5_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
+void DMA1_Stream7_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream1_IRQHandler(void);
+void DMA2_Stream2_IRQHandler(void);
+void DMA2_Stream3_IRQHandler(void);
+void DMA2_Stream4_IRQHandler(void);
+void DMA2_Stream5_IRQHandler(void);
+void DMA2_Stream6_IRQHandler(void);
+void DMA2_Stream7_IRQHandler(void);
+
 #endif
@@ -0,0 +1,109 @@
+/** @file exti.c
+ *  @brief Function defines for the EXTI driver.
+ *
+ *  This file contains all of the function definitions
+ *  declared in exti.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include <stddef.h>
+#include "exti.h"
+
+/**
+ *  @brief EXTI line interrupt look up table
+ */
+static const IRQn_Type EXTI_IRQ_LUT[EXTI_LINE_LEN] = {
+    EXTI0_IRQn,     EXTI1_IRQn,     EXTI2_IRQn,     EXTI3_IRQn,
+    EXTI4_IRQn,     EXTI9_5_IRQn,   EXTI9_5_IRQn,   EXTI9_5_IRQn,
+    EXTI9_5_IRQn,   EXTI9_5_IRQn,   EXTI15_10_IRQn, EXTI15_10_IRQn,
+    EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn,
+};
+
+/**
+ *  @brief Registered line callbacks
+ */
+static struct {
+  exti_callback_t Callback;
+  void *Context;
+} exti_handlers[EXTI_LINE_LEN];
+
+void exti_configure(const gp_bank_t bank, const uint8_t pin,
+                    const _Bool rising, const _Bool falling,
+                    const exti_callback_t callback, void *context) {
+  if ((bank < GP_BANK_A) || (bank >= GP_BANK_LEN)) {
+    return;
+  } else if (!(pin < EXTI_LINE_LEN)) {
+    return;
+  } else {
+    struct EXTIRegs *exti = EXTI_PTR;
+    struct SYSCFGRegs *syscfg = SYSCFG_PTR;
+
+    /* Keep the line quiet while it is rerouted */
+    exti->IMR &= ~(1UL << pin);
+    exti_handlers[pin].Callback = callback;
+    exti_handlers[pin].Context = context;
+
+    /* Four lines per EXTICR, four bits each */
+    REG32 exticr = syscfg->EXTICR[pin >> 2U];
+    exticr &= ~(0xFUL << ((pin & 3U) * 4U)); // Clear first
+    exticr |= ((0xFUL & (bank - GP_BANK_A)) << ((pin & 3U) * 4U));
+    syscfg->EXTICR[pin >> 2U] = exticr;
+
+    REG32 rtsr = exti->RTSR;
+    rtsr &= ~(1UL << pin);
+    rtsr |= ((1UL & rising) << pin);
+    exti->RTSR = rtsr;
+
+    REG32 ftsr = exti->FTSR;
+    ftsr &= ~(1UL << pin);
+    ftsr |= ((1UL & falling) << pin);
+    exti->FTSR = ftsr;
+
+    /* Drop an edge seen before, then unmask */
+    exti->PR = (1UL << pin);
+    exti->IMR |= (1UL << pin);
+    NVIC_EnableIRQ(EXTI_IRQ_LUT[pin]);
+  }
+}
+
+void exti_disable(const uint8_t line) {
+  if (!(line < EXTI_LINE_LEN)) {
+    return;
+  } else {
+    struct EXTIRegs *exti = EXTI_PTR;
+
+    /* The shared interrupts stay enabled for other lines */
+    exti->IMR &= ~(1UL << line);
+    exti->RTSR &= ~(1UL << line);
+    exti->FTSR &= ~(1UL << line);
+    exti->PR = (1UL << line);
+    exti_handlers[line].Callback = NULL;
+  }
+}
+
+static void exti_irq_dispatch(const uint8_t first, const uint8_t last) {
+  struct EXTIRegs *exti = EXTI_PTR;
+
+  /* Acknowledge first so that a new edge is not lost */
+  const uint32_t mask = ((0xFFFFUL >> (15U - last)) & ~((1UL << first) - 1U));
+  const uint32_t pending = (exti->PR & exti->IMR & mask);
+  exti->PR = pending;
+
+  for (uint8_t line = first; line <= last; line++) {
+    if ((pending & (1UL << line)) && (exti_handlers[line].Callback != NULL)) {
+      exti_handlers[line].Callback(line, exti_handlers[line].Context);
+    }
+  }
+}
+
+/* EXTI interrupt routine overrides */
+void EXTI0_IRQHandler(void) { exti_irq_dispatch(0U, 0U); }
+void EXTI1_IRQHandler(void) { exti_irq_dispatch(1U, 1U); }
+void EXTI2_IRQHandler(void) { exti_irq_dispatch(2U, 2U); }
+void EXTI3_IRQHandler(void) { exti_irq_dispatch(3U, 3U); }
+void EXTI4_IRQHandler(void) { exti_irq_dispatch(4U, 4U); }
+void EXTI9_5_IRQHandler(void) { exti_irq_dispatch(5U, 9U); }
+void EXTI15_10_IRQHandler(void) { exti_irq_dispatch(10U, 15U); }
@@ -0,0 +1,115 @@
+/** @file exti.h
+ *  @brief Function prototypes for the EXTI driver.
+ *
+ *  This file contains all of the structs, macros, and
+ *  function prototypes required to get callbacks on GPIO
+ *  edges through the external interrupt lines 0..15.
+ *
+ *  Line n can be routed to pin n of a single bank at a
+ *  time. The edge is seen in any pin mode, alternate
+ *  functions included. SYSCFG has to be clocked by the
+ *  caller.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef EXTI_H
+#define EXTI_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "defines.h"
+#include "gpio.h"
+
+/* -- Structs -- */
+/**
+ *  @brief Contains EXTI registers
+ */
+struct __attribute__((packed)) EXTIRegs {
+  REG32 IMR;
+  REG32 EMR;
+  REG32 RTSR;
+  REG32 FTSR;
+  REG32 SWIER;
+  REG32 PR;
+};
+
+_Static_assert((sizeof(struct EXTIRegs)) == (sizeof(uint32_t) * 6U),
+               "EXTI register struct size mismatch. Is it aligned?");
+
+/**
+ *  @brief Contains the SYSCFG registers used by EXTI
+ */
+struct __attribute__((packed)) SYSCFGRegs {
+  REG32 MEMRMP;
+  REG32 PMC;
+  REG32 EXTICR[4];
+};
+
+_Static_assert((sizeof(struct SYSCFGRegs)) == (sizeof(uint32_t) * 6U),
+               "SYSCFG register struct size mismatch. Is it aligned?");
+
+#ifndef UTEST
+#define EXTI_PTR   (struct EXTIRegs *)EXTI_BASE
+#define SYSCFG_PTR (struct SYSCFGRegs *)SYSCFG_BASE
+#else
+extern struct EXTIRegs *EXTI_PTR;
+extern struct SYSCFGRegs *SYSCFG_PTR;
+#endif
+
+/* -- Defines -- */
+#define EXTI_LINE_LEN 16U
+
+/**
+ *  @brief EXTI line callback
+ *
+ *  Called from the line interrupt, the pending flag has
+ *  already been cleared.
+ */
+typedef void (*exti_callback_t)(const uint8_t line, void *context);
+
+/**
+ * @brief Routes a pin to its EXTI line and enables it.
+ *
+ * The line number equals the pin number, a previous
+ * routing of the line is replaced.
+ *
+ * @param bank The GPIO bank
+ * @param pin The GPIO pin
+ * @param rising Trigger on rising edges
+ * @param falling Trigger on falling edges
+ * @param callback Edge callback
+ * @param context User pointer passed to the callback
+ * @return None
+ */
+void exti_configure(const gp_bank_t bank, const uint8_t pin,
+                    const _Bool rising, const _Bool falling,
+                    const exti_callback_t callback, void *context);
+
+/**
+ * @brief Disables an EXTI line.
+ *
+ * @param line The EXTI line (0..15)
+ * @return None
+ */
+void exti_disable(const uint8_t line);
+
+/**
+ * @brief EXTI interrupt handlers.
+ *
+ * They are owned by the driver, hook into them through
+ * the exti_configure() callbacks instead.
+ *
+ * @return None
+ */
+void EXTI0_IRQHandler(void);
+void EXTI1_IRQHandler(void);
+void EXTI2_IRQHandler(void);
+void EXTI3_IRQHandler(void);
+void EXTI4_IRQHandler(void);
+void EXTI9_5_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+
+#endif
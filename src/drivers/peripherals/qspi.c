@@ -0,0 +1,339 @@
+/** @file qspi.c
+ *  @brief Function defines for the QUADSPI driver.
+ *
+ *  This file contains all of the function definitions
+ *  declared in qspi.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include <stddef.h>
+#include "qspi.h"
+#include "dma.h"
+#include "critical.h"
+
+/* Functional modes in CCR.FMODE */
+#define QSPI_FMODE_WRITE 0x0UL
+#define QSPI_FMODE_READ  0x1UL
+#define QSPI_FMODE_POLL  0x2UL
+#define QSPI_FMODE_MAP   0x3UL
+
+/* Fixed DMA route of the controller */
+#define QSPI_DMA         DMA_PERIPH_2
+#define QSPI_DMA_STREAM  7U
+#define QSPI_DMA_CHANNEL 3U
+
+/**
+ *  @brief Contains the DMA transfer state
+ */
+static struct {
+  qspi_callback_t Callback;
+  void *Context;
+  volatile _Bool Busy;
+} qspi_dma = {0};
+
+static inline _Bool verifyCommand(const struct QSPICommand *command) {
+  if (command == NULL) {
+    return FALSE;
+  } else if ((command->AddressLines != QSPI_LINES_NONE) &&
+             ((command->AddressSize < 1U) || (command->AddressSize > 4U))) {
+    return FALSE;
+  } else if ((command->AlternateLines != QSPI_LINES_NONE) &&
+             ((command->AlternateSize < 1U) ||
+              (command->AlternateSize > 4U))) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void qspi_wait_idle(struct QSPIRegs *regs) {
+  /* Memory-mapped mode stays busy until aborted */
+  if (((regs->CCR & QUADSPI_CCR_FMODE_Msk) >> QUADSPI_CCR_FMODE_Pos) ==
+      QSPI_FMODE_MAP) {
+    qspi_abort();
+  }
+  while (regs->SR & QUADSPI_SR_BUSY_Msk) { ASM_NOP; }
+}
+
+static _Bool qspi_wait_complete(struct QSPIRegs *regs) {
+  while (!(regs->SR & (QUADSPI_SR_TCF_Msk | QUADSPI_SR_TEF_Msk))) {
+    ASM_NOP;
+  }
+
+  const _Bool error = ((regs->SR & QUADSPI_SR_TEF_Msk) != 0U);
+  regs->FCR = (QUADSPI_FCR_CTCF_Msk | QUADSPI_FCR_CTEF_Msk);
+
+  return !error;
+}
+
+static void qspi_start(struct QSPIRegs *regs,
+                       const struct QSPICommand *command, const uint32_t mode,
+                       const uint32_t length) {
+  qspi_wait_idle(regs);
+
+  /* The half cycle sample shift is only valid in SDR */
+  if (command->DDR) {
+    regs->CR &= ~(QUADSPI_CR_SSHIFT_Msk);
+  } else {
+    regs->CR |= QUADSPI_CR_SSHIFT_Msk;
+  }
+
+  if (length != 0U) {
+    regs->DLR = (length - 1U);
+  }
+  if (command->AlternateLines != QSPI_LINES_NONE) {
+    regs->ABR = command->Alternate;
+  }
+
+  const uint32_t data_lines =
+      ((length == 0U) && (mode != QSPI_FMODE_MAP)) ? 0U : command->DataLines;
+  const uint32_t address_size =
+      (command->AddressSize == 0U) ? 0U : (command->AddressSize - 1U);
+  const uint32_t alternate_size =
+      (command->AlternateSize == 0U) ? 0U : (command->AlternateSize - 1U);
+
+  /* Writing CCR starts commands without address phase */
+  regs->CCR = ((command->Instruction << QUADSPI_CCR_INSTRUCTION_Pos) |
+               (command->InstructionLines << QUADSPI_CCR_IMODE_Pos) |
+               (command->AddressLines << QUADSPI_CCR_ADMODE_Pos) |
+               (address_size << QUADSPI_CCR_ADSIZE_Pos) |
+               (command->AlternateLines << QUADSPI_CCR_ABMODE_Pos) |
+               (alternate_size << QUADSPI_CCR_ABSIZE_Pos) |
+               (command->DummyCycles << QUADSPI_CCR_DCYC_Pos) |
+               (data_lines << QUADSPI_CCR_DMODE_Pos) |
+               (mode << QUADSPI_CCR_FMODE_Pos) |
+               (command->SendOnce << QUADSPI_CCR_SIOO_Pos) |
+               ((uint32_t)command->DDR << QUADSPI_CCR_DDRM_Pos));
+
+  /* Otherwise writing AR does */
+  if ((command->AddressLines != QSPI_LINES_NONE) &&
+      (mode != QSPI_FMODE_MAP)) {
+    regs->AR = command->Address;
+  }
+}
+
+void qspi_init(const uint8_t prescaler, const uint8_t size_log2,
+               const uint8_t cs_high, const _Bool mode3) {
+  if ((size_log2 < 2U) || (size_log2 > 32U)) {
+    return;
+  } else if ((cs_high < 1U) || (cs_high > 8U)) {
+    return;
+  } else {
+    struct QSPIRegs *regs = QSPI_PTR;
+
+    if (regs->SR & QUADSPI_SR_BUSY_Msk) {
+      qspi_abort();
+    }
+    regs->CR &= ~(QUADSPI_CR_EN_Msk);
+
+    /* Device size is stored as log2 - 1 */
+    regs->DCR = (((size_log2 - 1UL) << QUADSPI_DCR_FSIZE_Pos) |
+                 ((cs_high - 1UL) << QUADSPI_DCR_CSHT_Pos) |
+                 ((1UL & mode3) << QUADSPI_DCR_CKMODE_Pos));
+
+    REG32 cr = regs->CR;
+    cr &= ~(QUADSPI_CR_PRESCALER_Msk | QUADSPI_CR_FTHRES_Msk |
+            QUADSPI_CR_DMAEN_Msk); // Clear first
+    cr |= (((uint32_t)prescaler << QUADSPI_CR_PRESCALER_Pos) |
+           QUADSPI_CR_SSHIFT_Msk | QUADSPI_CR_EN_Msk);
+    regs->CR = cr;
+  }
+}
+
+_Bool qspi_command(const struct QSPICommand *command) {
+  if (!verifyCommand(command)) {
+    return FALSE;
+  } else {
+    struct QSPIRegs *regs = QSPI_PTR;
+
+    qspi_start(regs, command, QSPI_FMODE_WRITE, 0U);
+    return qspi_wait_complete(regs);
+  }
+}
+
+_Bool qspi_read(const struct QSPICommand *command, uint8_t *data,
+                const uint32_t length) {
+  if (!verifyCommand(command) || (data == NULL) || (length == 0U)) {
+    return FALSE;
+  } else if (command->DataLines == QSPI_LINES_NONE) {
+    return FALSE;
+  } else {
+    struct QSPIRegs *regs = QSPI_PTR;
+    volatile uint8_t *dr = (volatile uint8_t *)&regs->DR;
+
+    qspi_start(regs, command, QSPI_FMODE_READ, length);
+    for (uint32_t i = 0U; i < length; i++) {
+      /* FIFO at threshold, or the tail after completion */
+      while (!(regs->SR & (QUADSPI_SR_FTF_Msk | QUADSPI_SR_TCF_Msk |
+                           QUADSPI_SR_TEF_Msk))) {
+        ASM_NOP;
+      }
+      if (regs->SR & QUADSPI_SR_TEF_Msk) {
+        break;
+      }
+      data[i] = *dr;
+    }
+
+    return qspi_wait_complete(regs);
+  }
+}
+
+_Bool qspi_write(const struct QSPICommand *command, const uint8_t *data,
+                 const uint32_t length) {
+  if (!verifyCommand(command) || (data == NULL) || (length == 0U)) {
+    return FALSE;
+  } else if (command->DataLines == QSPI_LINES_NONE) {
+    return FALSE;
+  } else {
+    struct QSPIRegs *regs = QSPI_PTR;
+    volatile uint8_t *dr = (volatile uint8_t *)&regs->DR;
+
+    qspi_start(regs, command, QSPI_FMODE_WRITE, length);
+    for (uint32_t i = 0U; i < length; i++) {
+      while (!(regs->SR & (QUADSPI_SR_FTF_Msk | QUADSPI_SR_TEF_Msk))) {
+        ASM_NOP;
+      }
+      if (regs->SR & QUADSPI_SR_TEF_Msk) {
+        break;
+      }
+      *dr = data[i];
+    }
+
+    return qspi_wait_complete(regs);
+  }
+}
+
+static void qspi_dma_complete(const dma_peripheral_t dma, const uint8_t stream,
+                              const struct DMAStreamISR flags, void *context) {
+  struct QSPIRegs *regs = QSPI_PTR;
+  (void)context;
+
+  if (!(flags.TCI || flags.TEI)) {
+    return;
+  }
+
+  /* A write still drains the FIFO after the last DMA beat */
+  _Bool error = flags.TEI;
+  if (error) {
+    dma_disable(dma, stream);
+    qspi_abort();
+  } else {
+    error = !qspi_wait_complete(regs);
+  }
+  regs->CR &= ~(QUADSPI_CR_DMAEN_Msk);
+
+  qspi_dma.Busy = FALSE;
+  if (qspi_dma.Callback != NULL) {
+    qspi_dma.Callback(error, qspi_dma.Context);
+  }
+}
+
+_Bool qspi_transfer_dma(const struct QSPICommand *command, void *data,
+                        const uint16_t length, const _Bool write,
+                        const qspi_callback_t callback, void *context) {
+  if (!verifyCommand(command) || (data == NULL) || (length == 0U)) {
+    return FALSE;
+  } else if (command->DataLines == QSPI_LINES_NONE) {
+    return FALSE;
+  }
+
+  /* Claim the controller, the stream may serve USART1 TX */
+  const uint32_t primask = critical_enter();
+  const _Bool busy =
+      (qspi_dma.Busy || dma_is_enabled(QSPI_DMA, QSPI_DMA_STREAM));
+  if (busy == FALSE) {
+    qspi_dma.Busy = TRUE;
+  }
+  critical_exit(primask);
+  if (busy == TRUE) {
+    return FALSE;
+  }
+
+  struct QSPIRegs *regs = QSPI_PTR;
+  const struct DMAStreamConfig config = {.MemIncrement = TRUE};
+  const struct DMAStreamISR isr = {.TCI = TRUE, .TEI = TRUE};
+
+  qspi_dma.Callback = callback;
+  qspi_dma.Context = context;
+
+  dma_disable(QSPI_DMA, QSPI_DMA_STREAM);
+  dma_set_channel(QSPI_DMA, QSPI_DMA_STREAM, QSPI_DMA_CHANNEL,
+                  DMA_PRIORITY_HIG);
+  dma_set_direction(QSPI_DMA, QSPI_DMA_STREAM,
+                    write ? DMA_DIR_MEM2PER : DMA_DIR_PER2MEM);
+  dma_configure_stream(QSPI_DMA, QSPI_DMA_STREAM, config);
+  dma_set_interrupts(QSPI_DMA, QSPI_DMA_STREAM, isr);
+  dma_set_callback(QSPI_DMA, QSPI_DMA_STREAM, qspi_dma_complete, NULL);
+  dma_set_addresses(QSPI_DMA, QSPI_DMA_STREAM, (uint32_t)(uintptr_t)&regs->DR,
+                    (uint32_t)(uintptr_t)data, 0U);
+  dma_configure_data(QSPI_DMA, QSPI_DMA_STREAM, length, DMA_DATASIZE_BYTE,
+                     DMA_DATASIZE_BYTE);
+  dma_enable(QSPI_DMA, QSPI_DMA_STREAM);
+
+  /* Requests follow the FIFO threshold (one byte) */
+  qspi_start(regs, command, write ? QSPI_FMODE_WRITE : QSPI_FMODE_READ,
+             length);
+  regs->CR |= QUADSPI_CR_DMAEN_Msk;
+
+  return TRUE;
+}
+
+_Bool qspi_poll(const struct QSPICommand *command, const uint32_t mask,
+                const uint32_t match, const uint8_t size,
+                const uint16_t interval) {
+  if (!verifyCommand(command) || (size < 1U) || (size > 4U)) {
+    return FALSE;
+  } else if (command->DataLines == QSPI_LINES_NONE) {
+    return FALSE;
+  } else {
+    struct QSPIRegs *regs = QSPI_PTR;
+
+    qspi_wait_idle(regs);
+    regs->PSMKR = mask;
+    regs->PSMAR = match;
+    regs->PIR = interval;
+
+    /* AND match, stop on the first one */
+    REG32 cr = regs->CR;
+    cr &= ~(QUADSPI_CR_PMM_Msk);
+    cr |= QUADSPI_CR_APMS_Msk;
+    regs->CR = cr;
+
+    qspi_start(regs, command, QSPI_FMODE_POLL, size);
+    while (!(regs->SR & (QUADSPI_SR_SMF_Msk | QUADSPI_SR_TEF_Msk))) {
+      ASM_NOP;
+    }
+
+    const _Bool error = ((regs->SR & QUADSPI_SR_TEF_Msk) != 0U);
+    regs->FCR = (QUADSPI_FCR_CSMF_Msk | QUADSPI_FCR_CTCF_Msk |
+                 QUADSPI_FCR_CTEF_Msk);
+
+    return !error;
+  }
+}
+
+_Bool qspi_memory_map(const struct QSPICommand *command) {
+  if (!verifyCommand(command)) {
+    return FALSE;
+  } else if (command->DataLines == QSPI_LINES_NONE) {
+    return FALSE;
+  } else {
+    struct QSPIRegs *regs = QSPI_PTR;
+
+    /* Keep CS low between reads, no timeout */
+    regs->CR &= ~(QUADSPI_CR_TCEN_Msk);
+    qspi_start(regs, command, QSPI_FMODE_MAP, 0U);
+
+    return TRUE;
+  }
+}
+
+void qspi_abort(void) {
+  struct QSPIRegs *regs = QSPI_PTR;
+
+  regs->CR |= QUADSPI_CR_ABORT_Msk;
+  while (regs->CR & QUADSPI_CR_ABORT_Msk) { ASM_NOP; }
+}
@@ -0,0 +1,222 @@
+/** @file qspi.h
+ *  @brief Function prototypes for the QUADSPI driver.
+ *
+ *  This file contains all of the structs, enums, macros,
+ *  and function prototypes required to drive an external
+ *  NOR flash through the QUADSPI controller.
+ *
+ *  Every access is described by a QSPICommand: the
+ *  instruction, address, alternate bytes, dummy cycles
+ *  and data phases, each on 0, 1, 2 or 4 lines and
+ *  optionally in DDR. Commands run in indirect mode
+ *  (polling or DMA), in automatic status polling mode or
+ *  as the read command of the memory-mapped mode, where
+ *  the flash shows up at QSPI_MEM_BASE and can be read
+ *  (and executed from) with plain loads.
+ *
+ *  The pins, the AHB3 clock (RCC_CLK_QSPI) and DMA2 for
+ *  the DMA transfers have to be enabled by the caller.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef QSPI_H
+#define QSPI_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "defines.h"
+
+/* -- Structs -- */
+/**
+ *  @brief Contains QUADSPI registers
+ */
+struct __attribute__((packed)) QSPIRegs {
+  REG32 CR;
+  REG32 DCR;
+  REG32 SR;
+  REG32 FCR;
+  REG32 DLR;
+  REG32 CCR;
+  REG32 AR;
+  REG32 ABR;
+  REG32 DR;
+  REG32 PSMKR;
+  REG32 PSMAR;
+  REG32 PIR;
+  REG32 LPTR;
+};
+
+_Static_assert((sizeof(struct QSPIRegs)) == (sizeof(uint32_t) * 13U),
+               "QSPI register struct size mismatch. Is it aligned?");
+
+#ifndef UTEST
+#define QSPI_PTR (struct QSPIRegs *)QSPI_R_BASE
+#else
+extern struct QSPIRegs *QSPI_PTR;
+#endif
+
+/* -- Defines -- */
+/** @brief Start of the memory-mapped flash */
+#define QSPI_MEM_BASE 0x90000000UL
+
+/**
+ *  @brief Places read-only data (or code) in the external flash
+ *
+ *  Goes to the .extflash section of linker_script.ld, the
+ *  programmer writes it to the flash. Only accessible
+ *  after qspi_memory_map().
+ */
+#define QSPI_EXTFLASH __attribute__((section(".extflash")))
+
+/* -- Enums -- */
+/**
+ *  @brief Available phase line counts
+ */
+typedef enum qspi_lines {
+  QSPI_LINES_NONE = 0x0, /**< Phase skipped */
+  QSPI_LINES_1,
+  QSPI_LINES_2,
+  QSPI_LINES_4
+} qspi_lines_t;
+
+/**
+ *  @brief Contains a QUADSPI command
+ *
+ *  The sizes are in bytes (1..4), the alternate bytes of
+ *  quad reads usually carry the continuous read mode.
+ */
+struct QSPICommand {
+  uint32_t Address;
+  uint32_t Alternate;
+  uint8_t Instruction;
+  uint8_t InstructionLines : 2; /**< qspi_lines_t */
+  uint8_t AddressLines     : 2; /**< qspi_lines_t */
+  uint8_t AlternateLines   : 2; /**< qspi_lines_t */
+  uint8_t DataLines        : 2; /**< qspi_lines_t */
+  uint8_t AddressSize      : 3;
+  uint8_t AlternateSize    : 3;
+  uint8_t DummyCycles      : 5; /**< 0..31 */
+  _Bool DDR                : 1; /**< Double data rate phases */
+  _Bool SendOnce           : 1; /**< Instruction on first access only */
+};
+
+/**
+ *  @brief QUADSPI DMA completion callback
+ *
+ *  Called from the DMA interrupt once the whole transfer
+ *  has finished on the bus.
+ */
+typedef void (*qspi_callback_t)(const _Bool error, void *context);
+
+/**
+ * @brief Configures the QUADSPI controller.
+ *
+ * The flash clock is the AHB clock over (prescaler + 1).
+ * Aborts any running command and leaves the controller
+ * enabled in indirect mode.
+ *
+ * @param prescaler The clock prescaler (0..255)
+ * @param size_log2 The flash size as a power of two (2..32)
+ * @param cs_high The minimum CS high time in cycles (1..8)
+ * @param mode3 Clock idles high (SPI mode 3), else mode 0
+ * @return None
+ */
+void qspi_init(const uint8_t prescaler, const uint8_t size_log2,
+               const uint8_t cs_high, const _Bool mode3);
+
+/**
+ * @brief Sends a command without data phase.
+ *
+ * @param command The command, DataLines is ignored
+ * @return TRUE on success, FALSE on error or invalid
+ */
+_Bool qspi_command(const struct QSPICommand *command);
+
+/**
+ * @brief Reads data in indirect mode.
+ *
+ * @param command The command
+ * @param data Pointer to the receive buffer
+ * @param length The number of bytes
+ * @return TRUE on success, FALSE on error or invalid
+ */
+_Bool qspi_read(const struct QSPICommand *command, uint8_t *data,
+                const uint32_t length);
+
+/**
+ * @brief Writes data in indirect mode.
+ *
+ * @param command The command
+ * @param data Pointer to the data
+ * @param length The number of bytes
+ * @return TRUE on success, FALSE on error or invalid
+ */
+_Bool qspi_write(const struct QSPICommand *command, const uint8_t *data,
+                 const uint32_t length);
+
+/**
+ * @brief Runs an indirect transfer through DMA.
+ *
+ * Uses DMA2 stream 7 channel 3 and returns right away,
+ * the callback reports the end of the transfer.
+ *
+ * The stream is shared with the USART1 TX DMA route
+ * (usart_tx_dma(), the tlog drain), only one owner may
+ * use it at a time. A transfer is refused while the
+ * stream is enabled by someone else.
+ *
+ * @param command The command
+ * @param data Pointer to the data or receive buffer
+ * @param length The number of bytes (1..65535)
+ * @param write Write to the flash, else read
+ * @param callback Completion callback (may be NULL)
+ * @param context User pointer passed to the callback
+ * @return TRUE if started, FALSE if invalid or busy
+ */
+_Bool qspi_transfer_dma(const struct QSPICommand *command, void *data,
+                        const uint16_t length, const _Bool write,
+                        const qspi_callback_t callback, void *context);
+
+/**
+ * @brief Polls a status register until it matches.
+ *
+ * Runs the command in automatic polling mode, the
+ * controller reads the status every interval cycles with
+ * no CPU load until (status & mask) == match. Blocks
+ * until then, e.g. for the WIP bit after a program.
+ *
+ * @param command The read status command
+ * @param mask The bits to check
+ * @param match The expected value of the bits
+ * @param size The status size in bytes (1..4)
+ * @param interval Cycles between two reads
+ * @return TRUE on match, FALSE on error or invalid
+ */
+_Bool qspi_poll(const struct QSPICommand *command, const uint32_t mask,
+                const uint32_t match, const uint8_t size,
+                const uint16_t interval);
+
+/**
+ * @brief Enters memory-mapped mode.
+ *
+ * The command is issued for every read of the mapped
+ * region, use the fastest read of the flash (e.g. quad
+ * I/O, DDR, SendOnce with continuous read mode). Any
+ * other driver call aborts the mapping first.
+ *
+ * @param command The read command, Address is ignored
+ * @return TRUE on success, FALSE if invalid
+ */
+_Bool qspi_memory_map(const struct QSPICommand *command);
+
+/**
+ * @brief Aborts the running command.
+ *
+ * @return None
+ */
+void qspi_abort(void);
+
+#endif
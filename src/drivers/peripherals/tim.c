@@ -0,0 +1,171 @@
+/** @file tim.c
+ *  @brief Function defines for the timer driver.
+ *
+ *  This file contains all of the function definitions
+ *  declared in tim.h.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+/* -- Includes -- */
+#include "tim.h"
+
+/* PWM mode 1 in the OCxM field */
+#define TIM_OCM_PWM1 0x6UL
+
+/**
+ *  @brief Timer address look up table
+ */
+static const uint32_t TIM_LUT[] = {
+#ifdef TIM1_BASE
+    TIM1_BASE,
+#endif
+#ifdef TIM2_BASE
+    TIM2_BASE,
+#endif
+#ifdef TIM3_BASE
+    TIM3_BASE,
+#endif
+#ifdef TIM4_BASE
+    TIM4_BASE,
+#endif
+#ifdef TIM5_BASE
+    TIM5_BASE,
+#endif
+#ifdef TIM8_BASE
+    TIM8_BASE,
+#endif
+    0UL, // Safety value
+};
+
+static inline _Bool validateTIM(const tim_peripheral_t tim) {
+  if (tim < TIM_PERIPH_LEN && tim >= 0U) {
+    return TRUE;
+  } else {
+    return FALSE;
+  }
+}
+
+static inline _Bool isAdvanced(const tim_peripheral_t tim) {
+  switch (tim) {
+#ifdef TIM1_BASE
+    case TIM_PERIPH_1:
+#endif
+#ifdef TIM8_BASE
+    case TIM_PERIPH_8:
+#endif
+      return TRUE;
+    default: return FALSE;
+  }
+}
+
+static inline _Bool validateChannel(const tim_channel_t channel) {
+  return (channel <= TIM_CHANNEL_4);
+}
+
+uint32_t tim_get_clock(const tim_peripheral_t tim) {
+  if (!validateTIM(tim)) {
+    return 0UL;
+  } else if (isAdvanced(tim)) {
+    return (2UL * APB2_CLK * 1000000UL);
+  } else {
+    return (2UL * APB1_CLK * 1000000UL);
+  }
+}
+
+void tim_configure_base(const tim_peripheral_t tim, const uint16_t prescaler,
+                        const uint32_t reload) {
+  if (!validateTIM(tim)) {
+    return;
+  } else {
+    struct TIMRegs *regs = TIM(TIM_LUT[tim]);
+
+    regs->PSC = prescaler;
+    regs->ARR = reload;
+    regs->CR1 |= TIM_CR1_ARPE_Msk;
+
+    /* Load the preload registers now */
+    regs->EGR = TIM_EGR_UG_Msk;
+  }
+}
+
+void tim_configure_pwm(const tim_peripheral_t tim, const tim_channel_t channel,
+                       const uint32_t compare, const _Bool invert) {
+  if (!validateTIM(tim) || !validateChannel(channel)) {
+    return;
+  } else {
+    struct TIMRegs *regs = TIM(TIM_LUT[tim]);
+
+    /* Two channels per CCMR, one byte each */
+    const uint32_t shift = ((channel & 1U) * 8U);
+    REG32 ccmr = regs->CCMR[channel >> 1U];
+    ccmr &= ~((TIM_CCMR1_CC1S_Msk | TIM_CCMR1_OC1M_Msk | TIM_CCMR1_OC1PE_Msk)
+              << shift);
+    ccmr |= (((TIM_OCM_PWM1 << TIM_CCMR1_OC1M_Pos) | TIM_CCMR1_OC1PE_Msk)
+             << shift);
+    regs->CCMR[channel >> 1U] = ccmr;
+    regs->CCR[channel] = compare;
+
+    /* Four CCER bits per channel */
+    REG32 ccer = regs->CCER;
+    ccer &= ~((TIM_CCER_CC1E_Msk | TIM_CCER_CC1P_Msk) << (channel * 4U));
+    ccer |= ((TIM_CCER_CC1E_Msk | (invert << TIM_CCER_CC1P_Pos))
+             << (channel * 4U));
+    regs->CCER = ccer;
+
+    if (isAdvanced(tim)) {
+      regs->BDTR |= TIM_BDTR_MOE_Msk;
+    }
+  }
+}
+
+void tim_set_compare(const tim_peripheral_t tim, const tim_channel_t channel,
+                     const uint32_t compare) {
+  if (!validateTIM(tim) || !validateChannel(channel)) {
+    return;
+  } else {
+    struct TIMRegs *regs = TIM(TIM_LUT[tim]);
+    regs->CCR[channel] = compare;
+  }
+}
+
+void tim_set_dma(const tim_peripheral_t tim,
+                 const struct TIMDMARequests requests) {
+  if (!validateTIM(tim)) {
+    return;
+  } else {
+    struct TIMRegs *regs = TIM(TIM_LUT[tim]);
+
+    /* Set DMA request bits */
+    REG32 dier = regs->DIER;
+    dier &= ~(TIM_DIER_UDE_Msk | TIM_DIER_CC1DE_Msk | TIM_DIER_CC2DE_Msk |
+              TIM_DIER_CC3DE_Msk | TIM_DIER_CC4DE_Msk);
+    dier |= ((requests.Update << TIM_DIER_UDE_Pos) |
+             (requests.CC1 << TIM_DIER_CC1DE_Pos) |
+             (requests.CC2 << TIM_DIER_CC2DE_Pos) |
+             (requests.CC3 << TIM_DIER_CC3DE_Pos) |
+             (requests.CC4 << TIM_DIER_CC4DE_Pos));
+
+    regs->DIER = dier;
+  }
+}
+
+void tim_start(const tim_peripheral_t tim) {
+  if (!validateTIM(tim)) {
+    return;
+  } else {
+    struct TIMRegs *regs = TIM(TIM_LUT[tim]);
+    regs->CR1 |= TIM_CR1_CEN_Msk;
+  }
+}
+
+void tim_stop(const tim_peripheral_t tim) {
+  if (!validateTIM(tim)) {
+    return;
+  } else {
+    struct TIMRegs *regs = TIM(TIM_LUT[tim]);
+    regs->CR1 &= ~(TIM_CR1_CEN_Msk);
+    regs->CNT = 0UL;
+  }
+}
@@ -0,0 +1,197 @@
+/** @file tim.h
+ *  @brief Function prototypes for the timer driver.
+ *
+ *  This file contains all of the structs, enums, macros,
+ *  and function prototypes required for basic up-counting
+ *  timers with PWM outputs and DMA requests.
+ *
+ *  Only the advanced (TIM1/TIM8) and 32/16-bit general
+ *  purpose timers (TIM2..TIM5) are covered.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ *  @bug None, yet.
+ */
+
+#ifndef TIM_H
+#define TIM_H
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "defines.h"
+
+/* -- Structs -- */
+/**
+ *  @brief Contains timer registers
+ */
+struct __attribute__((packed)) TIMRegs {
+  REG32 CR1;
+  REG32 CR2;
+  REG32 SMCR;
+  REG32 DIER;
+  REG32 SR;
+  REG32 EGR;
+  REG32 CCMR[2];
+  REG32 CCER;
+  REG32 CNT;
+  REG32 PSC;
+  REG32 ARR;
+  REG32 RCR;
+  REG32 CCR[4];
+  REG32 BDTR;
+  REG32 DCR;
+  REG32 DMAR;
+  REG32 OR;
+};
+
+_Static_assert((sizeof(struct TIMRegs)) == (sizeof(uint32_t) * 21U),
+               "TIM register struct size mismatch. Is it aligned?");
+
+#ifndef UTEST
+#define TIM(ADDR) (struct TIMRegs *)(ADDR)
+#else
+extern struct TIMRegs *TIM(const uint32_t base);
+#endif
+
+/**
+ *  @brief Contains timer DMA request configuration
+ */
+struct __attribute__((packed)) TIMDMARequests {
+  _Bool Update : 1; /**< Counter update */
+  _Bool CC1    : 1; /**< Channel 1 compare */
+  _Bool CC2    : 1; /**< Channel 2 compare */
+  _Bool CC3    : 1; /**< Channel 3 compare */
+  _Bool CC4    : 1; /**< Channel 4 compare */
+};
+
+_Static_assert((sizeof(struct TIMDMARequests)) == (sizeof(uint8_t) * 1U),
+               "TIM DMA request struct size mismatch. Is it aligned?");
+
+/* -- Enums -- */
+/**
+ *  @brief Available timer peripherals
+ */
+typedef enum tim_peripheral {
+#ifdef TIM1_BASE
+  TIM_PERIPH_1 = 0x0,
+#endif
+#ifdef TIM2_BASE
+  TIM_PERIPH_2,
+#endif
+#ifdef TIM3_BASE
+  TIM_PERIPH_3,
+#endif
+#ifdef TIM4_BASE
+  TIM_PERIPH_4,
+#endif
+#ifdef TIM5_BASE
+  TIM_PERIPH_5,
+#endif
+#ifdef TIM8_BASE
+  TIM_PERIPH_8,
+#endif
+  TIM_PERIPH_LEN
+} tim_peripheral_t;
+
+/**
+ *  @brief Available capture/compare channels
+ */
+typedef enum tim_channel {
+  TIM_CHANNEL_1 = 0x0,
+  TIM_CHANNEL_2,
+  TIM_CHANNEL_3,
+  TIM_CHANNEL_4
+} tim_channel_t;
+
+/**
+ *  @brief Returns the counter clock of a timer
+ *
+ *  Timers run at twice their bus clock, as the APB
+ *  prescalers are not 1 (see defines.h).
+ *
+ *  @param tim The selected timer
+ *  @return The timer clock in Hz, 0 if invalid
+ */
+uint32_t tim_get_clock(const tim_peripheral_t tim);
+
+/**
+ *  @brief Configures the timer time base
+ *
+ *  The counter runs up from 0 to reload and restarts, so
+ *  the update rate is clock / (prescaler + 1) /
+ *  (reload + 1). The values are preloaded and take effect
+ *  right away through an update event. The 16-bit timers
+ *  only use the low half of reload.
+ *
+ *  @param tim The selected timer
+ *  @param prescaler The clock divider minus one
+ *  @param reload The counter period minus one
+ *  @return None
+ */
+void tim_configure_base(const tim_peripheral_t tim, const uint16_t prescaler,
+                        const uint32_t reload);
+
+/**
+ *  @brief Configures a channel as PWM output
+ *
+ *  PWM mode 1 is used: the output is active while the
+ *  counter is below compare. The output is active high
+ *  unless inverted. The main output of the advanced
+ *  timers is enabled as well. The pin has to be set to
+ *  the timer alternate function by the caller.
+ *
+ *  @param tim The selected timer
+ *  @param channel The selected channel
+ *  @param compare The compare value
+ *  @param invert Active low output
+ *  @return None
+ */
+void tim_configure_pwm(const tim_peripheral_t tim, const tim_channel_t channel,
+                       const uint32_t compare, const _Bool invert);
+
+/**
+ *  @brief Updates the compare value of a channel
+ *
+ *  The value is preloaded and used from the next period.
+ *
+ *  @param tim The selected timer
+ *  @param channel The selected channel
+ *  @param compare The compare value
+ *  @return None
+ */
+void tim_set_compare(const tim_peripheral_t tim, const tim_channel_t channel,
+                     const uint32_t compare);
+
+/**
+ *  @brief Enables timer DMA requests
+ *
+ *  The list of available requests is located under the
+ *  TIMDMARequests struct. Compare requests also fire for
+ *  channels that are not configured as outputs.
+ *
+ *  @param tim The selected timer
+ *  @param requests The DMA request config
+ *  @return None
+ */
+void tim_set_dma(const tim_peripheral_t tim,
+                 const struct TIMDMARequests requests);
+
+/**
+ *  @brief Starts the timer counter.
+ *
+ *  @param tim The selected timer
+ *  @return None
+ */
+void tim_start(const tim_peripheral_t tim);
+
+/**
+ *  @brief Stops the timer counter.
+ *
+ *  The counter is reset, so a restart begins a new period.
+ *
+ *  @param tim The selected timer
+ *  @return None
+ */
+void tim_stop(const tim_peripheral_t tim);
+
+#endif
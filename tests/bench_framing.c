@@ -0,0 +1,104 @@
+/** @file bench_framing.c
+ *  @brief Host throughput benchmark of the framing layer
+ *
+ *  Encodes and decodes random packets with COBS and SLIP
+ *  and prints the payload throughput. Not part of the
+ *  unit tests, run build/tests/bench_framing manually.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "framing.h"
+#include "crc.h"
+
+#define BENCH_PACKET_LEN 1024U
+#define BENCH_ROUNDS     20000U
+
+/* Register stubs of the drivers the framing links to */
+struct USARTRegs bench_usart_regs = {0};
+struct USARTRegs *USART(const uint32_t base) {
+  (void)base;
+  return &bench_usart_regs;
+}
+
+struct GPIORegs bench_gpio_regs = {0};
+struct GPIORegs *GPIO(const uint8_t bank) {
+  (void)bank;
+  return &bench_gpio_regs;
+}
+
+struct DMARegs bench_dma_regs = {0};
+struct DMARegs *DMA(const uint8_t num) {
+  (void)num;
+  return &bench_dma_regs;
+}
+
+struct CRCRegs bench_crc_regs = {0};
+struct CRCRegs *CRC_PTR = &bench_crc_regs;
+
+typedef uint32_t (*bench_encode_t)(const uint8_t *packet, const uint16_t length,
+                                   const frame_crc_t crc, uint8_t *out,
+                                   const uint32_t size);
+typedef frame_status_t (*bench_next_t)(struct FrameView *input,
+                                       const frame_crc_t crc,
+                                       struct FrameView *packet);
+
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((double)now.tv_sec + ((double)now.tv_nsec * 1e-9));
+}
+
+static void bench_run(const char *name, const bench_encode_t encode,
+                      const bench_next_t next, const frame_crc_t crc) {
+  static uint8_t packet[BENCH_PACKET_LEN];
+  static uint8_t frame[FRAME_SLIP_MAX(BENCH_PACKET_LEN + FRAME_CRC_LEN)];
+  uint32_t length = 0U;
+  uint32_t failures = 0U;
+
+  /* Roughly 1 in 64 bytes needs escaping */
+  srand(1U);
+  for (uint32_t i = 0U; i < BENCH_PACKET_LEN; i++) {
+    packet[i] = ((rand() & 63) == 0) ? 0xC0U : (uint8_t)(1 + (rand() % 190));
+  }
+
+  double start = bench_now();
+  for (uint32_t i = 0U; i < BENCH_ROUNDS; i++) {
+    length = encode(packet, BENCH_PACKET_LEN, crc, frame, sizeof(frame));
+  }
+  const double encoding = (bench_now() - start);
+
+  start = bench_now();
+  for (uint32_t i = 0U; i < BENCH_ROUNDS; i++) {
+    struct FrameView input = {.Ring = frame,
+                              .Size = sizeof(frame),
+                              .Length = (uint16_t)length};
+    struct FrameView view;
+
+    /* Decoding is destructive, re-encode outside the timing */
+    failures += (next(&input, crc, &view) != FRAME_OK);
+    const double pause = bench_now();
+    length = encode(packet, BENCH_PACKET_LEN, crc, frame, sizeof(frame));
+    start += (bench_now() - pause);
+  }
+  const double decoding = (bench_now() - start);
+
+  const double megabytes =
+      (((double)BENCH_PACKET_LEN * BENCH_ROUNDS) / (1024.0 * 1024.0));
+  printf("%-10s encode %8.1f MB/s  decode %8.1f MB/s  (%u errors)\n", name,
+         (megabytes / encoding), (megabytes / decoding), failures);
+}
+
+int main(void) {
+  bench_run("cobs", frame_cobs_encode, frame_cobs_next, NULL);
+  bench_run("cobs+crc", frame_cobs_encode, frame_cobs_next, crc_update_soft);
+  bench_run("slip", frame_slip_encode, frame_slip_next, NULL);
+  bench_run("slip+crc", frame_slip_encode, frame_slip_next, crc_update_soft);
+
+  return 0;
+}
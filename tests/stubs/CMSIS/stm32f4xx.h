@@ -57,6 +57,8 @@
 #define DMA_SxCR_PINC_Msk   (0x1UL << DMA_SxCR_PINC_Pos)
 #define DMA_SxCR_DBM_Pos    (18U)
 #define DMA_SxCR_DBM_Msk    (0x1UL << DMA_SxCR_DBM_Pos)
+#define DMA_SxCR_CT_Pos     (19U)
+#define DMA_SxCR_CT_Msk     (0x1UL << DMA_SxCR_CT_Pos)
 #define DMA_SxCR_PFCTRL_Pos (5U)
 #define DMA_SxCR_PFCTRL_Msk (0x1UL << DMA_SxCR_PFCTRL_Pos)
 #define DMA_SxCR_CHSEL_Pos  (25U)
@@ -85,6 +87,8 @@
 #define USART_CR1_TE_Msk     (0x1UL << USART_CR1_TE_Pos)
 #define USART_CR1_RE_Pos     (2U)
 #define USART_CR1_RE_Msk     (0x1UL << USART_CR1_RE_Pos)
+#define USART_CR1_OVER8_Pos  (15U)
+#define USART_CR1_OVER8_Msk  (0x1UL << USART_CR1_OVER8_Pos)
 #define USART_CR1_UE_Pos     (13U)
 #define USART_CR1_UE_Msk     (0x1UL << USART_CR1_UE_Pos)
 #define USART_CR1_PEIE_Pos   (8U)
@@ -100,11 +104,21 @@
 #define USART_CR1_M_Pos      (12U)
 #define USART_CR1_M_Msk      (0x1UL << USART_CR1_M_Pos)
 #define USART_CR1_PS_Msk     (0x1UL << (9U))
+#define USART_CR1_WAKE_Pos   (11U)
+#define USART_CR1_WAKE_Msk   (0x1UL << USART_CR1_WAKE_Pos)
+#define USART_CR1_RWU_Pos    (1U)
+#define USART_CR1_RWU_Msk    (0x1UL << USART_CR1_RWU_Pos)
+#define USART_CR2_ADD_Pos    (0U)
+#define USART_CR2_ADD_Msk    (0xFUL << USART_CR2_ADD_Pos)
 #define USART_CR1_PCE_Msk    (0x1UL << (10U))
 #define USART_CR2_LBDIE_Pos  (6U)
 #define USART_CR2_LBDIE_Msk  (0x1UL << USART_CR2_LBDIE_Pos)
 #define USART_CR2_STOP_Pos   (12U)
 #define USART_CR2_STOP_Msk   (0x3UL << USART_CR2_STOP_Pos)
+#define USART_CR3_CTSE_Pos   (9U)
+#define USART_CR3_CTSE_Msk   (0x1UL << USART_CR3_CTSE_Pos)
+#define USART_CR3_RTSE_Pos   (8U)
+#define USART_CR3_RTSE_Msk   (0x1UL << USART_CR3_RTSE_Pos)
 #define USART_CR3_CTSIE_Pos  (10U)
 #define USART_CR3_CTSIE_Msk  (0x1UL << USART_CR3_CTSIE_Pos)
 #define USART_CR3_EIE_Pos    (0U)
@@ -113,9 +127,16 @@
 #define USART_CR3_DMAT_Msk   (0x1UL << USART_CR3_DMAT_Pos)
 #define USART_CR3_DMAR_Pos   (6U)
 #define USART_CR3_DMAR_Msk   (0x1UL << USART_CR3_DMAR_Pos)
+#define USART_SR_CTS_Msk     (0x1UL << (9U))
+#define USART_SR_LBD_Msk     (0x1UL << (8U))
 #define USART_SR_TXE_Msk     (0x1UL << (7U))
 #define USART_SR_TC_Msk      (0x1UL << (6U))
 #define USART_SR_RXNE_Msk    (0x1UL << (5U))
+#define USART_SR_IDLE_Msk    (0x1UL << (4U))
+#define USART_SR_ORE_Msk     (0x1UL << (3U))
+#define USART_SR_NE_Msk      (0x1UL << (2U))
+#define USART_SR_FE_Msk      (0x1UL << (1U))
+#define USART_SR_PE_Msk      (0x1UL << (0U))
 
 /* bxCAN */
 #define CAN1_BASE          (0UL)
@@ -140,17 +161,23 @@
 #define CAN_BTR_TS1_Msk    (0xFUL << CAN_BTR_TS1_Pos)
 #define CAN_BTR_TS2_Pos    (20U)
 #define CAN_BTR_TS2_Msk    (0x7UL << CAN_BTR_TS2_Pos)
-#define CAN_BTR_SJW_Msk    (0x3UL << (24U))
+#define CAN_BTR_SJW_Pos    (24U)
+#define CAN_BTR_SJW_Msk    (0x3UL << CAN_BTR_SJW_Pos)
 #define CAN_BTR_LBKM_Pos   (30U)
 #define CAN_BTR_LBKM_Msk   (0x1UL << CAN_BTR_LBKM_Pos)
 #define CAN_BTR_SILM_Msk   (0x1UL << (31U))
 #define CAN_IER_TMEIE_Pos  (0U)
+#define CAN_IER_TMEIE_Msk  (0x1UL << CAN_IER_TMEIE_Pos)
 #define CAN_IER_FMPIE0_Pos (1U)
+#define CAN_IER_FMPIE0_Msk (0x1UL << CAN_IER_FMPIE0_Pos)
 #define CAN_IER_FFIE0_Pos  (2U)
 #define CAN_IER_FOVIE0_Pos (3U)
+#define CAN_IER_FOVIE0_Msk (0x1UL << CAN_IER_FOVIE0_Pos)
 #define CAN_IER_FMPIE1_Pos (4U)
+#define CAN_IER_FMPIE1_Msk (0x1UL << CAN_IER_FMPIE1_Pos)
 #define CAN_IER_FFIE1_Pos  (5U)
 #define CAN_IER_FOVIE1_Pos (6U)
+#define CAN_IER_FOVIE1_Msk (0x1UL << CAN_IER_FOVIE1_Pos)
 #define CAN_IER_EWGIE_Pos  (8U)
 #define CAN_IER_EPVIE_Pos  (9U)
 #define CAN_IER_BOFIE_Pos  (10U)
@@ -161,15 +188,28 @@
 #define CAN_FMR_FINIT_Msk  (0x1UL << (0U))
 #define CAN_FMR_CAN2SB_Pos (8U)
 #define CAN_FMR_CAN2SB_Msk (0x3FUL << CAN_FMR_CAN2SB_Pos)
+#define CAN_TSR_RQCP0_Msk  (0x1UL << (0U))
+#define CAN_TSR_TXOK0_Msk  (0x1UL << (1U))
+#define CAN_TSR_ALST0_Msk  (0x1UL << (2U))
+#define CAN_TSR_TERR0_Msk  (0x1UL << (3U))
+#define CAN_TSR_ABRQ0_Msk  (0x1UL << (7U))
 #define CAN_TSR_TME0_Msk   (0x1UL << (26U))
 #define CAN_TSR_TME1_Msk   (0x1UL << (27U))
 #define CAN_TSR_TME2_Msk   (0x1UL << (28U))
 #define CAN_TI0R_TXRQ_Msk  (0x1UL << (0U))
+#define CAN_TDT0R_DLC_Msk  (0xFUL << (0U))
 #define CAN_TDT0R_TGT_Pos  (8U)
+#define CAN_RI0R_RTR_Pos   (1U)
+#define CAN_RI0R_RTR_Msk   (0x1UL << CAN_RI0R_RTR_Pos)
 #define CAN_RI0R_IDE_Pos   (2U)
 #define CAN_RI0R_EXID_Pos  (3U)
 #define CAN_RI0R_STID_Pos  (21U)
+#define CAN_RF0R_FMP0_Msk  (0x3UL << (0U))
+#define CAN_RF0R_FULL0_Msk (0x1UL << (3U))
+#define CAN_RF0R_FOVR0_Msk (0x1UL << (4U))
 #define CAN_RF0R_RFOM0_Msk (0x1UL << (5U))
+#define CAN_RDT0R_FMI_Pos  (8U)
+#define CAN_RDT0R_FMI_Msk  (0xFFUL << CAN_RDT0R_FMI_Pos)
 #define CAN_RDT0R_TIME_Pos (16U)
 #define CAN_ESR_EWGF_Pos   (0U)
 #define CAN_ESR_EPVF_Pos   (1U)
@@ -180,6 +220,9 @@
 
 /* SPI */
 #define SPI1_BASE            (0UL)
+#define SPI2_BASE            (1UL)
+#define SPI3_BASE            (2UL)
+#define SPI4_BASE            (3UL)
 #define SPI_CR1_CPHA_Pos     (0U)
 #define SPI_CR1_CPHA_Msk     (0x1UL << SPI_CR1_CPHA_Pos)
 #define SPI_CR1_CPOL_Pos     (1U)
@@ -196,6 +239,7 @@
 #define SPI_CR1_RXONLY_Msk   (0x1UL << (10U))
 #define SPI_CR1_DFF_Pos      (11U)
 #define SPI_CR1_DFF_Msk      (0x1UL << SPI_CR1_DFF_Pos)
+#define SPI_CR1_CRCNEXT_Msk  (0x1UL << (12U))
 #define SPI_CR1_CRCEN_Pos    (13U)
 #define SPI_CR1_CRCEN_Msk    (0x1UL << SPI_CR1_CRCEN_Pos)
 #define SPI_CR1_BIDIOE_Msk   (0x1UL << (14U))
@@ -215,8 +259,14 @@
 #define SPI_CR2_TXEIE_Msk    (0x1UL << SPI_CR2_TXEIE_Pos)
 #define SPI_SR_TXE_Msk       (0x1UL << (1U))
 #define SPI_SR_RXNE_Msk      (0x1UL << (0U))
+#define SPI_SR_CRCERR_Msk    (0x1UL << (4U))
 #define SPI_SR_BSY_Msk       (0x1UL << (7U))
 
+/* CRC */
+#define CRC_BASE            (0UL)
+#define CRC_CR_RESET_Pos    (0U)
+#define CRC_CR_RESET_Msk    (0x1UL << CRC_CR_RESET_Pos)
+
 /* RCC */
 #define RCC_BASE            (0UL)
 #define RCC_CR_HSEBYP_Msk   (0x1UL << (18U))
@@ -293,6 +343,71 @@
 #define RCC_APB2ENR_USART1EN_Msk (0x1UL << (4U))
 #define RCC_APB2ENR_USART6EN_Msk (0x1UL << (5U))
 
+/* EXTI */
+#define EXTI_BASE   (0UL)
+#define SYSCFG_BASE (0UL)
+
+/* QUADSPI */
+#define QSPI_R_BASE                 (0UL)
+#define QUADSPI_CR_EN_Msk           (0x1UL << (0U))
+#define QUADSPI_CR_ABORT_Msk        (0x1UL << (1U))
+#define QUADSPI_CR_DMAEN_Msk        (0x1UL << (2U))
+#define QUADSPI_CR_TCEN_Msk         (0x1UL << (3U))
+#define QUADSPI_CR_SSHIFT_Msk       (0x1UL << (4U))
+#define QUADSPI_CR_FTHRES_Msk       (0xFUL << (8U))
+#define QUADSPI_CR_APMS_Msk         (0x1UL << (22U))
+#define QUADSPI_CR_PMM_Msk          (0x1UL << (23U))
+#define QUADSPI_CR_PRESCALER_Pos    (24U)
+#define QUADSPI_CR_PRESCALER_Msk    (0xFFUL << QUADSPI_CR_PRESCALER_Pos)
+#define QUADSPI_DCR_CKMODE_Pos      (0U)
+#define QUADSPI_DCR_CSHT_Pos        (8U)
+#define QUADSPI_DCR_FSIZE_Pos       (16U)
+#define QUADSPI_SR_TEF_Msk          (0x1UL << (0U))
+#define QUADSPI_SR_TCF_Msk          (0x1UL << (1U))
+#define QUADSPI_SR_FTF_Msk          (0x1UL << (2U))
+#define QUADSPI_SR_SMF_Msk          (0x1UL << (3U))
+#define QUADSPI_SR_BUSY_Msk         (0x1UL << (5U))
+#define QUADSPI_FCR_CTEF_Msk        (0x1UL << (0U))
+#define QUADSPI_FCR_CTCF_Msk        (0x1UL << (1U))
+#define QUADSPI_FCR_CSMF_Msk        (0x1UL << (3U))
+#define QUADSPI_CCR_INSTRUCTION_Pos (0U)
+#define QUADSPI_CCR_IMODE_Pos       (8U)
+#define QUADSPI_CCR_ADMODE_Pos      (10U)
+#define QUADSPI_CCR_ADSIZE_Pos      (12U)
+#define QUADSPI_CCR_ABMODE_Pos      (14U)
+#define QUADSPI_CCR_ABSIZE_Pos      (16U)
+#define QUADSPI_CCR_DCYC_Pos        (18U)
+#define QUADSPI_CCR_DMODE_Pos       (24U)
+#define QUADSPI_CCR_FMODE_Pos       (26U)
+#define QUADSPI_CCR_FMODE_Msk       (0x3UL << QUADSPI_CCR_FMODE_Pos)
+#define QUADSPI_CCR_SIOO_Pos        (28U)
+#define QUADSPI_CCR_DDRM_Pos        (31U)
+
+/* TIM */
+#define TIM1_BASE           (0UL)
+#define TIM2_BASE           (1UL)
+#define TIM_CR1_CEN_Msk     (0x1UL << (0U))
+#define TIM_CR1_ARPE_Msk    (0x1UL << (7U))
+#define TIM_EGR_UG_Msk      (0x1UL << (0U))
+#define TIM_DIER_UDE_Pos    (8U)
+#define TIM_DIER_UDE_Msk    (0x1UL << TIM_DIER_UDE_Pos)
+#define TIM_DIER_CC1DE_Pos  (9U)
+#define TIM_DIER_CC1DE_Msk  (0x1UL << TIM_DIER_CC1DE_Pos)
+#define TIM_DIER_CC2DE_Pos  (10U)
+#define TIM_DIER_CC2DE_Msk  (0x1UL << TIM_DIER_CC2DE_Pos)
+#define TIM_DIER_CC3DE_Pos  (11U)
+#define TIM_DIER_CC3DE_Msk  (0x1UL << TIM_DIER_CC3DE_Pos)
+#define TIM_DIER_CC4DE_Pos  (12U)
+#define TIM_DIER_CC4DE_Msk  (0x1UL << TIM_DIER_CC4DE_Pos)
+#define TIM_CCMR1_CC1S_Msk  (0x3UL << (0U))
+#define TIM_CCMR1_OC1PE_Msk (0x1UL << (3U))
+#define TIM_CCMR1_OC1M_Pos  (4U)
+#define TIM_CCMR1_OC1M_Msk  (0x7UL << TIM_CCMR1_OC1M_Pos)
+#define TIM_CCER_CC1E_Msk   (0x1UL << (0U))
+#define TIM_CCER_CC1P_Pos   (1U)
+#define TIM_CCER_CC1P_Msk   (0x1UL << TIM_CCER_CC1P_Pos)
+#define TIM_BDTR_MOE_Msk    (0x1UL << (15U))
+
 /* PWR */
 /**
  * @brief Contains stubbed PWR registers.
@@ -332,8 +447,88 @@ typedef struct {
 
 #define SCB ((SCB_TypeDef *)(0UL))
 
+/* DWT */
+/**
+ * @brief Contains stubbed DWT and debug registers.
+ */
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk      (0x1UL << (0U))
+#define CoreDebug_DEMCR_TRCENA_Msk  (0x1UL << (24U))
+
+/* IRQn */
+/**
+ * @brief Contains stubbed interrupt numbers.
+ */
+typedef enum {
+  EXTI0_IRQn = 6,
+  EXTI1_IRQn = 7,
+  EXTI2_IRQn = 8,
+  EXTI3_IRQn = 9,
+  EXTI4_IRQn = 10,
+  DMA1_Stream0_IRQn = 11,
+  DMA1_Stream1_IRQn = 12,
+  DMA1_Stream2_IRQn = 13,
+  DMA1_Stream3_IRQn = 14,
+  DMA1_Stream4_IRQn = 15,
+  DMA1_Stream5_IRQn = 16,
+  DMA1_Stream6_IRQn = 17,
+  CAN1_TX_IRQn = 19,
+  CAN1_RX0_IRQn = 20,
+  CAN1_RX1_IRQn = 21,
+  EXTI9_5_IRQn = 23,
+  USART1_IRQn = 37,
+  USART2_IRQn = 38,
+  USART3_IRQn = 39,
+  EXTI15_10_IRQn = 40,
+  DMA1_Stream7_IRQn = 47,
+  UART4_IRQn = 52,
+  UART5_IRQn = 53,
+  DMA2_Stream0_IRQn = 56,
+  DMA2_Stream1_IRQn = 57,
+  DMA2_Stream2_IRQn = 58,
+  DMA2_Stream3_IRQn = 59,
+  DMA2_Stream4_IRQn = 60,
+  DMA2_Stream5_IRQn = 68,
+  DMA2_Stream6_IRQn = 69,
+  DMA2_Stream7_IRQn = 70,
+  USART6_IRQn = 71
+} IRQn_Type;
+
 /* CMSIS GCC */
 __attribute__((always_inline)) static inline void __enable_irq(void) { return; }
+__attribute__((always_inline)) static inline void __disable_irq(void) {
+  return;
+}
+__attribute__((always_inline)) static inline uint32_t __get_PRIMASK(void) {
+  return 0UL;
+}
+__attribute__((always_inline)) static inline void
+__set_PRIMASK(uint32_t priMask) {
+  (void)priMask;
+}
+
+/* CMSIS CM4 NVIC */
+__attribute__((always_inline)) static inline void
+NVIC_EnableIRQ(IRQn_Type IRQn) {
+  (void)IRQn;
+}
+__attribute__((always_inline)) static inline void
+NVIC_DisableIRQ(IRQn_Type IRQn) {
+  (void)IRQn;
+}
+__attribute__((always_inline)) static inline void
+NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) {
+  (void)IRQn;
+  (void)priority;
+}
 
 /* CMSIS CM4 */
 __attribute__((always_inline)) static inline uint32_t
@@ -0,0 +1,563 @@
+/** @file test_bxcan_driver.c
+ *  @brief Unit tests for the bxCAN driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "bxcan.h"
+
+struct bxCANRegs test_can_regs[BXCAN_PERIPH_LEN] = {0};
+
+struct bxCANRegs *CAN(const uint8_t num) { return &test_can_regs[num]; }
+
+/* Cycle counter of the statistics */
+DWT_Type test_dwt_regs = {0};
+DWT_Type *DWT_PTR = &test_dwt_regs;
+
+void Test_BXCANBitrate_EdgeCase_SolverShouldMatchMacro(void) {
+  /* 45 MHz: 500k in 18 quanta, 1M in 15 */
+  const struct bxCANBitrateConfig fixed[2] = {
+      BXCAN_BITRATE_CLK(45000000UL, 500000UL, 875UL),
+      BXCAN_BITRATE_CLK(45000000UL, 1000000UL, 875UL),
+  };
+  struct bxCANBitrateConfig solved = {0};
+
+  TEST_ASSERT_EQUAL_UINT8(14U, fixed[0].TimeSeg1);
+  TEST_ASSERT_EQUAL_UINT8(1U, fixed[0].TimeSeg2);
+  TEST_ASSERT_EQUAL_UINT16(4U, fixed[0].BaudPrescaler);
+  TEST_ASSERT_EQUAL_UINT8(1U, fixed[0].SyncJump);
+  TEST_ASSERT_EQUAL_UINT8(11U, fixed[1].TimeSeg1);
+  TEST_ASSERT_EQUAL_UINT16(2U, fixed[1].BaudPrescaler);
+
+  for (uint8_t i = 0U; i < 2U; i++) {
+    TEST_ASSERT_TRUE(bxcan_bitrate_solve(45000000UL, (500000UL << i), 875U,
+                                         &solved));
+    TEST_ASSERT_EQUAL_UINT8(fixed[i].TimeSeg1, solved.TimeSeg1);
+    TEST_ASSERT_EQUAL_UINT8(fixed[i].TimeSeg2, solved.TimeSeg2);
+    TEST_ASSERT_EQUAL_UINT16(fixed[i].BaudPrescaler, solved.BaudPrescaler);
+    TEST_ASSERT_EQUAL_UINT8(fixed[i].SyncJump, solved.SyncJump);
+  }
+
+  /* The jump width tops out at 4 quanta */
+  TEST_ASSERT_TRUE(bxcan_bitrate_solve(45000000UL, 125000UL, 500U, &solved));
+  TEST_ASSERT_EQUAL_UINT8(3U, solved.SyncJump);
+}
+
+void Test_BXCANBitrate_RateIsUnreachable_SolverShouldFail(void) {
+  struct bxCANBitrateConfig solved = {0};
+
+  TEST_ASSERT_FALSE(bxcan_bitrate_solve(45000000UL, 700001UL, 875U, &solved));
+  TEST_ASSERT_FALSE(bxcan_bitrate_solve(45000000UL, 1000UL, 875U, &solved));
+  TEST_ASSERT_FALSE(bxcan_bitrate_solve(45000000UL, 0UL, 875U, &solved));
+  TEST_ASSERT_FALSE(bxcan_bitrate_solve(0UL, 500000UL, 875U, &solved));
+  TEST_ASSERT_FALSE(bxcan_bitrate_solve(45000000UL, 45000000UL, 875U,
+                                        &solved));
+  TEST_ASSERT_EQUAL_UINT32(0UL, BXCAN_TQ(0UL, 500000UL, 875UL));
+}
+
+void Test_BXCANConfigureBitrate_EdgeCase_RegistersShouldSetProperly(void) {
+  bxcan_configure_bitrate(BXCAN_PERIPH_1, BXCAN_BITRATE(500000UL, 875UL));
+
+  TEST_ASSERT_EQUAL_HEX32(((1UL << CAN_BTR_SJW_Pos) | (1UL << CAN_BTR_TS2_Pos) |
+                           (14UL << CAN_BTR_TS1_Pos) | 4UL),
+                          test_can_regs[0].BTR);
+}
+
+void Test_BXCANFilterPlan_EdgeCase_RegistersShouldSetProperly(void) {
+  const struct bxCANFilterRule rules[] = {
+      {.First = 0x100U, .Last = 0x103U},
+      {.First = 0x7FFU, .Last = 0x7FFU},
+  };
+
+  test_can_regs[0].FA1R = (BIT(0) | BIT(3) | BIT(4));
+  TEST_ASSERT_EQUAL_UINT8(1U, bxcan_filter_plan(BXCAN_PERIPH_1, rules, 2U,
+                                                2U, 3U));
+
+  /* Range block and single ID share a 16-bit mask bank */
+  TEST_ASSERT_EQUAL_HEX32(0xFF982000UL, test_can_regs[0].FilterBank[2].FR1);
+  TEST_ASSERT_EQUAL_HEX32(0xFFF8FFE0UL, test_can_regs[0].FilterBank[2].FR2);
+  TEST_ASSERT_EQUAL_HEX32((BIT(0) | BIT(2)), test_can_regs[0].FA1R);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_can_regs[0].FM1R);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_can_regs[0].FS1R);
+  TEST_ASSERT_EQUAL_HEX32((14UL << CAN_FMR_CAN2SB_Pos), test_can_regs[0].FMR);
+}
+
+void Test_BXCANFilterPlan_BanksRunOut_BlocksShouldMerge(void) {
+  struct bxCANFilterRule rules[6];
+  for (uint8_t i = 0U; i < 6U; i++) {
+    rules[i] = (struct bxCANFilterRule){
+        .First = (0x10U + i), .Last = (0x10U + i), .FIFO = TRUE};
+  }
+
+  /* Two list banks needed, the merges still accept just the six */
+  TEST_ASSERT_EQUAL_UINT8(1U, bxcan_filter_plan(BXCAN_PERIPH_1, rules, 6U,
+                                                0U, 1U));
+  TEST_ASSERT_EQUAL_HEX32(0xFF580200UL, test_can_regs[0].FilterBank[0].FR1);
+  TEST_ASSERT_EQUAL_HEX32(0xFFD80240UL, test_can_regs[0].FilterBank[0].FR2);
+  TEST_ASSERT_EQUAL_HEX32(BIT(0), test_can_regs[0].FFA1R);
+}
+
+void Test_BXCANFilterPlan_RulesAreInvalid_RegistersShouldNotSet(void) {
+  const struct bxCANFilterRule split[] = {
+      {.First = 0x001U, .Last = 0x001U},
+      {.First = 0x1000U, .Last = 0x1000U, .IDE = TRUE, .FIFO = TRUE},
+  };
+  const struct bxCANFilterRule reversed = {.First = 0x002U, .Last = 0x001U};
+  const struct bxCANFilterRule wide = {.First = 0x000U, .Last = 0x800U};
+
+  /* Different FIFOs can never share a bank */
+  TEST_ASSERT_EQUAL_UINT8(0U, bxcan_filter_plan(BXCAN_PERIPH_1, split, 2U,
+                                                0U, 1U));
+  TEST_ASSERT_EQUAL_UINT8(0U, bxcan_filter_plan(BXCAN_PERIPH_1, &reversed,
+                                                1U, 0U, 1U));
+  TEST_ASSERT_EQUAL_UINT8(0U, bxcan_filter_plan(BXCAN_PERIPH_1, &wide, 1U,
+                                                0U, 1U));
+  TEST_ASSERT_EQUAL_UINT8(0U, bxcan_filter_plan(BXCAN_PERIPH_1, split, 2U,
+                                                27U, 2U));
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_can_regs[0].FA1R);
+}
+
+void Test_BXCANFilterPlan_RangeCrossesSplit_RegistersShouldNotSet(void) {
+  const struct bxCANFilterRule rule = {.First = 0x100U, .Last = 0x100U};
+
+  /* Banks 14 and up belong to CAN2 */
+  test_can_regs[0].FA1R = BIT(14);
+  TEST_ASSERT_EQUAL_UINT8(0U, bxcan_filter_plan(BXCAN_PERIPH_1, &rule, 1U,
+                                                12U, 3U));
+  TEST_ASSERT_EQUAL_HEX32(BIT(14), test_can_regs[0].FA1R);
+
+  /* Right up to the split is fine */
+  TEST_ASSERT_EQUAL_UINT8(1U, bxcan_filter_plan(BXCAN_PERIPH_1, &rule, 1U,
+                                                12U, 2U));
+  TEST_ASSERT_EQUAL_HEX32((BIT(12) | BIT(14)), test_can_regs[0].FA1R);
+
+  /* A smaller CAN1 share moves the limit */
+  bxcan_set_filter_start(BXCAN_PERIPH_1, 4U);
+  TEST_ASSERT_EQUAL_UINT8(0U, bxcan_filter_plan(BXCAN_PERIPH_1, &rule, 1U,
+                                                2U, 3U));
+}
+
+static uint32_t test_handled[2] = {0U};
+
+static void test_handler_a(const bxcan_peripheral_t can,
+                           const struct bxCANFrame *frame) {
+  (void)can;
+  test_handled[0] = frame->ID;
+}
+
+static void test_handler_b(const bxcan_peripheral_t can,
+                           const struct bxCANFrame *frame) {
+  (void)can;
+  test_handled[1] = frame->ID;
+}
+
+void Test_BXCANRxDispatch_EdgeCase_HandlersShouldFollowFMI(void) {
+  const struct bxCANFilterRule rules[] = {
+      {.First = 0x100U, .Last = 0x100U, .Handler = test_handler_a},
+      {.First = 0x200U, .Last = 0x200U, .Handler = test_handler_b,
+       .FIFO = TRUE},
+  };
+  struct bxCANMailboxRegs buffer = {0};
+
+  /* Bank 0 is a FIFO0 16-bit list owning indexes 0..3 */
+  test_can_regs[0].FM1R = BIT(0);
+  TEST_ASSERT_EQUAL_UINT8(2U, bxcan_filter_plan(BXCAN_PERIPH_1, rules, 2U,
+                                                1U, 4U));
+
+  buffer.IR = (0x100UL << CAN_RI0R_STID_Pos);
+  buffer.TR = (4UL << CAN_RDT0R_FMI_Pos);
+  TEST_ASSERT_TRUE(bxcan_rx_dispatch(BXCAN_PERIPH_1, buffer));
+  TEST_ASSERT_EQUAL_HEX32(0x100U, test_handled[0]);
+
+  buffer.IR = (0x200UL << CAN_RI0R_STID_Pos);
+  buffer.TR = ((0UL << CAN_RDT0R_FMI_Pos) | BXCAN_RX_FIFO_Msk);
+  TEST_ASSERT_TRUE(bxcan_rx_dispatch(BXCAN_PERIPH_1, buffer));
+  TEST_ASSERT_EQUAL_HEX32(0x200U, test_handled[1]);
+
+  /* Index 0 of FIFO0 belongs to the foreign bank */
+  buffer.TR = 0UL;
+  TEST_ASSERT_FALSE(bxcan_rx_dispatch(BXCAN_PERIPH_1, buffer));
+}
+
+static void test_rx_pending(const uint8_t fifo, const uint32_t id) {
+  /* One pending frame, the handler releases it */
+  test_can_regs[0].FIFOMailbox[fifo].IR = (id << CAN_RI0R_STID_Pos);
+  test_can_regs[0].FIFOMailbox[fifo].TR = (8U | (3UL << CAN_RDT0R_FMI_Pos));
+  test_can_regs[0].FIFOMailbox[fifo].LR = 0x03020100UL;
+  test_can_regs[0].FIFOMailbox[fifo].HR = 0x07060504UL;
+  test_can_regs[0].RFR[fifo] = 1U;
+}
+
+void Test_BXCANRxRing_EdgeCase_RegistersShouldSetProperly(void) {
+  test_can_regs[0].IER = CAN_IER_TMEIE_Msk;
+  bxcan_rx_ring_start(BXCAN_PERIPH_1);
+
+  TEST_ASSERT_EQUAL_HEX32((CAN_IER_FMPIE0_Msk | CAN_IER_FOVIE0_Msk |
+                           CAN_IER_FMPIE1_Msk | CAN_IER_FOVIE1_Msk |
+                           CAN_IER_TMEIE_Msk),
+                          test_can_regs[0].IER);
+
+  bxcan_rx_ring_stop(BXCAN_PERIPH_1);
+  TEST_ASSERT_EQUAL_HEX32(CAN_IER_TMEIE_Msk, test_can_regs[0].IER);
+}
+
+void Test_BXCANRxRing_EdgeCase_FramesShouldPopInOrder(void) {
+  struct bxCANMailboxRegs buffer = {0};
+  struct bxCANFrame frame = {0};
+
+  test_rx_pending(0U, 0x123U);
+  CAN1_RX0_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(CAN_RF0R_RFOM0_Msk, test_can_regs[0].RFR[0]);
+
+  test_rx_pending(1U, 0x456U);
+  CAN1_RX1_IRQHandler();
+  TEST_ASSERT_EQUAL_UINT32(2U, bxcan_rx_ring_pending(BXCAN_PERIPH_1));
+
+  TEST_ASSERT_TRUE(bxcan_rx_ring_pop(BXCAN_PERIPH_1, &buffer));
+  bxcan_rx_frame_process(buffer, &frame);
+  TEST_ASSERT_EQUAL_HEX32(0x123U, frame.ID);
+  TEST_ASSERT_EQUAL_UINT8(8U, frame.DLC);
+  TEST_ASSERT_EQUAL_UINT8(3U, frame.FMI);
+  TEST_ASSERT_EQUAL_HEX8(0x07U, frame.DATA[7]);
+
+  TEST_ASSERT_TRUE(bxcan_rx_ring_pop(BXCAN_PERIPH_1, &buffer));
+  bxcan_rx_frame_process(buffer, &frame);
+  TEST_ASSERT_EQUAL_HEX32(0x456U, frame.ID);
+
+  TEST_ASSERT_FALSE(bxcan_rx_ring_pop(BXCAN_PERIPH_1, &buffer));
+}
+
+void Test_BXCANRxRing_RingIsFull_FramesShouldBeDropped(void) {
+  for (uint32_t i = 0U; i < (BXCAN_RX_RING_LEN + 2U); i++) {
+    test_rx_pending(0U, i);
+    CAN1_RX0_IRQHandler();
+  }
+
+  /* Dropped frames still leave the hardware FIFO */
+  TEST_ASSERT_EQUAL_UINT32(BXCAN_RX_RING_LEN,
+                           bxcan_rx_ring_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(2U, bxcan_rx_ring_dropped(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_HEX32(CAN_RF0R_RFOM0_Msk, test_can_regs[0].RFR[0]);
+}
+
+void Test_BXCANRxRing_FIFOOverrun_ShouldCountAndClear(void) {
+  test_can_regs[0].RFR[1] = (CAN_RF0R_FOVR0_Msk | CAN_RF0R_FULL0_Msk);
+  CAN1_RX1_IRQHandler();
+
+  TEST_ASSERT_EQUAL_UINT32(1U, bxcan_rx_fifo_overruns(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_HEX32(CAN_RF0R_FOVR0_Msk, test_can_regs[0].RFR[1]);
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_rx_ring_pending(BXCAN_PERIPH_1));
+}
+
+void Test_BXCANRoute_EdgeCase_FramesShouldForwardRaw(void) {
+  const struct bxCANRoute rewrite = {.ID = 0x0ABU, .Rewrite = TRUE};
+  const struct bxCANRoute local = {.Local = TRUE};
+
+  /* Straight into the free mailbox, FMI stripped */
+  bxcan_set_route(BXCAN_PERIPH_1, 0U, 3U, &rewrite);
+  test_can_regs[0].TSR = CAN_TSR_TME1_Msk;
+  test_rx_pending(0U, 0x123U);
+  CAN1_RX0_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(((0x0ABUL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[1].IR);
+  TEST_ASSERT_EQUAL_HEX32(8U, test_can_regs[0].TxMailbox[1].TR);
+  TEST_ASSERT_EQUAL_HEX32(0x03020100UL, test_can_regs[0].TxMailbox[1].LR);
+  TEST_ASSERT_EQUAL_HEX32(0x07060504UL, test_can_regs[0].TxMailbox[1].HR);
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_rx_ring_pending(BXCAN_PERIPH_1));
+
+  /* Mailboxes busy, queued and kept locally as well */
+  bxcan_set_route(BXCAN_PERIPH_1, 0U, 3U, &local);
+  test_can_regs[0].TSR = 0UL;
+  test_rx_pending(0U, 0x123U);
+  CAN1_RX0_IRQHandler();
+  TEST_ASSERT_EQUAL_UINT32(1U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(1U, bxcan_rx_ring_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_route_dropped(BXCAN_PERIPH_1));
+
+  bxcan_set_route(BXCAN_PERIPH_1, 0U, 3U, NULL);
+}
+
+static _Bool test_tx_push(const uint32_t id) {
+  struct bxCANFrame frame = {.ID = id, .DLC = 1U, .DATA = {(uint8_t)id}};
+  return bxcan_tx_queue_push(BXCAN_PERIPH_1, &frame);
+}
+
+void Test_BXCANTxQueue_EdgeCase_MailboxesShouldFillByPriority(void) {
+  /* Mailbox 1 busy */
+  test_can_regs[0].TSR = (CAN_TSR_TME0_Msk | CAN_TSR_TME2_Msk);
+  TEST_ASSERT_TRUE(test_tx_push(0x300U));
+  TEST_ASSERT_EQUAL_HEX32(((0x300UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[0].IR);
+  TEST_ASSERT_EQUAL_HEX32(0x1U, test_can_regs[0].TxMailbox[0].TR);
+  TEST_ASSERT_EQUAL_HEX32(0x00U, test_can_regs[0].TxMailbox[0].LR);
+
+  test_can_regs[0].TSR = 0UL;
+  TEST_ASSERT_TRUE(test_tx_push(0x500U));
+  TEST_ASSERT_TRUE(test_tx_push(0x400U));
+  TEST_ASSERT_EQUAL_UINT32(3U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+
+  /* Mailbox 0 sent, the queue head takes its place */
+  test_can_regs[0].TSR =
+      (CAN_TSR_RQCP0_Msk | CAN_TSR_TXOK0_Msk | CAN_TSR_TME0_Msk);
+  CAN1_TX_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(((0x400UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[0].IR);
+  TEST_ASSERT_EQUAL_UINT32(2U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+}
+
+void Test_BXCANTxQueue_UrgentFrame_ShouldPreemptLowestMailbox(void) {
+  /* Loaded mailboxes are not empty anymore */
+  test_can_regs[0].TSR = CAN_TSR_TME0_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x200U));
+  test_can_regs[0].TSR = CAN_TSR_TME1_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x700U));
+  test_can_regs[0].TSR = CAN_TSR_TME2_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x100U));
+
+  /* All busy, 0x700 in mailbox 1 is the one to go */
+  test_can_regs[0].TSR = 0UL;
+  TEST_ASSERT_TRUE(test_tx_push(0x050U));
+  TEST_ASSERT_EQUAL_HEX32((CAN_TSR_ABRQ0_Msk << 8U), test_can_regs[0].TSR);
+
+  /* Abort done, the urgent frame is loaded */
+  test_can_regs[0].TSR = ((CAN_TSR_RQCP0_Msk << 8U) | CAN_TSR_TME1_Msk);
+  CAN1_TX_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(((0x050UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[1].IR);
+  TEST_ASSERT_EQUAL_UINT32(4U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_tx_queue_failed(BXCAN_PERIPH_1));
+
+  /* The aborted frame comes back once a mailbox frees up */
+  test_can_regs[0].TSR =
+      (CAN_TSR_RQCP0_Msk | CAN_TSR_TXOK0_Msk | CAN_TSR_TME0_Msk);
+  CAN1_TX_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(((0x700UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[0].IR);
+}
+
+void Test_BXCANTxQueue_QueueIsFull_ShouldNotQueue(void) {
+  for (uint32_t i = 0U; i < BXCAN_TX_QUEUE_LEN; i++) {
+    TEST_ASSERT_TRUE(test_tx_push(0x010U));
+  }
+  TEST_ASSERT_FALSE(test_tx_push(0x001U));
+  TEST_ASSERT_EQUAL_UINT32(BXCAN_TX_QUEUE_LEN,
+                           bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+}
+
+void Test_BXCANTxQueue_QueueIsFull_ShouldNotPreempt(void) {
+  for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+    test_can_regs[0].TSR = (CAN_TSR_TME0_Msk << mailbox);
+    TEST_ASSERT_TRUE(test_tx_push(0x100U + mailbox));
+  }
+  test_can_regs[0].TSR = 0UL;
+  for (uint32_t i = 0U; i < (BXCAN_TX_QUEUE_LEN - 1U); i++) {
+    TEST_ASSERT_TRUE(test_tx_push(0x200U));
+  }
+
+  /* The last place cannot take an evicted frame too */
+  TEST_ASSERT_TRUE(test_tx_push(0x050U));
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_can_regs[0].TSR);
+  TEST_ASSERT_FALSE(test_tx_push(0x040U));
+  TEST_ASSERT_EQUAL_UINT32(19U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+
+  /* It waits for the next free mailbox */
+  test_can_regs[0].TSR =
+      ((CAN_TSR_RQCP0_Msk | CAN_TSR_TXOK0_Msk) << 16U) | CAN_TSR_TME2_Msk;
+  CAN1_TX_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(((0x050UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[2].IR);
+  TEST_ASSERT_EQUAL_UINT32(18U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_tx_queue_failed(BXCAN_PERIPH_1));
+}
+
+void Test_BXCANRoute_QueueIsFull_ShouldKeepAbortedFrames(void) {
+  const struct bxCANRoute forward = {.ID = 0x0ABU, .Rewrite = TRUE};
+
+  for (uint8_t mailbox = 0U; mailbox < 3U; mailbox++) {
+    test_can_regs[0].TSR = (CAN_TSR_TME0_Msk << mailbox);
+    TEST_ASSERT_TRUE(test_tx_push(0x100U + mailbox));
+  }
+  test_can_regs[0].TSR = 0UL;
+  for (uint32_t i = 0U; i < (BXCAN_TX_QUEUE_LEN - 2U); i++) {
+    TEST_ASSERT_TRUE(test_tx_push(0x200U));
+  }
+  TEST_ASSERT_TRUE(test_tx_push(0x050U));
+  TEST_ASSERT_EQUAL_HEX32((CAN_TSR_ABRQ0_Msk << 16U), test_can_regs[0].TSR);
+
+  /* The last place belongs to the frame of mailbox 2 */
+  bxcan_set_route(BXCAN_PERIPH_1, 0U, 3U, &forward);
+  test_can_regs[0].TSR = 0UL;
+  test_rx_pending(0U, 0x123U);
+  CAN1_RX0_IRQHandler();
+  TEST_ASSERT_EQUAL_UINT32(1U, bxcan_route_dropped(BXCAN_PERIPH_1));
+  bxcan_set_route(BXCAN_PERIPH_1, 0U, 3U, NULL);
+
+  test_can_regs[0].TSR = ((CAN_TSR_RQCP0_Msk << 16U) | CAN_TSR_TME2_Msk);
+  CAN1_TX_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(((0x050UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[2].IR);
+  TEST_ASSERT_EQUAL_UINT32(18U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_tx_queue_failed(BXCAN_PERIPH_1));
+}
+
+void Test_BXCANTxFrames_EdgeCase_MailboxesShouldLoadWords(void) {
+  struct bxCANMessage messages[3] = {
+      {.ID = 0x123U, .DLC = 8U, .DATA = {0x03020100UL, 0x07060504UL}},
+      {.ID = 0x1ABCDEFU, .IDE = TRUE, .RTR = TRUE},
+      {.ID = 0x001U, .DLC = 9U},
+  };
+
+  test_can_regs[0].TSR =
+      (CAN_TSR_TME0_Msk | CAN_TSR_TME1_Msk | CAN_TSR_TME2_Msk);
+  TEST_ASSERT_EQUAL_UINT32(2U, bxcan_tx_frames(BXCAN_PERIPH_1, messages, 3U));
+
+  TEST_ASSERT_EQUAL_HEX32(((0x123UL << CAN_RI0R_STID_Pos) | CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[0].IR);
+  TEST_ASSERT_EQUAL_HEX32(0x8U, test_can_regs[0].TxMailbox[0].TR);
+  TEST_ASSERT_EQUAL_HEX32(0x07060504UL, test_can_regs[0].TxMailbox[0].HR);
+  TEST_ASSERT_EQUAL_HEX32(((0x1ABCDEFUL << CAN_RI0R_EXID_Pos) |
+                           BIT(CAN_RI0R_IDE_Pos) | BIT(CAN_RI0R_RTR_Pos) |
+                           CAN_TI0R_TXRQ_Msk),
+                          test_can_regs[0].TxMailbox[1].IR);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_can_regs[0].TxMailbox[2].IR);
+}
+
+void Test_BXCANRxFrames_EdgeCase_MessagesShouldUnpack(void) {
+  struct bxCANMessage messages[2] = {0};
+
+  test_rx_pending(1U, 0x7F0U);
+  TEST_ASSERT_EQUAL_UINT32(1U, bxcan_rx_frames(BXCAN_PERIPH_1, 1U, messages,
+                                               2U));
+  TEST_ASSERT_EQUAL_HEX32(0x7F0U, messages[0].ID);
+  TEST_ASSERT_EQUAL_UINT8(8U, messages[0].DLC);
+  TEST_ASSERT_EQUAL_UINT8(3U, messages[0].FMI);
+  TEST_ASSERT_EQUAL_HEX32(0x03020100UL, messages[0].DATA[0]);
+  TEST_ASSERT_EQUAL_HEX32(0x07060504UL, messages[0].DATA[1]);
+  TEST_ASSERT_EQUAL_HEX32(CAN_RF0R_RFOM0_Msk, test_can_regs[0].RFR[1]);
+
+  /* Nothing pending */
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_rx_frames(BXCAN_PERIPH_1, 1U, messages,
+                                               2U));
+}
+
+#ifdef BXCAN_STATS
+void Test_BXCANStats_EdgeCase_SnapshotShouldCountTraffic(void) {
+  struct bxCANStats stats;
+
+  /* 5 x (3 + 12 + 1) APB1 clocks, 320 core cycles a bit */
+  test_can_regs[0].BTR = ((4UL << CAN_BTR_BRP_Pos) |
+                          (12UL << CAN_BTR_TS1_Pos) | (1UL << CAN_BTR_TS2_Pos));
+  test_dwt_regs.CYCCNT = 1000UL;
+  bxcan_stats_snapshot(BXCAN_PERIPH_1, &stats, TRUE);
+
+  /* Two one byte frames from mailbox 0, 55 bits each */
+  test_can_regs[0].TSR = CAN_TSR_TME0_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x123U));
+  test_dwt_regs.CYCCNT = 1400UL;
+  test_can_regs[0].TSR =
+      (CAN_TSR_RQCP0_Msk | CAN_TSR_TXOK0_Msk | CAN_TSR_TME0_Msk);
+  CAN1_TX_IRQHandler();
+
+  test_dwt_regs.CYCCNT = 1500UL;
+  test_can_regs[0].TSR = CAN_TSR_TME0_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x124U));
+  test_dwt_regs.CYCCNT = 1600UL;
+  test_can_regs[0].TSR =
+      (CAN_TSR_RQCP0_Msk | CAN_TSR_TXOK0_Msk | CAN_TSR_TME0_Msk);
+  CAN1_TX_IRQHandler();
+
+  /* Mailbox 1 loses the arbitration, mailbox 2 fails */
+  test_can_regs[0].TSR = CAN_TSR_TME1_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x125U));
+  test_can_regs[0].TSR = ((CAN_TSR_RQCP0_Msk | CAN_TSR_ALST0_Msk) << 8U);
+  CAN1_TX_IRQHandler();
+  test_can_regs[0].TSR = CAN_TSR_TME2_Msk;
+  TEST_ASSERT_TRUE(test_tx_push(0x126U));
+  test_can_regs[0].TSR = ((CAN_TSR_RQCP0_Msk | CAN_TSR_TERR0_Msk) << 16U);
+  CAN1_TX_IRQHandler();
+
+  /* One eight byte frame received, 111 bits */
+  test_rx_pending(0U, 0x321U);
+  CAN1_RX0_IRQHandler();
+
+  /* 221 bits take 70720 cycles, half of the window */
+  test_dwt_regs.CYCCNT = (1000UL + 141440UL);
+  bxcan_stats_snapshot(BXCAN_PERIPH_1, &stats, TRUE);
+  TEST_ASSERT_EQUAL_UINT32(2UL, stats.TxFrames);
+  TEST_ASSERT_EQUAL_UINT32(1UL, stats.RxFrames);
+  TEST_ASSERT_EQUAL_UINT32(110UL, stats.TxBits);
+  TEST_ASSERT_EQUAL_UINT32(111UL, stats.RxBits);
+  TEST_ASSERT_EQUAL_UINT32(100UL, stats.TxLatencyLast[0]);
+  TEST_ASSERT_EQUAL_UINT32(400UL, stats.TxLatencyMax[0]);
+  TEST_ASSERT_EQUAL_UINT32(500UL, stats.TxLatencyTotal);
+  TEST_ASSERT_EQUAL_UINT32(1UL, stats.ArbitrationLost);
+  TEST_ASSERT_EQUAL_UINT32(1UL, stats.TxErrors);
+  TEST_ASSERT_EQUAL_UINT32(141440UL, stats.Window);
+  TEST_ASSERT_EQUAL_UINT16(500U, stats.Load);
+
+  /* The reset started an empty window */
+  test_dwt_regs.CYCCNT += 2000UL;
+  bxcan_stats_snapshot(BXCAN_PERIPH_1, &stats, FALSE);
+  TEST_ASSERT_EQUAL_UINT32(0UL, stats.TxBits);
+  TEST_ASSERT_EQUAL_UINT32(0UL, stats.ArbitrationLost);
+  TEST_ASSERT_EQUAL_UINT32(2000UL, stats.Window);
+  TEST_ASSERT_EQUAL_UINT16(0U, stats.Load);
+}
+#endif
+
+void setUp(void) {
+  memset(test_can_regs, 0, sizeof(test_can_regs));
+  test_can_regs[0].FMR = (14UL << CAN_FMR_CAN2SB_Pos); // Reset split
+  bxcan_rx_ring_start(BXCAN_PERIPH_1);
+  bxcan_tx_queue_start(BXCAN_PERIPH_1);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+  UNITY_BEGIN();
+  /* bxcan_bitrate_solve() / bxcan_configure_bitrate() */
+  RUN_TEST(Test_BXCANBitrate_EdgeCase_SolverShouldMatchMacro);
+  RUN_TEST(Test_BXCANBitrate_RateIsUnreachable_SolverShouldFail);
+  RUN_TEST(Test_BXCANConfigureBitrate_EdgeCase_RegistersShouldSetProperly);
+  /* bxcan_filter_plan() */
+  RUN_TEST(Test_BXCANFilterPlan_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_BXCANFilterPlan_BanksRunOut_BlocksShouldMerge);
+  RUN_TEST(Test_BXCANFilterPlan_RulesAreInvalid_RegistersShouldNotSet);
+  RUN_TEST(Test_BXCANFilterPlan_RangeCrossesSplit_RegistersShouldNotSet);
+  /* bxcan_rx_dispatch() */
+  RUN_TEST(Test_BXCANRxDispatch_EdgeCase_HandlersShouldFollowFMI);
+  /* bxcan_rx_ring_*() */
+  RUN_TEST(Test_BXCANRxRing_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_BXCANRxRing_EdgeCase_FramesShouldPopInOrder);
+  RUN_TEST(Test_BXCANRxRing_RingIsFull_FramesShouldBeDropped);
+  RUN_TEST(Test_BXCANRxRing_FIFOOverrun_ShouldCountAndClear);
+  /* bxcan_set_route() */
+  RUN_TEST(Test_BXCANRoute_EdgeCase_FramesShouldForwardRaw);
+  /* bxcan_tx_queue_*() */
+  RUN_TEST(Test_BXCANTxQueue_EdgeCase_MailboxesShouldFillByPriority);
+  RUN_TEST(Test_BXCANTxQueue_UrgentFrame_ShouldPreemptLowestMailbox);
+  RUN_TEST(Test_BXCANTxQueue_QueueIsFull_ShouldNotQueue);
+  RUN_TEST(Test_BXCANTxQueue_QueueIsFull_ShouldNotPreempt);
+  RUN_TEST(Test_BXCANRoute_QueueIsFull_ShouldKeepAbortedFrames);
+
+  /* bxcan_tx_frames() / bxcan_rx_frames() */
+  RUN_TEST(Test_BXCANTxFrames_EdgeCase_MailboxesShouldLoadWords);
+  RUN_TEST(Test_BXCANRxFrames_EdgeCase_MessagesShouldUnpack);
+#ifdef BXCAN_STATS
+  /* bxcan_stats_snapshot() */
+  RUN_TEST(Test_BXCANStats_EdgeCase_SnapshotShouldCountTraffic);
+#endif
+
+  return UNITY_END();
+}
@@ -0,0 +1,127 @@
+/** @file test_dma_driver.c
+ *  @brief Unit tests for the DMA driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "dma.h"
+
+struct DMARegs test_regs[2] = {0};
+struct DMARegs *DMA(const uint8_t num) { return &test_regs[num]; }
+
+static uint32_t test_calls = 0U;
+static uint8_t test_stream = 0xFFU;
+static struct DMAStreamISR test_flags = {0};
+
+static void test_callback(const dma_peripheral_t dma, const uint8_t stream,
+                          const struct DMAStreamISR flags, void *context) {
+  (void)dma;
+  test_calls += *(uint32_t *)context;
+  test_stream = stream;
+  test_flags = flags;
+}
+
+void Test_DMASetAddresses_EdgeCase_ShouldOverwriteOldAddresses(void) {
+  test_regs[0].S[3].PAR = 0xFFFFFFFFUL;
+  test_regs[0].S[3].M0AR = 0xFFFFFFFFUL;
+  test_regs[0].S[3].M1AR = 0xFFFFFFFFUL;
+  dma_set_addresses(DMA_PERIPH_1, 3U, 0x40004804UL, 0x20000100UL, 0U);
+  TEST_ASSERT_EQUAL_HEX32(0x40004804UL, test_regs[0].S[3].PAR);
+  TEST_ASSERT_EQUAL_HEX32(0x20000100UL, test_regs[0].S[3].M0AR);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_regs[0].S[3].M1AR);
+}
+
+void Test_DMAGetFlags_EdgeCase_ShouldUseStreamOffsets(void) {
+  /* TC of stream 2, TE of stream 5 and HT of stream 7 */
+  test_regs[1].LISR = (0x20UL << 16U);
+  test_regs[1].HISR = ((0x08UL << 6U) | (0x10UL << 22U));
+
+  TEST_ASSERT_TRUE(dma_get_flags(DMA_PERIPH_2, 2U).TCI);
+  TEST_ASSERT_FALSE(dma_get_flags(DMA_PERIPH_2, 1U).TCI);
+  TEST_ASSERT_FALSE(dma_get_flags(DMA_PERIPH_2, 3U).TCI);
+  TEST_ASSERT_FALSE(dma_get_flags(DMA_PERIPH_2, 6U).TCI);
+
+  const struct DMAStreamISR s5 = dma_get_flags(DMA_PERIPH_2, 5U);
+  TEST_ASSERT_TRUE(s5.TEI);
+  TEST_ASSERT_FALSE(s5.HTI);
+  TEST_ASSERT_FALSE(s5.TCI);
+
+  const struct DMAStreamISR s7 = dma_get_flags(DMA_PERIPH_2, 7U);
+  TEST_ASSERT_TRUE(s7.HTI);
+  TEST_ASSERT_FALSE(s7.TEI);
+}
+
+void Test_DMAGetFlags_StreamIsInvalid_ShouldReturnNone(void) {
+  test_regs[0].HISR = 0xFFFFFFFFUL;
+  const struct DMAStreamISR flags = dma_get_flags(DMA_PERIPH_1, 8U);
+  TEST_ASSERT_FALSE(flags.TCI);
+  TEST_ASSERT_FALSE(flags.TEI);
+}
+
+void Test_DMAClearFlags_EdgeCase_ShouldUseStreamOffsets(void) {
+  const struct DMAStreamISR tc = {.TCI = TRUE};
+  const struct DMAStreamISR all = {1U, 1U, 1U, 1U, 1U};
+
+  dma_clear_flags(DMA_PERIPH_1, 0U, all);
+  TEST_ASSERT_EQUAL_HEX32(0x0000003DUL, test_regs[0].LIFCR);
+  dma_clear_flags(DMA_PERIPH_1, 1U, tc);
+  TEST_ASSERT_EQUAL_HEX32(0x00000800UL, test_regs[0].LIFCR);
+  dma_clear_flags(DMA_PERIPH_1, 6U, tc);
+  TEST_ASSERT_EQUAL_HEX32(0x00200000UL, test_regs[0].HIFCR);
+  dma_clear_flags(DMA_PERIPH_1, 7U, all);
+  TEST_ASSERT_EQUAL_HEX32(0x0F400000UL, test_regs[0].HIFCR);
+}
+
+void Test_DMASetCallback_EdgeCase_HandlerShouldDispatchFlags(void) {
+  uint32_t increment = 1U;
+  dma_set_callback(DMA_PERIPH_2, 4U, test_callback, &increment);
+
+  test_regs[1].HISR = 0x00000028UL; // TC and TE of stream 4
+  DMA2_Stream4_IRQHandler();
+  TEST_ASSERT_EQUAL_UINT32(1U, test_calls);
+  TEST_ASSERT_EQUAL_UINT8(4U, test_stream);
+  TEST_ASSERT_TRUE(test_flags.TCI);
+  TEST_ASSERT_TRUE(test_flags.TEI);
+  TEST_ASSERT_FALSE(test_flags.HTI);
+  TEST_ASSERT_EQUAL_HEX32(0x00000028UL, test_regs[1].HIFCR);
+
+  /* Removed callbacks are not called anymore */
+  dma_set_callback(DMA_PERIPH_2, 4U, NULL, NULL);
+  DMA2_Stream4_IRQHandler();
+  TEST_ASSERT_EQUAL_UINT32(1U, test_calls);
+}
+
+void setUp(void) {
+  memset(test_regs, 0, sizeof(test_regs));
+  test_calls = 0U;
+  test_stream = 0xFFU;
+  test_flags = (struct DMAStreamISR){0};
+}
+
+void tearDown(void) {}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  /* dma_set_addresses() */
+  RUN_TEST(Test_DMASetAddresses_EdgeCase_ShouldOverwriteOldAddresses);
+  /* dma_get_flags() */
+  RUN_TEST(Test_DMAGetFlags_EdgeCase_ShouldUseStreamOffsets);
+  RUN_TEST(Test_DMAGetFlags_StreamIsInvalid_ShouldReturnNone);
+  /* dma_clear_flags() */
+  RUN_TEST(Test_DMAClearFlags_EdgeCase_ShouldUseStreamOffsets);
+  /* dma_set_callback() */
+  RUN_TEST(Test_DMASetCallback_EdgeCase_HandlerShouldDispatchFlags);
+
+  return UNITY_END();
+}
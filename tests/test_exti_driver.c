@@ -0,0 +1,87 @@
+/** @file test_exti_driver.c
+ *  @brief Unit tests for the EXTI driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "exti.h"
+
+struct EXTIRegs test_exti_regs = {0};
+struct EXTIRegs *EXTI_PTR = &test_exti_regs;
+
+struct SYSCFGRegs test_syscfg_regs = {0};
+struct SYSCFGRegs *SYSCFG_PTR = &test_syscfg_regs;
+
+static uint32_t test_calls = 0U;
+static uint8_t test_line = 0xFFU;
+
+static void test_callback(const uint8_t line, void *context) {
+  test_calls += *(uint32_t *)context;
+  test_line = line;
+}
+
+void Test_EXTIConfigure_EdgeCase_RegistersShouldSetProperly(void) {
+  uint32_t step = 1U;
+
+  test_syscfg_regs.EXTICR[1] = 0xFFFFUL;
+  exti_configure(GP_BANK_A, 6U, TRUE, FALSE, test_callback, &step);
+
+  TEST_ASSERT_EQUAL_HEX32(0xF0FFUL, test_syscfg_regs.EXTICR[1]);
+  TEST_ASSERT_EQUAL_HEX32(BIT(6), test_exti_regs.RTSR);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_exti_regs.FTSR);
+  TEST_ASSERT_EQUAL_HEX32(BIT(6), test_exti_regs.IMR);
+}
+
+void Test_EXTIConfigure_PinIsInvalid_RegistersShouldNotSet(void) {
+  exti_configure(GP_BANK_A, 16U, TRUE, TRUE, test_callback, NULL);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_exti_regs.IMR);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_exti_regs.RTSR);
+}
+
+void Test_EXTIHandler_EdgeCase_ShouldDispatchPendingLines(void) {
+  uint32_t step = 1U;
+
+  exti_configure(GP_BANK_A, 12U, FALSE, TRUE, test_callback, &step);
+  test_exti_regs.PR = (BIT(12) | BIT(3)); // Line 3 is masked
+  EXTI15_10_IRQHandler();
+
+  TEST_ASSERT_EQUAL_UINT32(1U, test_calls);
+  TEST_ASSERT_EQUAL_UINT8(12U, test_line);
+  TEST_ASSERT_EQUAL_HEX32(BIT(12), test_exti_regs.PR);
+
+  /* Disabled lines stay quiet */
+  exti_disable(12U);
+  test_exti_regs.PR = BIT(12);
+  EXTI15_10_IRQHandler();
+  TEST_ASSERT_EQUAL_UINT32(1U, test_calls);
+}
+
+void setUp(void) {
+  memset(&test_exti_regs, 0, sizeof(test_exti_regs));
+  memset(&test_syscfg_regs, 0, sizeof(test_syscfg_regs));
+  test_calls = 0U;
+  test_line = 0xFFU;
+}
+
+void tearDown(void) {}
+
+int main(void) {
+  UNITY_BEGIN();
+  /* exti_configure() */
+  RUN_TEST(Test_EXTIConfigure_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_EXTIConfigure_PinIsInvalid_RegistersShouldNotSet);
+  /* EXTIx_IRQHandler() */
+  RUN_TEST(Test_EXTIHandler_EdgeCase_ShouldDispatchPendingLines);
+
+  return UNITY_END();
+}
@@ -0,0 +1,334 @@
+/** @file test_framing_driver.c
+ *  @brief Unit tests for the packet framing layer
+ *
+ *  The unit tests defined in this file run the COBS and
+ *  SLIP encoders and in-place decoders on the host,
+ *  including frames that wrap around a receive ring.
+ *  The CRC trailer uses the software CRC, the hardware
+ *  path is checked against the stubbed CRC and USART2
+ *  transmit DMA registers.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "framing.h"
+#include "crc.h"
+
+/* Register stubs of the drivers the framing links to */
+struct USARTRegs test_usart_regs = {0};
+struct USARTRegs *USART(const uint32_t base) {
+  (void)base;
+  return &test_usart_regs;
+}
+
+struct GPIORegs test_gpio_regs = {0};
+struct GPIORegs *GPIO(const uint8_t bank) {
+  (void)bank;
+  return &test_gpio_regs;
+}
+
+struct DMARegs test_dma_regs = {0};
+struct DMARegs *DMA(const uint8_t num) {
+  (void)num;
+  return &test_dma_regs;
+}
+
+struct CRCRegs test_crc_regs = {0};
+struct CRCRegs *CRC_PTR = &test_crc_regs;
+
+/* USART2 transmits on DMA1 stream 6, at offset 16 of HISR */
+#define TX_STREAM test_dma_regs.S[6]
+#define TX_TC     (0x20UL << 16U)
+#define TX_TE     (0x08UL << 16U)
+
+static void test_tx_event(const uint32_t flags) {
+  test_dma_regs.HISR = flags;
+  DMA1_Stream6_IRQHandler();
+  test_dma_regs.HISR = 0UL;
+}
+
+static uint8_t test_tx_calls = 0U;
+static _Bool test_tx_error = FALSE;
+
+static void test_tx_done(struct FrameTx *tx, const _Bool error,
+                         void *context) {
+  (void)tx;
+  (void)context;
+  test_tx_calls++;
+  test_tx_error = error;
+}
+
+void Test_CRCSeed_EdgeCase_ResetUnitShouldReachCRC(void) {
+  const uint32_t values[3] = {0x00000000UL, 0x0376E6E7UL, CRC_INIT};
+
+  /* One word through a reset unit, MSB first */
+  for (uint8_t i = 0U; i < 3U; i++) {
+    const uint32_t seed = crc_seed(values[i]);
+    const uint8_t word[4] = {(uint8_t)(seed >> 24U), (uint8_t)(seed >> 16U),
+                             (uint8_t)(seed >> 8U), (uint8_t)seed};
+    TEST_ASSERT_EQUAL_HEX32(values[i], crc_update_soft(word, 4U, CRC_INIT));
+  }
+}
+
+void Test_CRCUpdate_EdgeCase_WordsShouldGoMSBFirst(void) {
+  const uint8_t data[8] = {0x00U, 0x31U, 0x32U, 0x33U, 0x34U, 0x35U, 0x36U};
+
+  /* The stub keeps the last word, the tail goes on from it */
+  const uint32_t crc = crc_update(&data[1], 6U, CRC_INIT);
+  TEST_ASSERT_EQUAL_HEX32(CRC_CR_RESET_Msk, test_crc_regs.CR);
+  TEST_ASSERT_EQUAL_HEX32(0x31323334UL, test_crc_regs.DR);
+  TEST_ASSERT_EQUAL_HEX32(crc_update_soft(&data[5], 2U, 0x31323334UL), crc);
+
+  /* Short buffers stay in software */
+  test_crc_regs.DR = 0UL;
+  TEST_ASSERT_EQUAL_HEX32(crc_update_soft(data, 3U, 0x1234UL),
+                          crc_update(data, 3U, 0x1234UL));
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_crc_regs.DR);
+}
+
+void Test_CRCUpdateSoft_EdgeCase_ShouldMatchCheckValue(void) {
+  const uint8_t check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  TEST_ASSERT_EQUAL_HEX32(0x0376E6E7UL, crc_update_soft(check, 9U, CRC_INIT));
+  TEST_ASSERT_EQUAL_HEX32(
+      0x0376E6E7UL,
+      crc_update_soft(&check[4], 5U, crc_update_soft(check, 4U, CRC_INIT)));
+}
+
+void Test_FrameCOBSEncode_EdgeCase_ShouldEncodeZeros(void) {
+  const uint8_t packet[4] = {0x11U, 0x00U, 0x00U, 0x22U};
+  const uint8_t expected[6] = {0x02U, 0x11U, 0x01U, 0x02U, 0x22U, 0x00U};
+  uint8_t out[FRAME_COBS_MAX(4U)];
+
+  TEST_ASSERT_EQUAL_UINT32(6U, frame_cobs_encode(packet, 4U, NULL, out,
+                                                 sizeof(out)));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, 6U);
+}
+
+void Test_FrameCOBSEncode_EdgeCase_ShouldSplitLongBlocks(void) {
+  uint8_t packet[300];
+  uint8_t out[FRAME_COBS_MAX(300U)];
+  for (uint16_t i = 0U; i < 300U; i++) { packet[i] = (uint8_t)(1U + i % 200U); }
+
+  TEST_ASSERT_EQUAL_UINT32(303U, frame_cobs_encode(packet, 300U, NULL, out,
+                                                   sizeof(out)));
+  TEST_ASSERT_EQUAL_HEX8(0xFFU, out[0]);
+  TEST_ASSERT_EQUAL_HEX8(47U, out[255]);
+  TEST_ASSERT_EQUAL_HEX8(0x00U, out[302]);
+}
+
+void Test_FrameCOBSEncode_BufferIsSmall_ShouldReturnZero(void) {
+  const uint8_t packet[4] = {0x11U, 0x00U, 0x00U, 0x22U};
+  uint8_t out[5];
+  TEST_ASSERT_EQUAL_UINT32(0U, frame_cobs_encode(packet, 4U, NULL, out,
+                                                 sizeof(out)));
+}
+
+void Test_FrameCOBSEncodeChunk_EdgeCase_ShouldMatchOneShot(void) {
+  uint8_t packet[600];
+  uint8_t whole[FRAME_COBS_MAX(600U + FRAME_CRC_LEN)];
+  uint8_t chunked[sizeof(whole)];
+  struct FrameCOBSEncoder encoder;
+  uint32_t total = 0U;
+  uint16_t written;
+  for (uint16_t i = 0U; i < 600U; i++) { packet[i] = (uint8_t)(i % 300U); }
+
+  const uint32_t length = frame_cobs_encode(packet, 600U, crc_update_soft,
+                                            whole, sizeof(whole));
+  frame_cobs_encoder_init(&encoder, packet, 600U, crc_update_soft);
+  while ((written = frame_cobs_encode_chunk(&encoder, &chunked[total], 7U))) {
+    total += written;
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(length, total);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(whole, chunked, length);
+}
+
+void Test_FrameCOBSNext_EdgeCase_ShouldDecodeWrappedFrames(void) {
+  const uint8_t packet[5] = {0x00U, 0xAAU, 0x00U, 0x00U, 0xBBU};
+  uint8_t frame[FRAME_COBS_MAX(5U + FRAME_CRC_LEN)];
+  uint8_t ring[16] = {0};
+  struct FrameView packet_view;
+
+  /* Place the frame so it wraps at the end of the ring */
+  const uint32_t length = frame_cobs_encode(packet, 5U, crc_update_soft, frame,
+                                            sizeof(frame));
+  for (uint32_t i = 0U; i < length; i++) { ring[(12U + i) % 16U] = frame[i]; }
+  struct FrameView input = {.Ring = ring,
+                            .Size = 16U,
+                            .Offset = 12U,
+                            .Length = (uint16_t)length};
+
+  TEST_ASSERT_EQUAL(FRAME_OK,
+                    frame_cobs_next(&input, crc_update_soft, &packet_view));
+  TEST_ASSERT_EQUAL_UINT16(5U, packet_view.Length);
+  TEST_ASSERT_EQUAL_UINT16(12U, packet_view.Offset);
+  for (uint8_t i = 0U; i < 5U; i++) {
+    TEST_ASSERT_EQUAL_HEX8(packet[i], ring[(12U + i) % 16U]);
+  }
+  TEST_ASSERT_EQUAL_UINT16(0U, input.Length);
+  TEST_ASSERT_EQUAL(FRAME_MORE,
+                    frame_cobs_next(&input, crc_update_soft, &packet_view));
+}
+
+void Test_FrameCOBSNext_CRCIsWrong_ShouldSkipFrame(void) {
+  const uint8_t packet[3] = {0x01U, 0x02U, 0x03U};
+  uint8_t ring[2 * FRAME_COBS_MAX(3U + FRAME_CRC_LEN)];
+  struct FrameView packet_view;
+
+  const uint32_t length = frame_cobs_encode(packet, 3U, crc_update_soft, ring,
+                                            sizeof(ring));
+  memcpy(&ring[length], ring, length);
+  ring[2] ^= 0x40U;
+  struct FrameView input = {.Ring = ring,
+                            .Size = sizeof(ring),
+                            .Offset = 0U,
+                            .Length = (uint16_t)(2U * length)};
+
+  TEST_ASSERT_EQUAL(FRAME_ERROR,
+                    frame_cobs_next(&input, crc_update_soft, &packet_view));
+  TEST_ASSERT_EQUAL(FRAME_OK,
+                    frame_cobs_next(&input, crc_update_soft, &packet_view));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(packet, &ring[packet_view.Offset], 3U);
+}
+
+void Test_FrameCOBSNext_FrameIsPartial_ShouldKeepInput(void) {
+  uint8_t ring[4] = {0x03U, 0x11U, 0x22U, 0x01U};
+  struct FrameView packet_view;
+  struct FrameView input = {.Ring = ring, .Size = 4U, .Length = 4U};
+
+  TEST_ASSERT_EQUAL(FRAME_MORE, frame_cobs_next(&input, NULL, &packet_view));
+  TEST_ASSERT_EQUAL_UINT16(4U, input.Length);
+}
+
+void Test_FrameCOBSTx_USARTIsInvalid_ShouldFail(void) {
+  const uint8_t packet[2] = {0x01U, 0x02U};
+  struct FrameTx tx = {0};
+  TEST_ASSERT_FALSE(frame_cobs_tx(6U, &tx, packet, 2U, NULL, NULL, NULL));
+  TEST_ASSERT_FALSE(tx.Busy);
+}
+
+void Test_FrameCOBSTx_EdgeCase_StagesShouldStreamFrame(void) {
+  uint8_t packet[200];
+  uint8_t whole[FRAME_COBS_MAX(200U + FRAME_CRC_LEN)];
+  uint8_t sent[sizeof(whole)];
+  uint16_t lengths[8] = {0U};
+  struct FrameTx tx = {0};
+  uint32_t total = 0U;
+  uint8_t chunks = 0U;
+  for (uint16_t i = 0U; i < 200U; i++) { packet[i] = (uint8_t)(i % 100U); }
+
+  const uint32_t length = frame_cobs_encode(packet, 200U, crc_update_soft,
+                                            whole, sizeof(whole));
+  TEST_ASSERT_TRUE(frame_cobs_tx(USART_PERIPH_2, &tx, packet, 200U,
+                                 crc_update_soft, test_tx_done, NULL));
+  TEST_ASSERT_FALSE(frame_cobs_tx(USART_PERIPH_2, &tx, packet, 200U, NULL,
+                                  NULL, NULL));
+
+  /* Collect each stage as its transfer starts */
+  while (usart_tx_dma_busy(USART_PERIPH_2) && (chunks < 8U)) {
+    const uint8_t stage =
+        (TX_STREAM.M0AR == (uint32_t)(uintptr_t)tx.Stage[0]) ? 0U : 1U;
+    memcpy(&sent[total], tx.Stage[stage], TX_STREAM.NDTR);
+    total += TX_STREAM.NDTR;
+    lengths[chunks++] = (uint16_t)TX_STREAM.NDTR;
+    test_tx_event(TX_TC);
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(4U, chunks);
+  TEST_ASSERT_EQUAL_UINT16(FRAME_STAGE_LEN, lengths[2]);
+  TEST_ASSERT_EQUAL_UINT32(length, total);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(whole, sent, length);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_tx_calls);
+  TEST_ASSERT_FALSE(test_tx_error);
+  TEST_ASSERT_FALSE(tx.Busy);
+}
+
+void Test_FrameCOBSTx_TransferError_ShouldStopRefills(void) {
+  uint8_t packet[200] = {0};
+  struct FrameTx tx = {0};
+
+  TEST_ASSERT_TRUE(frame_cobs_tx(USART_PERIPH_2, &tx, packet, 200U, NULL,
+                                 test_tx_done, NULL));
+
+  /* The queued second stage still goes out */
+  test_tx_event(TX_TE);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)tx.Stage[1], TX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT8(0U, test_tx_calls);
+  test_tx_event(TX_TC);
+
+  TEST_ASSERT_FALSE(usart_tx_dma_busy(USART_PERIPH_2));
+  TEST_ASSERT_EQUAL_UINT8(1U, test_tx_calls);
+  TEST_ASSERT_TRUE(test_tx_error);
+  TEST_ASSERT_FALSE(tx.Busy);
+}
+
+void Test_FrameSLIP_EdgeCase_ShouldRoundTrip(void) {
+  const uint8_t packet[5] = {0xC0U, 0x01U, 0xDBU, 0xDCU, 0xC0U};
+  uint8_t ring[FRAME_SLIP_MAX(5U + FRAME_CRC_LEN)];
+  struct FrameView packet_view;
+
+  const uint32_t length = frame_slip_encode(packet, 5U, crc_update_soft, ring,
+                                            sizeof(ring));
+  TEST_ASSERT_EQUAL_HEX8(FRAME_SLIP_END, ring[0]);
+  TEST_ASSERT_EQUAL_HEX8(FRAME_SLIP_ESC, ring[1]);
+  TEST_ASSERT_EQUAL_HEX8(FRAME_SLIP_END, ring[length - 1U]);
+
+  struct FrameView input = {.Ring = ring,
+                            .Size = sizeof(ring),
+                            .Length = (uint16_t)length};
+  TEST_ASSERT_EQUAL(FRAME_OK,
+                    frame_slip_next(&input, crc_update_soft, &packet_view));
+  TEST_ASSERT_EQUAL_UINT16(5U, packet_view.Length);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(packet, &ring[packet_view.Offset], 5U);
+}
+
+void Test_FrameSLIPNext_EscapeIsInvalid_ShouldSkipFrame(void) {
+  uint8_t ring[5] = {0xC0U, 0x01U, 0xDBU, 0x02U, 0xC0U};
+  struct FrameView packet_view;
+  struct FrameView input = {.Ring = ring, .Size = 5U, .Length = 5U};
+
+  TEST_ASSERT_EQUAL(FRAME_ERROR, frame_slip_next(&input, NULL, &packet_view));
+  TEST_ASSERT_EQUAL_UINT16(0U, input.Length);
+}
+
+void setUp() {
+  memset(&test_crc_regs, 0, sizeof(test_crc_regs));
+  memset(&test_dma_regs, 0, sizeof(test_dma_regs));
+  test_tx_calls = 0U;
+  test_tx_error = FALSE;
+}
+
+void tearDown() {}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  /* crc_seed() / crc_update() */
+  RUN_TEST(Test_CRCSeed_EdgeCase_ResetUnitShouldReachCRC);
+  RUN_TEST(Test_CRCUpdate_EdgeCase_WordsShouldGoMSBFirst);
+  /* crc_update_soft() */
+  RUN_TEST(Test_CRCUpdateSoft_EdgeCase_ShouldMatchCheckValue);
+  /* frame_cobs_encode() */
+  RUN_TEST(Test_FrameCOBSEncode_EdgeCase_ShouldEncodeZeros);
+  RUN_TEST(Test_FrameCOBSEncode_EdgeCase_ShouldSplitLongBlocks);
+  RUN_TEST(Test_FrameCOBSEncode_BufferIsSmall_ShouldReturnZero);
+  /* frame_cobs_encode_chunk() */
+  RUN_TEST(Test_FrameCOBSEncodeChunk_EdgeCase_ShouldMatchOneShot);
+  /* frame_cobs_next() */
+  RUN_TEST(Test_FrameCOBSNext_EdgeCase_ShouldDecodeWrappedFrames);
+  RUN_TEST(Test_FrameCOBSNext_CRCIsWrong_ShouldSkipFrame);
+  RUN_TEST(Test_FrameCOBSNext_FrameIsPartial_ShouldKeepInput);
+  /* frame_cobs_tx() */
+  RUN_TEST(Test_FrameCOBSTx_USARTIsInvalid_ShouldFail);
+  RUN_TEST(Test_FrameCOBSTx_EdgeCase_StagesShouldStreamFrame);
+  RUN_TEST(Test_FrameCOBSTx_TransferError_ShouldStopRefills);
+  /* frame_slip_encode() / frame_slip_next() */
+  RUN_TEST(Test_FrameSLIP_EdgeCase_ShouldRoundTrip);
+  RUN_TEST(Test_FrameSLIPNext_EscapeIsInvalid_ShouldSkipFrame);
+
+  return UNITY_END();
+}
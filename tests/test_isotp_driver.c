@@ -0,0 +1,191 @@
+/** @file test_isotp_driver.c
+ *  @brief Unit tests for the ISO-TP transport layer
+ *
+ *  The unit tests defined in this file run ISO-TP
+ *  transfers against the stubbed bxCAN transmit queue.
+ *  Sent frames are read back from transmit mailbox 0,
+ *  which is completed by hand to load the next one.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "isotp.h"
+
+#define TEST_TX_ID 0x7E0U
+#define TEST_RX_ID 0x7E8U
+
+struct bxCANRegs test_can_regs[BXCAN_PERIPH_LEN] = {0};
+
+struct bxCANRegs *CAN(const uint8_t num) { return &test_can_regs[num]; }
+
+/* Cycle counter of the bxCAN statistics */
+DWT_Type test_dwt_regs = {0};
+DWT_Type *DWT_PTR = &test_dwt_regs;
+
+static struct ISOTPChannel test_channel;
+static uint8_t test_buffer[16];
+static uint8_t test_events[8];
+
+static void test_callback(struct ISOTPChannel *channel,
+                          const isotp_event_t event, void *context) {
+  (void)channel;
+  (void)context;
+  test_events[event]++;
+}
+
+/* Takes the frame in mailbox 0 and completes it */
+static uint32_t test_tx_pop(uint8_t *data) {
+  TEST_ASSERT_TRUE(bxcan_tx_queue_pending(BXCAN_PERIPH_1) > 0U);
+
+  const struct bxCANMailboxRegs *mailbox = &test_can_regs[0].TxMailbox[0];
+  for (uint8_t i = 0U; i < 4U; i++) {
+    data[i] = (uint8_t)(mailbox->LR >> (8U * i));
+    data[4U + i] = (uint8_t)(mailbox->HR >> (8U * i));
+  }
+  const uint32_t id = (mailbox->IR >> CAN_RI0R_STID_Pos);
+
+  test_can_regs[0].TSR =
+      (CAN_TSR_RQCP0_Msk | CAN_TSR_TXOK0_Msk | CAN_TSR_TME0_Msk);
+  CAN1_TX_IRQHandler();
+  if (bxcan_tx_queue_pending(BXCAN_PERIPH_1) == 0U) {
+    test_can_regs[0].TSR = CAN_TSR_TME0_Msk;
+  }
+  return id;
+}
+
+static void test_rx(const uint8_t *data) {
+  struct bxCANFrame frame = {.ID = TEST_RX_ID, .DLC = 8U};
+  for (uint8_t i = 0U; i < 8U; i++) {
+    frame.DATA[i] = data[i];
+  }
+  isotp_rx_frame(BXCAN_PERIPH_1, &frame);
+}
+
+void Test_ISOTPSend_EdgeCase_SingleFrameShouldBePadded(void) {
+  const uint8_t message[3] = {0x22U, 0xF1U, 0x90U};
+  const uint8_t expected[8] = {0x03U, 0x22U, 0xF1U, 0x90U,
+                               0xCCU, 0xCCU, 0xCCU, 0xCCU};
+  uint8_t data[8];
+
+  TEST_ASSERT_TRUE(isotp_send(&test_channel, message, 3U));
+  TEST_ASSERT_EQUAL_UINT8(1U, test_events[ISOTP_TX_DONE]);
+  TEST_ASSERT_FALSE(isotp_tx_busy(&test_channel));
+
+  TEST_ASSERT_EQUAL_HEX32(TEST_TX_ID, test_tx_pop(data));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, 8U);
+}
+
+void Test_ISOTPSend_EdgeCase_FlowControlShouldPaceFrames(void) {
+  uint8_t message[27];
+  uint8_t data[8];
+  for (uint8_t i = 0U; i < 27U; i++) {
+    message[i] = i;
+  }
+
+  TEST_ASSERT_TRUE(isotp_send(&test_channel, message, 27U));
+  TEST_ASSERT_FALSE(isotp_send(&test_channel, message, 27U));
+  test_tx_pop(data);
+  TEST_ASSERT_EQUAL_HEX8(0x10U, data[0]);
+  TEST_ASSERT_EQUAL_HEX8(27U, data[1]);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(message, &data[2], 6U);
+
+  /* Blocks of 2, 5 ms apart: the first one goes right away */
+  const uint8_t cts[8] = {0x30U, 2U, 5U};
+  test_rx(cts);
+  test_tx_pop(data);
+  TEST_ASSERT_EQUAL_HEX8(0x21U, data[0]);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(&message[6], &data[1], 7U);
+
+  isotp_poll(4999U);
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+  isotp_poll(5000U);
+  test_tx_pop(data);
+  TEST_ASSERT_EQUAL_HEX8(0x22U, data[0]);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(&message[13], &data[1], 7U);
+
+  /* End of block, the receiver never answers */
+  isotp_poll(5000U + ISOTP_N_BS_US);
+  TEST_ASSERT_EQUAL_UINT32(0U, bxcan_tx_queue_pending(BXCAN_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT8(1U, test_events[ISOTP_TX_TIMEOUT]);
+  TEST_ASSERT_EQUAL_UINT8(0U, test_events[ISOTP_TX_DONE]);
+  TEST_ASSERT_FALSE(isotp_tx_busy(&test_channel));
+}
+
+void Test_ISOTPRx_EdgeCase_MessageShouldReassemble(void) {
+  const uint8_t ff[8] = {0x10U, 10U, 0U, 1U, 2U, 3U, 4U, 5U};
+  const uint8_t cf[8] = {0x21U, 6U, 7U, 8U, 9U, 0xCCU, 0xCCU, 0xCCU};
+  const uint8_t expected[10] = {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 9U};
+  uint8_t data[8];
+
+  test_rx(ff);
+  TEST_ASSERT_EQUAL_HEX32(TEST_TX_ID, test_tx_pop(data));
+  TEST_ASSERT_EQUAL_HEX8(0x30U, data[0]);
+  TEST_ASSERT_EQUAL_HEX8(4U, data[1]);
+  TEST_ASSERT_EQUAL_HEX8(0xF5U, data[2]);
+
+  test_rx(cf);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_events[ISOTP_RX_DONE]);
+  TEST_ASSERT_EQUAL_UINT16(10U, test_channel.RxLength);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, test_buffer, 10U);
+}
+
+void Test_ISOTPRx_SequenceIsWrong_ShouldAbort(void) {
+  const uint8_t ff[8] = {0x10U, 10U, 0U, 1U, 2U, 3U, 4U, 5U};
+  const uint8_t cf[8] = {0x22U, 6U, 7U, 8U, 9U, 0xCCU, 0xCCU, 0xCCU};
+  uint8_t data[8];
+
+  test_rx(ff);
+  test_tx_pop(data);
+  test_rx(cf);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_events[ISOTP_RX_SEQUENCE]);
+  TEST_ASSERT_EQUAL_UINT8(0U, test_events[ISOTP_RX_DONE]);
+
+  /* Not receiving anymore, no timeout either */
+  isotp_poll(ISOTP_N_CR_US);
+  TEST_ASSERT_EQUAL_UINT8(0U, test_events[ISOTP_RX_TIMEOUT]);
+}
+
+void Test_ISOTPRx_MessageIsTooLong_ShouldSendOverflow(void) {
+  const uint8_t ff[8] = {0x10U, 17U, 0U, 1U, 2U, 3U, 4U, 5U};
+  uint8_t data[8];
+
+  test_rx(ff);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_events[ISOTP_RX_OVERFLOW]);
+  test_tx_pop(data);
+  TEST_ASSERT_EQUAL_HEX8(0x32U, data[0]);
+}
+
+void setUp(void) {
+  const struct ISOTPConfig config = {
+      .TxID = TEST_TX_ID, .RxID = TEST_RX_ID, .BlockSize = 4U, .STmin = 0xF5U};
+
+  memset(test_can_regs, 0, sizeof(test_can_regs));
+  memset(test_events, 0, sizeof(test_events));
+  memset(test_buffer, 0, sizeof(test_buffer));
+  test_can_regs[0].TSR = CAN_TSR_TME0_Msk;
+  bxcan_tx_queue_start(BXCAN_PERIPH_1);
+
+  isotp_poll(0U);
+  TEST_ASSERT_TRUE(isotp_open(&test_channel, BXCAN_PERIPH_1, config,
+                              test_buffer, sizeof(test_buffer), test_callback,
+                              NULL));
+}
+
+void tearDown(void) { isotp_close(&test_channel); }
+
+int main(void) {
+  UNITY_BEGIN();
+  /* isotp_send() */
+  RUN_TEST(Test_ISOTPSend_EdgeCase_SingleFrameShouldBePadded);
+  RUN_TEST(Test_ISOTPSend_EdgeCase_FlowControlShouldPaceFrames);
+  /* isotp_rx_frame() */
+  RUN_TEST(Test_ISOTPRx_EdgeCase_MessageShouldReassemble);
+  RUN_TEST(Test_ISOTPRx_SequenceIsWrong_ShouldAbort);
+  RUN_TEST(Test_ISOTPRx_MessageIsTooLong_ShouldSendOverflow);
+
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/** @file test_qspi_driver.c
+ *  @brief Unit tests for the QUADSPI driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "qspi.h"
+#include "dma.h"
+
+/* TCF and FTF stay set, so every wait passes at once */
+struct QSPIRegs test_regs = {0};
+struct QSPIRegs *QSPI_PTR = &test_regs;
+
+struct DMARegs test_dma_regs = {0};
+struct DMARegs *DMA(const uint8_t num) {
+  (void)num;
+  return &test_dma_regs;
+}
+
+/* Quad I/O fast read with continuous read mode bits */
+static const struct QSPICommand test_quad_read = {
+    .Instruction = 0xEBU,
+    .InstructionLines = QSPI_LINES_1,
+    .AddressLines = QSPI_LINES_4,
+    .AddressSize = 3U,
+    .AlternateLines = QSPI_LINES_4,
+    .AlternateSize = 1U,
+    .Alternate = 0xA0U,
+    .DummyCycles = 4U,
+    .DataLines = QSPI_LINES_4,
+    .Address = 0x123456UL,
+};
+
+void Test_QSPIInit_EdgeCase_RegistersShouldSetProperly(void) {
+  qspi_init(1U, 24U, 2U, FALSE);
+
+  TEST_ASSERT_EQUAL_HEX32(0x00170100UL, test_regs.DCR);
+  TEST_ASSERT_EQUAL_HEX32(0x01000011UL, test_regs.CR);
+}
+
+void Test_QSPIInit_SizeIsInvalid_RegistersShouldNotSet(void) {
+  qspi_init(1U, 33U, 2U, FALSE);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.DCR);
+  qspi_init(1U, 24U, 9U, FALSE);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.DCR);
+}
+
+void Test_QSPIRead_EdgeCase_RegistersShouldSetProperly(void) {
+  uint8_t data[4] = {0};
+
+  test_regs.DR = 0x5AUL;
+  TEST_ASSERT_TRUE(qspi_read(&test_quad_read, data, sizeof(data)));
+  TEST_ASSERT_EQUAL_HEX32(3UL, test_regs.DLR);
+  TEST_ASSERT_EQUAL_HEX32(0x0710EDEBUL, test_regs.CCR);
+  TEST_ASSERT_EQUAL_HEX32(0x123456UL, test_regs.AR);
+  TEST_ASSERT_EQUAL_HEX32(0xA0UL, test_regs.ABR);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0x5AU, data, sizeof(data));
+}
+
+void Test_QSPICommand_AddressSizeIsInvalid_ShouldFail(void) {
+  struct QSPICommand command = test_quad_read;
+
+  command.AddressSize = 0U;
+  TEST_ASSERT_FALSE(qspi_command(&command));
+  TEST_ASSERT_FALSE(qspi_command(NULL));
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.CCR);
+}
+
+void Test_QSPIMemoryMap_EdgeCase_ShouldKeepDataPhase(void) {
+  TEST_ASSERT_TRUE(qspi_memory_map(&test_quad_read));
+
+  /* Mapped mode with quad data, no AR write */
+  TEST_ASSERT_EQUAL_HEX32(0x0F10EDEBUL, test_regs.CCR);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.AR);
+}
+
+void Test_QSPIPoll_EdgeCase_RegistersShouldSetProperly(void) {
+  const struct QSPICommand status = {.Instruction = 0x05U,
+                                     .InstructionLines = QSPI_LINES_1,
+                                     .DataLines = QSPI_LINES_1};
+
+  test_regs.SR |= QUADSPI_SR_SMF_Msk;
+  TEST_ASSERT_TRUE(qspi_poll(&status, 0x01UL, 0x00UL, 1U, 16U));
+  TEST_ASSERT_EQUAL_HEX32(0x09000105UL, test_regs.CCR);
+  TEST_ASSERT_EQUAL_HEX32(0x01UL, test_regs.PSMKR);
+  TEST_ASSERT_EQUAL_HEX32(16UL, test_regs.PIR);
+  TEST_ASSERT_EQUAL_HEX32(QUADSPI_CR_APMS_Msk,
+                          (test_regs.CR & QUADSPI_CR_APMS_Msk));
+}
+
+void Test_QSPITransferDMA_StreamIsInUse_ShouldFail(void) {
+  uint8_t data[4] = {0};
+
+  /* USART1 TX is running on stream 7 */
+  test_dma_regs.S[7].CR = ((4UL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_EN_Msk);
+  TEST_ASSERT_FALSE(qspi_transfer_dma(&test_quad_read, data, sizeof(data),
+                                      FALSE, NULL, NULL));
+  TEST_ASSERT_EQUAL_HEX32(((4UL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_EN_Msk),
+                          test_dma_regs.S[7].CR);
+  TEST_ASSERT_FALSE(test_regs.CR & QUADSPI_CR_DMAEN_Msk);
+
+  /* Done, the stream is free again */
+  test_dma_regs.S[7].CR &= ~(DMA_SxCR_EN_Msk);
+  TEST_ASSERT_TRUE(qspi_transfer_dma(&test_quad_read, data, sizeof(data),
+                                     FALSE, NULL, NULL));
+  TEST_ASSERT_EQUAL_UINT32((3UL << DMA_SxCR_CHSEL_Pos),
+                           (test_dma_regs.S[7].CR & DMA_SxCR_CHSEL_Msk));
+  TEST_ASSERT_TRUE(test_regs.CR & QUADSPI_CR_DMAEN_Msk);
+
+  /* Completes like the hardware, which clears EN */
+  test_dma_regs.S[7].CR &= ~(DMA_SxCR_EN_Msk);
+  test_dma_regs.HISR = (0x20UL << 22U);
+  DMA2_Stream7_IRQHandler();
+  TEST_ASSERT_FALSE(test_regs.CR & QUADSPI_CR_DMAEN_Msk);
+}
+
+void setUp(void) {
+  memset(&test_regs, 0, sizeof(test_regs));
+  memset(&test_dma_regs, 0, sizeof(test_dma_regs));
+  test_regs.SR = (QUADSPI_SR_TCF_Msk | QUADSPI_SR_FTF_Msk);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+  UNITY_BEGIN();
+  /* qspi_init() */
+  RUN_TEST(Test_QSPIInit_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_QSPIInit_SizeIsInvalid_RegistersShouldNotSet);
+  /* qspi_read() */
+  RUN_TEST(Test_QSPIRead_EdgeCase_RegistersShouldSetProperly);
+  /* qspi_command() */
+  RUN_TEST(Test_QSPICommand_AddressSizeIsInvalid_ShouldFail);
+  /* qspi_memory_map() */
+  RUN_TEST(Test_QSPIMemoryMap_EdgeCase_ShouldKeepDataPhase);
+  /* qspi_poll() */
+  RUN_TEST(Test_QSPIPoll_EdgeCase_RegistersShouldSetProperly);
+  /* qspi_transfer_dma() */
+  RUN_TEST(Test_QSPITransferDMA_StreamIsInUse_ShouldFail);
+
+  return UNITY_END();
+}
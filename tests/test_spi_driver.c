@@ -0,0 +1,397 @@
+/** @file test_spi_driver.c
+ *  @brief Unit tests for the SPI driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "spi.h"
+#include "exti.h"
+
+/* With TXE and RXNE stuck high the stubbed DR loops
+ * every written frame back */
+struct SPIRegs test_regs = {0};
+struct SPIRegs *SPI(const uint32_t base) {
+  (void)base;
+  return &test_regs;
+}
+
+/* Every DMA driver call samples CR2, to check the order
+ * of the SPI and stream enables */
+struct DMARegs test_dma_regs[2] = {0};
+static uint32_t test_dma_cr2 = 0UL;
+struct DMARegs *DMA(const uint8_t num) {
+  test_dma_cr2 = test_regs.CR2;
+  return &test_dma_regs[num];
+}
+
+/* RX and TX stream of every SPI, with the RX handler */
+static const struct {
+  uint8_t DMA;
+  uint8_t RXStream;
+  uint8_t RXChannel;
+  uint8_t TXStream;
+  uint8_t TXChannel;
+  void (*Handler)(void);
+} test_routes[SPI_PERIPH_LEN] = {
+    {1U, 2U, 3U, 3U, 3U, DMA2_Stream2_IRQHandler},
+    {0U, 3U, 0U, 4U, 0U, DMA1_Stream3_IRQHandler},
+    {0U, 0U, 0U, 5U, 0U, DMA1_Stream0_IRQHandler},
+    {1U, 0U, 4U, 4U, 5U, DMA2_Stream0_IRQHandler},
+};
+
+#define TEST_CHSEL(cr) (((cr) & DMA_SxCR_CHSEL_Msk) >> DMA_SxCR_CHSEL_Pos)
+
+static uint8_t test_calls = 0U;
+static spi_status_t test_status = SPI_STATUS_OK;
+
+static void test_done(const spi_peripheral_t spi, const spi_status_t status,
+                      void *context) {
+  (void)spi;
+  (void)context;
+  test_calls++;
+  test_status = status;
+}
+
+/* Raises an event of a stream in the low / high flag
+ * registers and runs the stream interrupt */
+static void test_dma_event(const spi_peripheral_t spi, const uint8_t stream,
+                           const uint32_t slot) {
+  static const uint8_t offsets[4] = {0U, 6U, 16U, 22U};
+  struct DMARegs *regs = &test_dma_regs[test_routes[spi].DMA];
+  const uint32_t flags = (slot << offsets[stream & 3U]);
+
+  if (stream < 4U) {
+    regs->LISR = flags;
+  } else {
+    regs->HISR = flags;
+  }
+  test_routes[spi].Handler();
+  regs->LISR = 0UL;
+  regs->HISR = 0UL;
+}
+
+/* The slave stream delimiter goes through the EXTI driver */
+struct EXTIRegs test_exti_regs = {0};
+struct EXTIRegs *EXTI_PTR = &test_exti_regs;
+struct SYSCFGRegs test_syscfg_regs = {0};
+struct SYSCFGRegs *SYSCFG_PTR = &test_syscfg_regs;
+
+void Test_SPITransferBlock_EdgeCase_ShouldLoopBackInOrder(void) {
+  const uint8_t tx[5] = {0x11U, 0x22U, 0x33U, 0x44U, 0x55U};
+  uint8_t rx[5] = {0};
+
+  spi_transfer_block(SPI_PERIPH_1, tx, rx, sizeof(tx));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(tx, rx, sizeof(tx));
+}
+
+void Test_SPITransferBlock_FrameIs16Bit_ShouldUseHalfWords(void) {
+  const uint16_t tx[3] = {0x1234U, 0xABCDU, 0x00FFU};
+  uint16_t rx[3] = {0};
+
+  test_regs.CR1 = SPI_CR1_DFF_Msk;
+  spi_transfer_block(SPI_PERIPH_1, tx, rx, 3U);
+  TEST_ASSERT_EQUAL_HEX16_ARRAY(tx, rx, 3U);
+}
+
+void Test_SPITransferBlock_BuffersAreNull_ShouldUseDummies(void) {
+  uint8_t rx[4] = {0};
+  const uint8_t expected[4] = {0xFFU, 0xFFU, 0xFFU, 0xFFU};
+
+  spi_transfer_block(SPI_PERIPH_1, NULL, rx, sizeof(rx));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, rx, sizeof(rx));
+
+  /* Nothing to store, only the last frame is left */
+  const uint8_t tx[2] = {0x5AU, 0xA5U};
+  spi_transfer_block(SPI_PERIPH_1, tx, NULL, sizeof(tx));
+  TEST_ASSERT_EQUAL_HEX32(0xA5UL, test_regs.DR);
+}
+
+void Test_SPITransferBlock_SPIIsInvalid_RegisterShouldNotSet(void) {
+  const uint8_t tx[2] = {0x01U, 0x02U};
+  uint8_t rx[2] = {0};
+
+  spi_transfer_block(SPI_PERIPH_LEN, tx, rx, sizeof(tx));
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.DR);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0U, rx, sizeof(rx));
+}
+
+void Test_SPIBuildImage_EdgeCase_ShouldMatchConfiguration(void) {
+  const struct SPIConfig config = {.Use16Bits = TRUE, .CRCPoly = 0x07U};
+  const struct SPIImage image =
+      spi_build_image(SPI_PRESC_DIV16, TRUE, FALSE, config);
+
+  TEST_ASSERT_EQUAL_HEX32((SPI_CR1_DFF_Msk | SPI_CR1_SSM_Msk |
+                           SPI_CR1_SSI_Msk | (0x3UL << SPI_CR1_BR_Pos) |
+                           SPI_CR1_CPOL_Msk | SPI_CR1_MSTR_Msk),
+                          image.CR1);
+  TEST_ASSERT_EQUAL_HEX32(0UL, image.CR2);
+  TEST_ASSERT_EQUAL_HEX16(0x07U, image.CRCPoly);
+
+  const struct SPIImage empty =
+      spi_build_image((spi_prescaler_t)8, TRUE, FALSE, config);
+  TEST_ASSERT_EQUAL_HEX32(0UL, empty.CR1);
+}
+
+void Test_SPIApplyImage_EdgeCase_ShouldKeepDMABits(void) {
+  const struct SPIConfig config = {.TIMode = TRUE, .CRCPoly = 0x07U};
+  const struct SPIImage image =
+      spi_build_image(SPI_PRESC_DIV2, FALSE, TRUE, config);
+
+  test_regs.CR1 = (SPI_CR1_SPE_Msk | SPI_CR1_DFF_Msk);
+  test_regs.CR2 = (SPI_CR2_RXDMAEN_Msk | SPI_CR2_SSOE_Msk);
+  spi_apply_image(SPI_PERIPH_1, image);
+  TEST_ASSERT_EQUAL_HEX32((image.CR1 | SPI_CR1_SPE_Msk), test_regs.CR1);
+  TEST_ASSERT_EQUAL_HEX32((SPI_CR2_RXDMAEN_Msk | SPI_CR2_FRF_Msk),
+                          test_regs.CR2);
+  TEST_ASSERT_EQUAL_HEX32(0x07UL, test_regs.CRCPR);
+}
+
+void Test_SPITransferDMA_EdgeCase_RoutesShouldMatchRequestMap(void) {
+  uint8_t tx[4] = {0};
+  uint8_t rx[4] = {0};
+
+  for (uint8_t spi = 0U; spi < SPI_PERIPH_LEN; spi++) {
+    struct DMARegs *regs = &test_dma_regs[test_routes[spi].DMA];
+    const volatile struct DMAStreamRegs *rxs =
+        &regs->S[test_routes[spi].RXStream];
+    const volatile struct DMAStreamRegs *txs =
+        &regs->S[test_routes[spi].TXStream];
+
+    TEST_ASSERT_TRUE(spi_transfer_dma(spi, tx, rx, 4U, test_done, NULL));
+    TEST_ASSERT_EQUAL_UINT32(test_routes[spi].RXChannel, TEST_CHSEL(rxs->CR));
+    TEST_ASSERT_EQUAL_UINT32(test_routes[spi].TXChannel, TEST_CHSEL(txs->CR));
+    TEST_ASSERT_EQUAL_HEX32((1UL << DMA_SxCR_DIR_Pos),
+                            (txs->CR & DMA_SxCR_DIR_Msk));
+    TEST_ASSERT_EQUAL_HEX32(0UL, (rxs->CR & DMA_SxCR_DIR_Msk));
+    TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)rx, rxs->M0AR);
+    TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)tx, txs->M0AR);
+    TEST_ASSERT_EQUAL_UINT32(4U, rxs->NDTR);
+    TEST_ASSERT_EQUAL_UINT32(4U, txs->NDTR);
+
+    test_dma_event(spi, test_routes[spi].RXStream, 0x20UL);
+    TEST_ASSERT_EQUAL_UINT8(spi + 1U, test_calls);
+    TEST_ASSERT_FALSE(spi_transfer_dma_busy(spi));
+  }
+}
+
+void Test_SPITransferDMA_EdgeCase_ShouldEnableInOrder(void) {
+  uint8_t rx[2] = {0};
+  const volatile struct DMAStreamRegs *rxs = &test_dma_regs[1].S[2];
+  const volatile struct DMAStreamRegs *txs = &test_dma_regs[1].S[3];
+
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, test_done, NULL);
+
+  /* The TX stream was enabled after RXDMAEN, before TXDMAEN */
+  TEST_ASSERT_EQUAL_HEX32(SPI_CR2_RXDMAEN_Msk, test_dma_cr2);
+  TEST_ASSERT_EQUAL_HEX32((SPI_CR2_RXDMAEN_Msk | SPI_CR2_TXDMAEN_Msk),
+                          test_regs.CR2);
+  TEST_ASSERT_TRUE(rxs->CR & DMA_SxCR_EN_Msk);
+  TEST_ASSERT_TRUE(txs->CR & DMA_SxCR_EN_Msk);
+
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.CR2);
+  TEST_ASSERT_EQUAL_UINT8(SPI_STATUS_OK, test_status);
+}
+
+void Test_SPITransferDMA_BuffersAreNull_ShouldUseFixedDummies(void) {
+  uint8_t buf[3] = {0};
+  const volatile struct DMAStreamRegs *rxs = &test_dma_regs[1].S[2];
+  const volatile struct DMAStreamRegs *txs = &test_dma_regs[1].S[3];
+
+  /* TX-only: received frames go to a fixed sink */
+  spi_transfer_dma(SPI_PERIPH_1, buf, NULL, 3U, test_done, NULL);
+  TEST_ASSERT_TRUE(txs->CR & DMA_SxCR_MINC_Msk);
+  TEST_ASSERT_FALSE(rxs->CR & DMA_SxCR_MINC_Msk);
+  TEST_ASSERT_TRUE(rxs->M0AR != 0UL);
+  TEST_ASSERT_TRUE(rxs->M0AR != (uint32_t)(uintptr_t)buf);
+  const uint32_t sink = rxs->M0AR;
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+
+  /* RX-only: 0xFFFF is sent from a fixed source */
+  spi_transfer_dma(SPI_PERIPH_1, NULL, buf, 3U, test_done, NULL);
+  TEST_ASSERT_TRUE(rxs->CR & DMA_SxCR_MINC_Msk);
+  TEST_ASSERT_FALSE(txs->CR & DMA_SxCR_MINC_Msk);
+  TEST_ASSERT_TRUE(txs->M0AR != 0UL);
+  TEST_ASSERT_TRUE(txs->M0AR != sink);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)buf, rxs->M0AR);
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+  TEST_ASSERT_EQUAL_UINT8(2U, test_calls);
+}
+
+void Test_SPITransferDMA_FrameIs16Bit_ShouldUseHalfWords(void) {
+  uint16_t rx[2] = {0};
+  const uint32_t sizes = (DMA_SxCR_MSIZE_Msk | DMA_SxCR_PSIZE_Msk);
+  const volatile struct DMAStreamRegs *rxs = &test_dma_regs[1].S[2];
+  const volatile struct DMAStreamRegs *txs = &test_dma_regs[1].S[3];
+
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, test_done, NULL);
+  TEST_ASSERT_EQUAL_HEX32(0UL, (rxs->CR & sizes));
+  TEST_ASSERT_EQUAL_HEX32(0UL, (txs->CR & sizes));
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+
+  test_regs.CR1 = SPI_CR1_DFF_Msk;
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, test_done, NULL);
+  TEST_ASSERT_EQUAL_HEX32(((1UL << DMA_SxCR_MSIZE_Pos) |
+                           (1UL << DMA_SxCR_PSIZE_Pos)),
+                          (rxs->CR & sizes));
+  TEST_ASSERT_EQUAL_HEX32((rxs->CR & sizes), (txs->CR & sizes));
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+}
+
+void Test_SPITransferDMA_TransferIsRunning_ShouldFail(void) {
+  uint8_t rx[2] = {0};
+
+  TEST_ASSERT_TRUE(spi_transfer_dma(SPI_PERIPH_2, NULL, rx, 2U, test_done,
+                                    NULL));
+  TEST_ASSERT_FALSE(spi_transfer_dma(SPI_PERIPH_2, NULL, rx, 2U, test_done,
+                                     NULL));
+  TEST_ASSERT_TRUE(spi_transfer_dma_busy(SPI_PERIPH_2));
+
+  /* Half transfer or TX events don't end it */
+  test_dma_event(SPI_PERIPH_2, 3U, 0x10UL);
+  TEST_ASSERT_TRUE(spi_transfer_dma_busy(SPI_PERIPH_2));
+
+  test_dma_event(SPI_PERIPH_2, 3U, 0x20UL);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_calls);
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_2));
+}
+
+void Test_SPITransferDMA_TransferError_ShouldReportError(void) {
+  uint8_t rx[2] = {0};
+  const volatile struct DMAStreamRegs *rxs = &test_dma_regs[1].S[2];
+  const volatile struct DMAStreamRegs *txs = &test_dma_regs[1].S[3];
+
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, test_done, NULL);
+  test_dma_event(SPI_PERIPH_1, 2U, 0x08UL);
+
+  TEST_ASSERT_EQUAL_UINT8(1U, test_calls);
+  TEST_ASSERT_EQUAL_UINT8(SPI_STATUS_ERROR, test_status);
+  TEST_ASSERT_FALSE(rxs->CR & DMA_SxCR_EN_Msk);
+  TEST_ASSERT_FALSE(txs->CR & DMA_SxCR_EN_Msk);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.CR2);
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_1));
+}
+
+void Test_SPITransferDMA_CRCMatches_ShouldReportOk(void) {
+  uint8_t rx[2] = {0};
+
+  test_regs.CR1 = (SPI_CR1_SPE_Msk | SPI_CR1_CRCEN_Msk);
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, test_done, NULL);
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+
+  TEST_ASSERT_EQUAL_UINT8(1U, test_calls);
+  TEST_ASSERT_EQUAL_UINT8(SPI_STATUS_OK, test_status);
+  TEST_ASSERT_EQUAL_HEX32((SPI_CR1_SPE_Msk | SPI_CR1_CRCEN_Msk),
+                          test_regs.CR1);
+}
+
+void Test_SPITransferDMA_CRCMismatches_ShouldReportCRC(void) {
+  uint8_t rx[2] = {0};
+
+  test_regs.CR1 = (SPI_CR1_SPE_Msk | SPI_CR1_CRCEN_Msk | SPI_CR1_DFF_Msk);
+  test_regs.SR |= SPI_SR_CRCERR_Msk;
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 1U, test_done, NULL);
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+
+  TEST_ASSERT_EQUAL_UINT8(SPI_STATUS_CRC, test_status);
+  TEST_ASSERT_FALSE(test_regs.SR & SPI_SR_CRCERR_Msk);
+  TEST_ASSERT_EQUAL_HEX32((SPI_CR1_SPE_Msk | SPI_CR1_CRCEN_Msk |
+                           SPI_CR1_DFF_Msk),
+                          test_regs.CR1);
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_1));
+}
+
+void Test_SPITransferDMA_CRCIsOff_ShouldIgnoreCRCError(void) {
+  uint8_t rx[2] = {0};
+
+  test_regs.CR1 = SPI_CR1_SPE_Msk;
+  test_regs.SR |= SPI_SR_CRCERR_Msk;
+  spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, test_done, NULL);
+  test_dma_event(SPI_PERIPH_1, 2U, 0x20UL);
+
+  TEST_ASSERT_EQUAL_UINT8(SPI_STATUS_OK, test_status);
+  TEST_ASSERT_TRUE(test_regs.SR & SPI_SR_CRCERR_Msk);
+}
+
+void Test_SPISlaveStreamStart_BufferIsInvalid_ShouldFail(void) {
+  struct SPISlaveStream stream = {0};
+  uint8_t rx[8];
+  const uint8_t tx[2] = {0};
+
+  TEST_ASSERT_FALSE(spi_slave_stream_start(&stream, SPI_PERIPH_1, NULL, 8U,
+                                           NULL, 0U, GP_BANK_A, 4U, NULL,
+                                           NULL));
+  TEST_ASSERT_FALSE(spi_slave_stream_start(&stream, SPI_PERIPH_1, rx, 8U, tx,
+                                           0U, GP_BANK_A, 4U, NULL, NULL));
+  TEST_ASSERT_FALSE(spi_slave_stream_start(&stream, SPI_PERIPH_LEN, rx, 8U,
+                                           NULL, 0U, GP_BANK_A, 4U, NULL,
+                                           NULL));
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs.CR2);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_exti_regs.IMR);
+}
+
+void Test_SPISlaveStreamStart_DMAIsClaimed_ShouldFail(void) {
+  struct SPISlaveStream stream = {0};
+  uint8_t rx[8];
+
+  /* Shares the claim of spi_transfer_dma() */
+  TEST_ASSERT_TRUE(spi_dma_claim(SPI_PERIPH_1));
+  TEST_ASSERT_FALSE(spi_slave_stream_start(&stream, SPI_PERIPH_1, rx, 8U,
+                                           NULL, 0U, GP_BANK_A, 4U, NULL,
+                                           NULL));
+  spi_dma_release(SPI_PERIPH_1);
+
+  TEST_ASSERT_TRUE(spi_slave_stream_start(&stream, SPI_PERIPH_1, rx, 8U, NULL,
+                                          0U, GP_BANK_A, 4U, NULL, NULL));
+  TEST_ASSERT_FALSE(spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 8U, NULL, NULL));
+  spi_slave_stream_stop(&stream);
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_1));
+}
+
+void setUp(void) {
+  memset(&test_regs, 0, sizeof(test_regs));
+  test_regs.SR = (SPI_SR_TXE_Msk | SPI_SR_RXNE_Msk);
+  memset(test_dma_regs, 0, sizeof(test_dma_regs));
+  test_calls = 0U;
+  test_status = SPI_STATUS_OK;
+}
+
+void tearDown(void) {}
+
+int main(void) {
+  UNITY_BEGIN();
+  /* spi_transfer_block() */
+  RUN_TEST(Test_SPITransferBlock_EdgeCase_ShouldLoopBackInOrder);
+  RUN_TEST(Test_SPITransferBlock_FrameIs16Bit_ShouldUseHalfWords);
+  RUN_TEST(Test_SPITransferBlock_BuffersAreNull_ShouldUseDummies);
+  RUN_TEST(Test_SPITransferBlock_SPIIsInvalid_RegisterShouldNotSet);
+  /* spi_build_image() */
+  RUN_TEST(Test_SPIBuildImage_EdgeCase_ShouldMatchConfiguration);
+  /* spi_apply_image() */
+  RUN_TEST(Test_SPIApplyImage_EdgeCase_ShouldKeepDMABits);
+  /* spi_transfer_dma() */
+  RUN_TEST(Test_SPITransferDMA_EdgeCase_RoutesShouldMatchRequestMap);
+  RUN_TEST(Test_SPITransferDMA_EdgeCase_ShouldEnableInOrder);
+  RUN_TEST(Test_SPITransferDMA_BuffersAreNull_ShouldUseFixedDummies);
+  RUN_TEST(Test_SPITransferDMA_FrameIs16Bit_ShouldUseHalfWords);
+  RUN_TEST(Test_SPITransferDMA_TransferIsRunning_ShouldFail);
+  RUN_TEST(Test_SPITransferDMA_TransferError_ShouldReportError);
+  RUN_TEST(Test_SPITransferDMA_CRCMatches_ShouldReportOk);
+  RUN_TEST(Test_SPITransferDMA_CRCMismatches_ShouldReportCRC);
+  RUN_TEST(Test_SPITransferDMA_CRCIsOff_ShouldIgnoreCRCError);
+  /* spi_slave_stream_start() */
+  RUN_TEST(Test_SPISlaveStreamStart_BufferIsInvalid_ShouldFail);
+  RUN_TEST(Test_SPISlaveStreamStart_DMAIsClaimed_ShouldFail);
+
+  return UNITY_END();
+}
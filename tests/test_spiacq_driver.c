@@ -0,0 +1,168 @@
+/** @file test_spiacq_driver.c
+ *  @brief Unit tests for the SPI ADC acquisition chain
+ *
+ *  The unit tests defined in this file check the timer
+ *  and DMA setup of the chain in a stubbed environment.
+ *  The purpose of these tests is logic checking and does
+ *  not reflect the actual behaviour of registers in real
+ *  MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "spiacq.h"
+#include "exti.h"
+
+#define TEST_LENGTH 4U
+
+/* Register stubs of the drivers the chain links to */
+struct TIMRegs test_tim_regs[2];
+struct TIMRegs *TIM(const uint32_t base) { return &test_tim_regs[base]; }
+
+struct SPIRegs test_spi_regs = {0};
+struct SPIRegs *SPI(const uint32_t base) {
+  (void)base;
+  return &test_spi_regs;
+}
+
+struct DMARegs test_dma_regs[2];
+struct DMARegs *DMA(const uint8_t num) { return &test_dma_regs[num]; }
+
+struct EXTIRegs test_exti_regs = {0};
+struct EXTIRegs *EXTI_PTR = &test_exti_regs;
+struct SYSCFGRegs test_syscfg_regs = {0};
+struct SYSCFGRegs *SYSCFG_PTR = &test_syscfg_regs;
+
+#define RX_STREAM test_dma_regs[1].S[0]
+#define TR_STREAM test_dma_regs[1].S[2]
+
+/* 200 kS/s at the 180 MHz stub clock of TIM1 */
+static const struct SPIAcqConfig test_config = {
+    .Rate = 200000UL, .PulseNs = 500UL, .ReadNs = 1000UL};
+
+static uint16_t test_blocks[2U * TEST_LENGTH];
+static const uint16_t *test_block = NULL;
+static spi_status_t test_status = SPI_STATUS_OK;
+
+static void test_callback(const uint16_t *block, const uint16_t length,
+                          const spi_status_t status, void *context) {
+  (void)length;
+  (void)context;
+  test_block = block;
+  test_status = status;
+}
+
+/* Raises an RX stream event (DMA2 S0, LISR offset 0) */
+static void test_rx_event(const uint32_t flags) {
+  test_dma_regs[1].LISR = flags;
+  DMA2_Stream0_IRQHandler();
+  test_dma_regs[1].LISR = 0UL;
+}
+
+void Test_SPIAcqStart_EdgeCase_RegistersShouldSetProperly(void) {
+  TEST_ASSERT_TRUE(spiacq_start(&test_config, test_blocks, TEST_LENGTH,
+                                test_callback, NULL));
+
+  TEST_ASSERT_EQUAL_UINT32(0UL, test_tim_regs[0].PSC);
+  TEST_ASSERT_EQUAL_UINT32(899UL, test_tim_regs[0].ARR);
+  TEST_ASSERT_EQUAL_UINT32(90UL, test_tim_regs[0].CCR[0]);
+  TEST_ASSERT_EQUAL_UINT32(180UL, test_tim_regs[0].CCR[1]);
+  TEST_ASSERT_EQUAL_HEX32(TIM_DIER_CC2DE_Msk, test_tim_regs[0].DIER);
+  TEST_ASSERT_TRUE(test_tim_regs[0].CR1 & TIM_CR1_CEN_Msk);
+
+  /* Channel 3, double buffered half-words into the blocks */
+  TEST_ASSERT_EQUAL_HEX32(0x06072D15UL, RX_STREAM.CR);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)test_blocks, RX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)&test_blocks[TEST_LENGTH],
+                          RX_STREAM.M1AR);
+  TEST_ASSERT_EQUAL_UINT32(TEST_LENGTH, RX_STREAM.NDTR);
+
+  /* Channel 6, one circular dummy half-word to DR */
+  TEST_ASSERT_EQUAL_HEX32(0x0C022945UL, TR_STREAM.CR);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)&test_spi_regs.DR,
+                          TR_STREAM.PAR);
+  TEST_ASSERT_EQUAL_UINT32(1UL, TR_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32(SPI_CR2_RXDMAEN_Msk, test_spi_regs.CR2);
+}
+
+void Test_SPIAcqStart_EdgeCase_CallbackShouldGetFilledBlock(void) {
+  spiacq_start(&test_config, test_blocks, TEST_LENGTH, test_callback, NULL);
+
+  /* CT already points at the block being filled next */
+  RX_STREAM.CR |= DMA_SxCR_CT_Msk;
+  test_rx_event(0x20UL);
+  TEST_ASSERT_EQUAL_PTR(test_blocks, test_block);
+
+  RX_STREAM.CR &= ~(DMA_SxCR_CT_Msk);
+  test_rx_event(0x20UL);
+  TEST_ASSERT_EQUAL_PTR(&test_blocks[TEST_LENGTH], test_block);
+  TEST_ASSERT_EQUAL_UINT32(2UL, spiacq_blocks());
+
+  /* Errors stop the chain */
+  test_rx_event(0x08UL);
+  TEST_ASSERT_NULL(test_block);
+  TEST_ASSERT_EQUAL_UINT8(SPI_STATUS_ERROR, test_status);
+  TEST_ASSERT_FALSE(test_tim_regs[0].CR1 & TIM_CR1_CEN_Msk);
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_1));
+}
+
+void Test_SPIAcqStart_SPIIsBusy_ShouldFail(void) {
+  uint16_t rx[2] = {0};
+
+  /* A running chain keeps spi_transfer_dma() away */
+  spiacq_start(&test_config, test_blocks, TEST_LENGTH, test_callback, NULL);
+  TEST_ASSERT_FALSE(spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, NULL,
+                                     NULL));
+  TEST_ASSERT_FALSE(spi_transfer_dma(SPI_PERIPH_4, NULL, rx, 2U, NULL,
+                                     NULL));
+  spiacq_stop();
+
+  /* And the other way around */
+  TEST_ASSERT_TRUE(spi_transfer_dma(SPI_PERIPH_1, NULL, rx, 2U, NULL, NULL));
+  TEST_ASSERT_FALSE(spiacq_start(&test_config, test_blocks, TEST_LENGTH,
+                                 test_callback, NULL));
+  TEST_ASSERT_FALSE(test_tim_regs[0].CR1 & TIM_CR1_CEN_Msk);
+
+  /* Stopping an idle chain leaves the transfer alone */
+  spiacq_stop();
+  TEST_ASSERT_TRUE(spi_transfer_dma_busy(SPI_PERIPH_1));
+  test_dma_regs[1].LISR = (0x20UL << 16U);
+  DMA2_Stream2_IRQHandler();
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_1));
+}
+
+void Test_SPIAcqStart_RateIsTooHigh_ShouldFail(void) {
+  struct SPIAcqConfig config = test_config;
+  config.Rate = 90000001UL;
+
+  TEST_ASSERT_FALSE(spiacq_start(&config, test_blocks, TEST_LENGTH,
+                                 test_callback, NULL));
+  TEST_ASSERT_FALSE(spi_transfer_dma_busy(SPI_PERIPH_1));
+  TEST_ASSERT_EQUAL_HEX32(0UL, RX_STREAM.CR);
+}
+
+void setUp(void) {
+  memset(test_tim_regs, 0, sizeof(test_tim_regs));
+  memset(&test_spi_regs, 0, sizeof(test_spi_regs));
+  memset(test_dma_regs, 0, sizeof(test_dma_regs));
+  test_spi_regs.SR = (SPI_SR_TXE_Msk | SPI_SR_RXNE_Msk);
+  test_block = NULL;
+  test_status = SPI_STATUS_OK;
+}
+
+void tearDown(void) { spiacq_stop(); }
+
+int main(void) {
+  UNITY_BEGIN();
+  /* spiacq_start() */
+  RUN_TEST(Test_SPIAcqStart_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_SPIAcqStart_EdgeCase_CallbackShouldGetFilledBlock);
+  RUN_TEST(Test_SPIAcqStart_SPIIsBusy_ShouldFail);
+  RUN_TEST(Test_SPIAcqStart_RateIsTooHigh_ShouldFail);
+
+  return UNITY_END();
+}
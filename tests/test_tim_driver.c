@@ -0,0 +1,75 @@
+/** @file test_tim_driver.c
+ *  @brief Unit tests for the timer driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "tim.h"
+
+/* The stubbed base addresses are 0..1, one per timer */
+struct TIMRegs test_regs[2];
+struct TIMRegs *TIM(const uint32_t base) { return &test_regs[base]; }
+
+void Test_TIMGetClock_EdgeCase_ShouldUseDoubledBusClock(void) {
+  TEST_ASSERT_EQUAL_UINT32(180000000UL, tim_get_clock(TIM_PERIPH_1));
+  TEST_ASSERT_EQUAL_UINT32(90000000UL, tim_get_clock(TIM_PERIPH_2));
+  TEST_ASSERT_EQUAL_UINT32(0UL, tim_get_clock(TIM_PERIPH_LEN));
+}
+
+void Test_TIMConfigurePWM_EdgeCase_RegistersShouldSetProperly(void) {
+  test_regs[0].CCMR[0] = 0x00FFUL;
+  tim_configure_pwm(TIM_PERIPH_1, TIM_CHANNEL_2, 450U, TRUE);
+
+  TEST_ASSERT_EQUAL_HEX32(0x68FFUL, test_regs[0].CCMR[0]);
+  TEST_ASSERT_EQUAL_HEX32(0x0030UL, test_regs[0].CCER);
+  TEST_ASSERT_EQUAL_UINT32(450UL, test_regs[0].CCR[1]);
+  TEST_ASSERT_EQUAL_HEX32(TIM_BDTR_MOE_Msk, test_regs[0].BDTR);
+
+  /* General purpose timers have no main output */
+  tim_configure_pwm(TIM_PERIPH_2, TIM_CHANNEL_3, 10U, FALSE);
+  TEST_ASSERT_EQUAL_HEX32(0x0068UL, test_regs[1].CCMR[1]);
+  TEST_ASSERT_EQUAL_HEX32(0x0100UL, test_regs[1].CCER);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs[1].BDTR);
+}
+
+void Test_TIMConfigurePWM_ChannelIsInvalid_RegisterShouldNotSet(void) {
+  tim_configure_pwm(TIM_PERIPH_1, (tim_channel_t)4, 1U, FALSE);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs[0].CCER);
+  TEST_ASSERT_EQUAL_HEX32(0UL, test_regs[0].BDTR);
+}
+
+void Test_TIMSetDMA_EdgeCase_RegisterShouldSetProperly(void) {
+  const struct TIMDMARequests requests = {.Update = TRUE, .CC2 = TRUE};
+
+  test_regs[0].DIER = 0x1UL; // Update interrupt stays
+  tim_set_dma(TIM_PERIPH_1, requests);
+  TEST_ASSERT_EQUAL_HEX32((0x1UL | TIM_DIER_UDE_Msk | TIM_DIER_CC2DE_Msk),
+                          test_regs[0].DIER);
+}
+
+void setUp(void) { memset(test_regs, 0, sizeof(test_regs)); }
+
+void tearDown(void) {}
+
+int main(void) {
+  UNITY_BEGIN();
+  /* tim_get_clock() */
+  RUN_TEST(Test_TIMGetClock_EdgeCase_ShouldUseDoubledBusClock);
+  /* tim_configure_pwm() */
+  RUN_TEST(Test_TIMConfigurePWM_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_TIMConfigurePWM_ChannelIsInvalid_RegisterShouldNotSet);
+  /* tim_set_dma() */
+  RUN_TEST(Test_TIMSetDMA_EdgeCase_RegisterShouldSetProperly);
+
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Round trip tests for tools/tlog_decode.py.
+
+Records are packed with the layout constants of tlog.h and
+decoded against a minimal ELF32 holding the .tlog section,
+placed at address 0 like the linker script does.
+"""
+
+import importlib.util
+import os
+import re
+import struct
+import tempfile
+import unittest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+HEADER = os.path.join(ROOT, "src", "drivers", "peripherals", "communication", "tlog.h")
+
+SPEC = importlib.util.spec_from_file_location(
+    "tlog_decode", os.path.join(ROOT, "tools", "tlog_decode.py"))
+tlog_decode = importlib.util.module_from_spec(SPEC)
+SPEC.loader.exec_module(tlog_decode)
+
+
+def header_define(name):
+    """Returns the value of a TLOG define of tlog.h."""
+    with open(HEADER, "r", encoding="utf-8") as header:
+        match = re.search(r"#define %s\s+\(?(0x[0-9A-Fa-f]+|\d+)U" % name, header.read())
+    return int(match.group(1), 0)
+
+
+TLOG_SYNC = header_define("TLOG_SYNC")
+TLOG_ID_MSK = header_define("TLOG_ID_Msk")
+TLOG_ARGS_POS = header_define("TLOG_ARGS_Pos")
+
+
+def pack_record(string_id, *args):
+    """Packs a record the way tlog_write() does."""
+    header = TLOG_SYNC | (len(args) << TLOG_ARGS_POS) | (string_id & TLOG_ID_MSK)
+    return struct.pack("<%dI" % (len(args) + 1), header, *args)
+
+
+def build_elf(strings, address=0):
+    """Returns an ELF32 image with a .tlog section and its name table."""
+    names = b"\0.tlog\0.shstrtab\0"
+    tlog_offset = 52
+    names_offset = tlog_offset + len(strings)
+    shoff = names_offset + len(names)
+
+    ident = b"\x7fELF\x01\x01\x01" + b"\0" * 9
+    elf = ident + struct.pack("<HHIIIIIHHHHHH", 2, 40, 1, 0, 0, shoff, 0,
+                              52, 0, 0, 40, 3, 2)
+    elf += strings + names
+    elf += struct.pack("<10I", *([0] * 10))
+    elf += struct.pack("<10I", 1, 1, 0, address, tlog_offset, len(strings), 0, 0, 1, 0)
+    elf += struct.pack("<10I", 7, 3, 0, 0, names_offset, len(names), 0, 0, 1, 0)
+    return elf
+
+
+class TlogDecodeTest(unittest.TestCase):
+    """Checks the ID to format mapping and the record parsing."""
+
+    STRINGS = [b"boot\n", b"adc %u = %d\n", b"v=%.2f %%\n", b"%c 0x%04x\n"]
+
+    def setUp(self):
+        self.table = b""
+        self.ids = []
+        for string in self.STRINGS:
+            self.ids.append(len(self.table))
+            self.table += string + b"\0"
+        handle, self.path = tempfile.mkstemp(suffix=".elf")
+        with os.fdopen(handle, "wb") as elf:
+            elf.write(build_elf(self.table))
+
+    def tearDown(self):
+        os.remove(self.path)
+
+    def decode(self, stream, size=256):
+        base, strings = tlog_decode.read_tlog_section(self.path)
+        chunks = [stream[i:i + size] for i in range(0, len(stream), size)]
+        reader = iter(chunks + [b""])
+        return list(tlog_decode.decode(lambda: next(reader), base, strings))
+
+    def test_section_should_be_found(self):
+        base, strings = tlog_decode.read_tlog_section(self.path)
+        self.assertEqual(0, base)
+        self.assertEqual(self.table, strings)
+
+    def test_records_should_round_trip(self):
+        float_bits = struct.unpack("<I", struct.pack("<f", 1.5))[0]
+        stream = (pack_record(self.ids[0]) +
+                  pack_record(self.ids[1], 3, 0xFFFFFFF4) +
+                  pack_record(self.ids[2], float_bits) +
+                  pack_record(self.ids[3], ord("A"), 0xBEEF))
+
+        expected = ["boot\n", "adc 3 = -12\n", "v=1.50 %\n", "A 0xbeef\n"]
+        self.assertEqual(expected, self.decode(stream))
+        self.assertEqual(expected, self.decode(stream, size=3))
+
+    def test_garbage_should_resync(self):
+        stream = (b"\x01\x02\x03" + pack_record(self.ids[1], 1, 2) +
+                  pack_record(len(self.table) + 16) + pack_record(self.ids[0]))
+
+        self.assertEqual(["adc 1 = 2\n", "boot\n"], self.decode(stream))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,168 @@
+/** @file test_tlog_driver.c
+ *  @brief Unit tests for the tokenized logger
+ *
+ *  The unit tests defined in this file handle the
+ *  record bookkeeping of the log ring and its drain
+ *  through the stubbed USART1 transmit DMA. The drain
+ *  test runs first, the ring is not reset in between.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include "unity.h"
+#include "tlog.h"
+
+/* Register stubs of the drivers the logger links to */
+struct USARTRegs test_usart_regs = {0};
+struct USARTRegs *USART(const uint32_t base) {
+  (void)base;
+  return &test_usart_regs;
+}
+
+struct GPIORegs test_gpio_regs = {0};
+struct GPIORegs *GPIO(const uint8_t bank) {
+  (void)bank;
+  return &test_gpio_regs;
+}
+
+struct DMARegs test_dma_regs = {0};
+struct DMARegs *DMA(const uint8_t num) {
+  (void)num;
+  return &test_dma_regs;
+}
+
+/* USART1 transmits on DMA2 stream 7, at offset 22 of HISR */
+#define TX_STREAM test_dma_regs.S[7]
+#define TX_TC     (0x20UL << 22U)
+#define TX_TE     (0x08UL << 22U)
+
+/* Completes the chunk in flight like the hardware does */
+static void test_tx_event(const uint32_t flags) {
+  TX_STREAM.CR &= ~(DMA_SxCR_EN_Msk);
+  test_dma_regs.HISR = flags;
+  DMA2_Stream7_IRQHandler();
+  test_dma_regs.HISR = 0UL;
+}
+
+/* The stub registers keep the low half of host pointers
+ * only, the ring lies close to the test globals */
+static const uint32_t *test_tx_words(void) {
+  const uintptr_t near = (uintptr_t)&test_dma_regs;
+  const int32_t delta = (int32_t)(TX_STREAM.M0AR - (uint32_t)near);
+  return (const uint32_t *)(near + (intptr_t)delta);
+}
+
+/* The format string is not an argument */
+_Static_assert(TLOG_ARGC("none") == 0, "TLOG argument count mismatch.");
+_Static_assert(TLOG_ARGC("%d %d %d", 1, 2, 3) == 3,
+               "TLOG argument count mismatch.");
+
+void Test_TLOGInit_EdgeCase_RingShouldDrainToUSART(void) {
+  const uint32_t adc[3] = {0x000123UL, 7UL, 0xFFFFFFF4UL};
+  const uint32_t boot[1] = {0xAB000456UL};
+  uint32_t record[TLOG_MAX_ARGS + 1U];
+
+  /* Kept until a USART is selected */
+  tlog_write(adc, 2U);
+  TEST_ASSERT_EQUAL_HEX32(0UL, TX_STREAM.CR);
+  tlog_init(USART_PERIPH_1);
+  const uint32_t base = TX_STREAM.M0AR;
+  TEST_ASSERT_EQUAL_UINT32(12UL, TX_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)&test_usart_regs.DR,
+                          TX_STREAM.PAR);
+  TEST_ASSERT_TRUE(test_usart_regs.CR3 & USART_CR3_DMAT_Msk);
+  TEST_ASSERT_EQUAL_HEX32(0xA2000123UL, test_tx_words()[0]);
+  TEST_ASSERT_EQUAL_HEX32(7UL, test_tx_words()[1]);
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFF4UL, test_tx_words()[2]);
+
+  /* Records of a busy drain follow on completion */
+  tlog_write(boot, 0U);
+  TEST_ASSERT_EQUAL_UINT32(12UL, TX_STREAM.NDTR);
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_HEX32((base + 12UL), TX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT32(4UL, TX_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32(0xA0000456UL, test_tx_words()[0]);
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_UINT32(0UL, tlog_pending());
+
+  /* 27 full records up to word 247 */
+  for (uint32_t i = 0U; i <= TLOG_MAX_ARGS; i++) {
+    record[i] = (0x10UL + i);
+  }
+  for (uint8_t i = 0U; i < 27U; i++) {
+    tlog_write(record, TLOG_MAX_ARGS);
+  }
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_UINT32((234UL * 4UL), TX_STREAM.NDTR);
+
+  /* The next one wraps, its chunk stops at the ring end */
+  tlog_write(adc, 2U);
+  tlog_write(record, TLOG_MAX_ARGS);
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_HEX32((base + (247UL * 4UL)), TX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT32(36UL, TX_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32(0xA2000123UL, test_tx_words()[0]);
+  TEST_ASSERT_EQUAL_HEX32(0xA8000010UL, test_tx_words()[3]);
+
+  /* Errors lose the chunk but the drain goes on */
+  test_tx_event(TX_TE);
+  TEST_ASSERT_EQUAL_HEX32(base, TX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT32(12UL, TX_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32(0x16UL, test_tx_words()[0]);
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_UINT32(0UL, tlog_pending());
+  TEST_ASSERT_EQUAL_UINT32(0UL, tlog_dropped());
+}
+
+void Test_TLOG_EdgeCase_ShouldQueueHeaderAndArguments(void) {
+  const uint32_t pending = tlog_pending();
+  TLOG("boot\n");
+  TLOG("adc %u = %d\n", 3U, -12);
+  TEST_ASSERT_EQUAL_UINT32(pending + 1U + 3U, tlog_pending());
+}
+
+void Test_TLOGFloat_EdgeCase_ShouldKeepBits(void) {
+  TEST_ASSERT_EQUAL_HEX32(0x3F800000UL, tlog_float(1.0f));
+}
+
+void Test_TLOGWrite_TooManyArguments_ShouldNotQueue(void) {
+  const uint32_t words[TLOG_MAX_ARGS + 2U] = {0};
+  const uint32_t pending = tlog_pending();
+  tlog_write(words, TLOG_MAX_ARGS + 1U);
+  tlog_write(NULL, 0U);
+  TEST_ASSERT_EQUAL_UINT32(pending, tlog_pending());
+}
+
+void Test_TLOGWrite_RingIsFull_ShouldDropWholeRecords(void) {
+  const uint32_t words[TLOG_MAX_ARGS + 1U] = {0};
+  while ((TLOG_RING_LEN - tlog_pending()) >= (TLOG_MAX_ARGS + 1U)) {
+    tlog_write(words, TLOG_MAX_ARGS);
+  }
+
+  const uint32_t pending = tlog_pending();
+  const uint32_t dropped = tlog_dropped();
+  tlog_write(words, TLOG_MAX_ARGS);
+  TEST_ASSERT_EQUAL_UINT32(pending, tlog_pending());
+  TEST_ASSERT_EQUAL_UINT32(dropped + 1U, tlog_dropped());
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  /* tlog_init() */
+  RUN_TEST(Test_TLOGInit_EdgeCase_RingShouldDrainToUSART);
+  /* TLOG() */
+  RUN_TEST(Test_TLOG_EdgeCase_ShouldQueueHeaderAndArguments);
+  RUN_TEST(Test_TLOGFloat_EdgeCase_ShouldKeepBits);
+  /* tlog_write() */
+  RUN_TEST(Test_TLOGWrite_TooManyArguments_ShouldNotQueue);
+  RUN_TEST(Test_TLOGWrite_RingIsFull_ShouldDropWholeRecords);
+
+  return UNITY_END();
+}
@@ -0,0 +1,494 @@
+/** @file test_usart_driver.c
+ *  @brief Unit tests for the USART driver
+ *
+ *  The unit tests defined in this file handle
+ *  mostly invalid parameter and edge cases in a
+ *  stubbed environment. The purpose of these tests
+ *  is logic checking and does not reflect the
+ *  actual behaviour of registers in real MCUs.
+ *
+ *  @author Vasileios Ch. (BillisC)
+ */
+
+/* -- Includes -- */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "usart.h"
+#include "isr.h"
+
+/* The stubbed base addresses are 0..5, one per
+ * peripheral, plus an arbitrary one */
+struct USARTRegs empty_regs = {0};
+struct USARTRegs test_regs[6 + 1];
+struct USARTRegs *USART(const uint32_t base) { return &test_regs[base]; }
+
+#define REGS(base) test_regs[(base)]
+
+/* The RTS pin goes through the GPIO driver */
+struct GPIORegs test_gpio_regs = {0};
+struct GPIORegs *GPIO(const uint8_t bank) {
+  (void)bank;
+  return &test_gpio_regs;
+}
+
+/* USART2 transmits on DMA1 stream 6, whose flags sit at
+ * offset 16 of HISR */
+struct DMARegs test_dma_regs[2];
+struct DMARegs *DMA(const uint8_t num) { return &test_dma_regs[num]; }
+
+#define TX_STREAM test_dma_regs[0].S[6]
+#define TX_TC     (0x20UL << 16U)
+#define TX_TE     (0x08UL << 16U)
+
+static const uint8_t *test_done[USART_DMA_QUEUE_LEN * 2U];
+static uint8_t test_done_count = 0U;
+static uint8_t test_errors = 0U;
+
+static void test_tx_done(const usart_peripheral_t usart, const uint8_t *buffer,
+                         const uint16_t length, const _Bool error,
+                         void *context) {
+  (void)usart;
+  (void)length;
+  (void)context;
+  test_done[test_done_count++] = buffer;
+  test_errors += error;
+}
+
+/* Raises the stream event and runs its interrupt */
+static void test_tx_event(const uint32_t flags) {
+  test_dma_regs[0].HISR = flags;
+  DMA1_Stream6_IRQHandler();
+  test_dma_regs[0].HISR = 0UL;
+}
+
+/* USART2 receives on DMA1 stream 5, at offset 6 of HISR */
+#define RX_STREAM test_dma_regs[0].S[5]
+#define RX_HT     (0x10UL << 6U)
+#define RX_TC     (0x20UL << 6U)
+#define RX_SIZE   16U
+
+static uint8_t test_ring[RX_SIZE];
+static uint16_t test_frames[4][2];
+static uint8_t test_frame_count = 0U;
+static uint32_t test_flags = 0U;
+
+static void test_rx_frame(const usart_peripheral_t usart, const uint8_t *ring,
+                          const uint16_t offset, const uint16_t length,
+                          void *context) {
+  (void)usart;
+  (void)ring;
+  (void)context;
+  test_frames[test_frame_count][0] = offset;
+  test_frames[test_frame_count][1] = length;
+  test_frame_count++;
+}
+
+static void test_irq(const usart_peripheral_t usart, const uint32_t flags,
+                     void *context) {
+  (void)usart;
+  (void)context;
+  test_flags |= flags;
+}
+
+/* Moves the DMA write offset and raises a stream event */
+static void test_rx_event(const uint16_t position, const uint32_t flags) {
+  RX_STREAM.NDTR = (RX_SIZE - position);
+  test_dma_regs[0].HISR = flags;
+  DMA1_Stream5_IRQHandler();
+  test_dma_regs[0].HISR = 0UL;
+}
+
+/* Moves the DMA write offset and lets the line go idle */
+static void test_rx_idle(const uint16_t position) {
+  RX_STREAM.NDTR = (RX_SIZE - position);
+  REGS(USART2_BASE).SR = USART_SR_IDLE_Msk;
+  USART2_IRQHandler();
+  REGS(USART2_BASE).SR = 0UL;
+}
+
+/* Constant rates must fold at compile time */
+_Static_assert(USART_BAUD_BRR(USART_APB1_HZ, 115200UL) == 0x187UL,
+               "USART baudrate macro does not fold.");
+
+void Test_USARTCalcBaud_APB1_ShouldUseAPB1Clock(void) {
+  const struct USARTBaudConfig baud = usart_calc_baud(USART_PERIPH_2, 115200U);
+  TEST_ASSERT_EQUAL_HEX16(0x0187U, baud.BRR);
+  TEST_ASSERT_FALSE(baud.Over8);
+  TEST_ASSERT_EQUAL_UINT32(115090UL, baud.Actual);
+  TEST_ASSERT_EQUAL_INT32(-954, baud.ErrorPPM);
+}
+
+void Test_USARTCalcBaud_APB2_ShouldUseAPB2Clock(void) {
+  const struct USARTBaudConfig baud = usart_calc_baud(USART_PERIPH_1, 921600U);
+  TEST_ASSERT_EQUAL_HEX16(0x0062U, baud.BRR);
+  TEST_ASSERT_FALSE(baud.Over8);
+  TEST_ASSERT_EQUAL_INT32(-3508, baud.ErrorPPM);
+}
+
+void Test_USARTCalcBaud_EdgeCase_ShouldSelectOver8(void) {
+  const struct USARTBaudConfig baud =
+      usart_calc_baud(USART_PERIPH_6, 11250000U);
+  TEST_ASSERT_EQUAL_HEX16(0x0010U, baud.BRR);
+  TEST_ASSERT_TRUE(baud.Over8);
+  TEST_ASSERT_EQUAL_UINT32(11250000UL, baud.Actual);
+  TEST_ASSERT_EQUAL_INT32(0, baud.ErrorPPM);
+}
+
+void Test_USARTCalcBaud_RateIsUnreachable_ShouldReturnZero(void) {
+  const struct USARTBaudConfig baud =
+      usart_calc_baud(USART_PERIPH_2, 12000000U);
+  TEST_ASSERT_EQUAL_UINT32(0UL, baud.Actual);
+  TEST_ASSERT_EQUAL_HEX16(0x0000U, baud.BRR);
+}
+
+void Test_USARTCalcBaud_RateIsZero_ShouldReturnZero(void) {
+  const struct USARTBaudConfig baud = usart_calc_baud(USART_PERIPH_2, 0U);
+  TEST_ASSERT_EQUAL_UINT32(0UL, baud.Actual);
+}
+
+void Test_USARTStart_EdgeCase_RegistersShouldSetProperly(void) {
+  usart_start(USART_PERIPH_1, 10000000U, USART_MODE_BO);
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x00000011UL, REGS(USART1_BASE).BRR,
+                                  "Register is BRR");
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x0000A00CUL, REGS(USART1_BASE).CR1,
+                                  "Register is CR1");
+}
+
+void Test_USARTStart_RateIsUnreachable_RegistersShouldNotSet(void) {
+  usart_start(USART_PERIPH_2, 12000000U, USART_MODE_TX);
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x00000000UL, REGS(USART2_BASE).BRR,
+                                  "Register is BRR");
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x00000000UL, REGS(USART2_BASE).CR1,
+                                  "Register is CR1");
+}
+
+void Test_USARTStart_USARTIsInvalid_RegistersShouldNotSet(void) {
+  usart_start(6U, 115200U, USART_MODE_TX);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_regs[6].CR1);
+}
+
+void Test_USARTWrite_EdgeCase_ShouldSendZeroBytes(void) {
+  const uint8_t payload[3] = {0x00U, 0x00U, 0xA5U};
+  REGS(USART2_BASE).SR = 0x00000080UL; // TXE only, TC never set
+  usart_write(USART_PERIPH_2, payload, sizeof(payload));
+  TEST_ASSERT_EQUAL_HEX32(0x000000A5UL, REGS(USART2_BASE).DR);
+  TEST_ASSERT_EQUAL_HEX32(0x00000080UL, REGS(USART2_BASE).SR);
+}
+
+void Test_USARTWrite_LengthIsZero_RegisterShouldNotSet(void) {
+  const uint8_t payload[1] = {0x55U};
+  REGS(USART2_BASE).SR = 0x00000080UL;
+  usart_write(USART_PERIPH_2, payload, 0U);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, REGS(USART2_BASE).DR);
+}
+
+void Test_USARTWrite_USARTIsInvalid_RegisterShouldNotSet(void) {
+  const uint8_t payload[1] = {0x55U};
+  test_regs[6].SR = 0x00000080UL;
+  usart_write(6U, payload, sizeof(payload));
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_regs[6].DR);
+}
+
+void Test_USARTSetFlowControl_EdgeCase_RegisterShouldSetProperly(void) {
+  REGS(USART3_BASE).CR3 = 0x00000041UL;
+  usart_set_flow_control(USART_PERIPH_3, TRUE, TRUE);
+  TEST_ASSERT_EQUAL_HEX32(0x00000341UL, REGS(USART3_BASE).CR3);
+  usart_set_flow_control(USART_PERIPH_3, FALSE, TRUE);
+  TEST_ASSERT_EQUAL_HEX32(0x00000241UL, REGS(USART3_BASE).CR3);
+}
+
+void Test_USARTSetFlowControl_USARTIsUART_RegisterShouldNotSet(void) {
+  usart_set_flow_control(UART_PERIPH_4, TRUE, TRUE);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, REGS(UART4_BASE).CR3);
+}
+
+void Test_USARTTxDMA_EdgeCase_QueueShouldChainOnTC(void) {
+  static const uint8_t first[3] = {1U, 2U, 3U};
+  static const uint8_t second[5] = {4U, 5U, 6U, 7U, 8U};
+  const uint32_t dr = (uint32_t)(uintptr_t)&REGS(USART2_BASE).DR;
+
+  TEST_ASSERT_TRUE(usart_tx_dma(USART_PERIPH_2, first, 3U, test_tx_done,
+                                NULL));
+  TEST_ASSERT_TRUE(usart_tx_dma(USART_PERIPH_2, second, 5U, test_tx_done,
+                                NULL));
+  TEST_ASSERT_TRUE(usart_tx_dma_busy(USART_PERIPH_2));
+  TEST_ASSERT_EQUAL_HEX32(dr, TX_STREAM.PAR);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)first, TX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT32(3U, TX_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32(0x08010455UL, TX_STREAM.CR);
+  TEST_ASSERT_EQUAL_HEX32(0x00000080UL, REGS(USART2_BASE).CR3);
+
+  /* The second buffer is loaded before the first is reported */
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_done_count);
+  TEST_ASSERT_EQUAL_PTR(first, test_done[0]);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)second, TX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT32(5U, TX_STREAM.NDTR);
+  TEST_ASSERT_EQUAL_HEX32((0x3DUL << 16U), test_dma_regs[0].HIFCR);
+
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_PTR(second, test_done[1]);
+  TEST_ASSERT_EQUAL_UINT8(0U, test_errors);
+  TEST_ASSERT_FALSE(usart_tx_dma_busy(USART_PERIPH_2));
+}
+
+void Test_USARTTxDMA_QueueIsFull_ShouldFailAndWrap(void) {
+  static const uint8_t data[USART_DMA_QUEUE_LEN + 1U] = {0};
+  uint8_t i;
+
+  /* One slot always stays free */
+  for (i = 0U; i < (USART_DMA_QUEUE_LEN - 1U); i++) {
+    TEST_ASSERT_TRUE(usart_tx_dma(USART_PERIPH_2, &data[i], 1U, test_tx_done,
+                                  NULL));
+  }
+  TEST_ASSERT_FALSE(usart_tx_dma(USART_PERIPH_2, &data[i], 1U, test_tx_done,
+                                 NULL));
+
+  /* Retiring one frees the slot behind the head */
+  test_tx_event(TX_TC);
+  TEST_ASSERT_TRUE(usart_tx_dma(USART_PERIPH_2, &data[i], 1U, test_tx_done,
+                                NULL));
+  TEST_ASSERT_FALSE(usart_tx_dma(USART_PERIPH_2, &data[i + 1U], 1U,
+                                 test_tx_done, NULL));
+
+  for (i = 0U; i < (USART_DMA_QUEUE_LEN - 1U); i++) { test_tx_event(TX_TC); }
+  TEST_ASSERT_FALSE(usart_tx_dma_busy(USART_PERIPH_2));
+  TEST_ASSERT_EQUAL_UINT8(USART_DMA_QUEUE_LEN, test_done_count);
+  for (i = 0U; i < USART_DMA_QUEUE_LEN; i++) {
+    TEST_ASSERT_EQUAL_PTR(&data[i], test_done[i]);
+  }
+}
+
+void Test_USARTTxDMA_TransferError_ShouldReportAndContinue(void) {
+  static const uint8_t first[2] = {1U, 2U};
+  static const uint8_t second[2] = {3U, 4U};
+
+  usart_tx_dma(USART_PERIPH_2, first, 2U, test_tx_done, NULL);
+  usart_tx_dma(USART_PERIPH_2, second, 2U, test_tx_done, NULL);
+
+  test_tx_event(TX_TE);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_errors);
+  TEST_ASSERT_EQUAL_PTR(first, test_done[0]);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)second, TX_STREAM.M0AR);
+
+  test_tx_event(TX_TC);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_errors);
+  TEST_ASSERT_FALSE(usart_tx_dma_busy(USART_PERIPH_2));
+}
+
+void Test_USARTTxDMA_BufferIsNull_ShouldFail(void) {
+  TEST_ASSERT_FALSE(usart_tx_dma(USART_PERIPH_2, NULL, 1U, NULL, NULL));
+  TEST_ASSERT_FALSE(usart_tx_dma_busy(USART_PERIPH_2));
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, TX_STREAM.CR);
+}
+
+void Test_USARTRxDMA_EdgeCase_FramesShouldBeRingViews(void) {
+  REGS(USART2_BASE).CR1 = USART_CR1_RXNEIE_Msk;
+  TEST_ASSERT_TRUE(usart_rx_dma_start(USART_PERIPH_2, test_ring, RX_SIZE,
+                                      test_rx_frame, NULL));
+  TEST_ASSERT_EQUAL_HEX32(USART_CR1_IDLEIE_Msk, REGS(USART2_BASE).CR1);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)test_ring, RX_STREAM.M0AR);
+  TEST_ASSERT_EQUAL_UINT32(RX_SIZE, RX_STREAM.NDTR);
+
+  test_rx_idle(5U);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_frame_count);
+  TEST_ASSERT_EQUAL_UINT16(0U, test_frames[0][0]);
+  TEST_ASSERT_EQUAL_UINT16(5U, test_frames[0][1]);
+
+  /* HT and TC only track the offset, the frame wraps */
+  test_rx_event(8U, RX_HT);
+  test_rx_event(0U, RX_TC);
+  TEST_ASSERT_EQUAL_UINT8(1U, test_frame_count);
+  test_rx_idle(3U);
+  TEST_ASSERT_EQUAL_UINT8(2U, test_frame_count);
+  TEST_ASSERT_EQUAL_UINT16(5U, test_frames[1][0]);
+  TEST_ASSERT_EQUAL_UINT16(14U, test_frames[1][1]);
+
+  /* Idle without new bytes delivers nothing */
+  test_rx_idle(3U);
+  TEST_ASSERT_EQUAL_UINT8(2U, test_frame_count);
+  usart_rx_dma_stop(USART_PERIPH_2);
+}
+
+void Test_USARTSetCallback_EdgeCase_ShouldGetEnabledFlags(void) {
+  const struct USARTISR isr = {.TXEI = TRUE, .TCI = TRUE};
+  usart_set_interrupts(USART_PERIPH_2, isr);
+  usart_set_callback(USART_PERIPH_2, test_irq, NULL);
+
+  REGS(USART2_BASE).SR = (USART_SR_TXE_Msk | USART_SR_RXNE_Msk);
+  USART2_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(USART_SR_TXE_Msk, test_flags);
+  TEST_ASSERT_EQUAL_HEX32(0x000000C0UL, REGS(USART2_BASE).CR1);
+  usart_set_callback(USART_PERIPH_2, NULL, NULL);
+}
+
+void Test_USARTSetCallback_CallbackIsMissing_SourcesShouldMute(void) {
+  const struct USARTISR isr = {.TXEI = TRUE, .RXNEI = TRUE, .EI = TRUE};
+  usart_set_interrupts(USART_PERIPH_2, isr);
+
+  REGS(USART2_BASE).SR = USART_SR_TXE_Msk;
+  USART2_IRQHandler();
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, REGS(USART2_BASE).CR1);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, REGS(USART2_BASE).CR3);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_flags);
+}
+
+void Test_USARTRxDMASetRTS_RingIsNotStarted_ShouldFail(void) {
+  TEST_ASSERT_FALSE(usart_rx_dma_set_rts(USART_PERIPH_2, GP_BANK_A, 1U, 32U,
+                                         8U));
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_gpio_regs.MODER);
+}
+
+void Test_USARTRxDMASetRTS_EdgeCase_PinShouldFollowWatermarks(void) {
+  usart_rx_dma_start(USART_PERIPH_2, test_ring, RX_SIZE, test_rx_frame, NULL);
+  TEST_ASSERT_TRUE(usart_rx_dma_set_rts(USART_PERIPH_2, GP_BANK_A, 1U, 8U,
+                                        2U));
+  TEST_ASSERT_EQUAL_HEX32(0x00020000UL, test_gpio_regs.BSSR);
+
+  /* Half transfer reaches the high watermark */
+  test_gpio_regs.BSSR = 0UL;
+  test_rx_event(8U, RX_HT);
+  TEST_ASSERT_EQUAL_HEX32(0x00000002UL, test_gpio_regs.BSSR);
+
+  /* Still above the low watermark after TC */
+  test_gpio_regs.BSSR = 0UL;
+  usart_rx_dma_release(USART_PERIPH_2, 4U);
+  test_rx_event(0U, RX_TC);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_gpio_regs.BSSR);
+
+  usart_rx_dma_release(USART_PERIPH_2, 10U);
+  TEST_ASSERT_EQUAL_HEX32(0x00020000UL, test_gpio_regs.BSSR);
+  TEST_ASSERT_EQUAL_UINT32(0U, usart_rx_dma_dropped(USART_PERIPH_2));
+  usart_rx_dma_stop(USART_PERIPH_2);
+}
+
+void Test_USARTRxDMASetRTS_RemoteKeepsSending_ShouldCountDropped(void) {
+  usart_rx_dma_start(USART_PERIPH_2, test_ring, RX_SIZE, test_rx_frame, NULL);
+  usart_rx_dma_set_rts(USART_PERIPH_2, GP_BANK_A, 1U, 8U, 2U);
+
+  test_rx_event(8U, RX_HT);
+  test_rx_event(0U, RX_TC);
+  TEST_ASSERT_EQUAL_UINT32(0U, usart_rx_dma_dropped(USART_PERIPH_2));
+  test_rx_event(8U, RX_HT);
+  TEST_ASSERT_EQUAL_UINT32(1U, usart_rx_dma_dropped(USART_PERIPH_2));
+  usart_rx_dma_stop(USART_PERIPH_2);
+}
+
+void Test_USARTRxDMASetRTS_HighIsAboveHalfRing_ShouldFail(void) {
+  usart_rx_dma_start(USART_PERIPH_2, test_ring, RX_SIZE, test_rx_frame, NULL);
+  TEST_ASSERT_FALSE(usart_rx_dma_set_rts(USART_PERIPH_2, GP_BANK_A, 1U,
+                                         (RX_SIZE / 2U) + 1U, 2U));
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, test_gpio_regs.MODER);
+  usart_rx_dma_stop(USART_PERIPH_2);
+}
+
+void Test_USARTSetMuteMode_EdgeCase_RegistersShouldSetProperly(void) {
+  REGS(USART6_BASE).CR2 = 0x00002003UL;
+  usart_set_mute_mode(USART_PERIPH_6, USART_WAKEUP_ADDR, 0x0AU);
+  usart_mute(USART_PERIPH_6);
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x0000200AUL, REGS(USART6_BASE).CR2,
+                                  "Register is CR2");
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x00000802UL, REGS(USART6_BASE).CR1,
+                                  "Register is CR1");
+  TEST_ASSERT_TRUE(usart_is_muted(USART_PERIPH_6));
+}
+
+void Test_USARTSetMuteMode_AddressIsInvalid_RegistersShouldNotSet(void) {
+  usart_set_mute_mode(USART_PERIPH_6, USART_WAKEUP_ADDR, 0x10U);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, REGS(USART6_BASE).CR2);
+  TEST_ASSERT_EQUAL_HEX32(0x00000000UL, REGS(USART6_BASE).CR1);
+}
+
+void Test_USARTTxAddress_EdgeCase_ShouldSetAddressMark(void) {
+  REGS(USART2_BASE).SR = 0x00000080UL;
+  REGS(USART2_BASE).CR1 = 0x00001000UL; // 9 databits
+  usart_tx_address(USART_PERIPH_2, 0x05U);
+  TEST_ASSERT_EQUAL_HEX32(0x00000105UL, REGS(USART2_BASE).DR);
+
+  REGS(USART2_BASE).CR1 = 0x00000000UL;
+  usart_tx_address(USART_PERIPH_2, 0x0FU);
+  TEST_ASSERT_EQUAL_HEX32(0x0000008FUL, REGS(USART2_BASE).DR);
+}
+
+void Test_USARTRead_EdgeCase_ShouldReportErrors(void) {
+  uint8_t buf[3] = {0};
+  struct USARTErrors errors = {0};
+  REGS(USART3_BASE).SR = 0x0000002AUL; // RXNE, ORE, FE
+  REGS(USART3_BASE).DR = 0x00000141UL;
+  TEST_ASSERT_EQUAL_UINT32(3U, usart_read(USART_PERIPH_3, buf, sizeof(buf),
+                                          10U, &errors));
+  TEST_ASSERT_EQUAL_HEX8(0x41U, buf[2]);
+  TEST_ASSERT_TRUE(errors.Overrun);
+  TEST_ASSERT_TRUE(errors.Framing);
+  TEST_ASSERT_FALSE(errors.Noise);
+  TEST_ASSERT_FALSE(errors.Parity);
+}
+
+void Test_USARTRead_LineIsSilent_ShouldTimeOut(void) {
+  uint8_t buf[3] = {0};
+  struct USARTErrors errors = {.Overrun = TRUE};
+  ticks = 0xFFFFFFFFUL;
+  TEST_ASSERT_EQUAL_UINT32(0U, usart_read(USART_PERIPH_3, buf, sizeof(buf),
+                                          0U, &errors));
+  TEST_ASSERT_FALSE(errors.Overrun);
+}
+
+void setUp() {
+  for (uint8_t i = 0U; i < (6U + 1U); i++) { test_regs[i] = empty_regs; }
+  test_gpio_regs = (struct GPIORegs){0};
+  memset(test_dma_regs, 0, sizeof(test_dma_regs));
+  test_done_count = 0U;
+  test_errors = 0U;
+  test_frame_count = 0U;
+  test_flags = 0UL;
+}
+
+void tearDown() {}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  /* usart_calc_baud() */
+  RUN_TEST(Test_USARTCalcBaud_APB1_ShouldUseAPB1Clock);
+  RUN_TEST(Test_USARTCalcBaud_APB2_ShouldUseAPB2Clock);
+  RUN_TEST(Test_USARTCalcBaud_EdgeCase_ShouldSelectOver8);
+  RUN_TEST(Test_USARTCalcBaud_RateIsUnreachable_ShouldReturnZero);
+  RUN_TEST(Test_USARTCalcBaud_RateIsZero_ShouldReturnZero);
+  /* usart_start() */
+  RUN_TEST(Test_USARTStart_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_USARTStart_RateIsUnreachable_RegistersShouldNotSet);
+  RUN_TEST(Test_USARTStart_USARTIsInvalid_RegistersShouldNotSet);
+  /* usart_write() */
+  RUN_TEST(Test_USARTWrite_EdgeCase_ShouldSendZeroBytes);
+  RUN_TEST(Test_USARTWrite_LengthIsZero_RegisterShouldNotSet);
+  RUN_TEST(Test_USARTWrite_USARTIsInvalid_RegisterShouldNotSet);
+  /* usart_set_flow_control() */
+  RUN_TEST(Test_USARTSetFlowControl_EdgeCase_RegisterShouldSetProperly);
+  RUN_TEST(Test_USARTSetFlowControl_USARTIsUART_RegisterShouldNotSet);
+  /* usart_tx_dma() */
+  RUN_TEST(Test_USARTTxDMA_EdgeCase_QueueShouldChainOnTC);
+  RUN_TEST(Test_USARTTxDMA_QueueIsFull_ShouldFailAndWrap);
+  RUN_TEST(Test_USARTTxDMA_TransferError_ShouldReportAndContinue);
+  RUN_TEST(Test_USARTTxDMA_BufferIsNull_ShouldFail);
+  /* usart_rx_dma_start() */
+  RUN_TEST(Test_USARTRxDMA_EdgeCase_FramesShouldBeRingViews);
+  /* usart_set_callback() */
+  RUN_TEST(Test_USARTSetCallback_EdgeCase_ShouldGetEnabledFlags);
+  RUN_TEST(Test_USARTSetCallback_CallbackIsMissing_SourcesShouldMute);
+  /* usart_rx_dma_set_rts() */
+  RUN_TEST(Test_USARTRxDMASetRTS_EdgeCase_PinShouldFollowWatermarks);
+  RUN_TEST(Test_USARTRxDMASetRTS_RemoteKeepsSending_ShouldCountDropped);
+  RUN_TEST(Test_USARTRxDMASetRTS_HighIsAboveHalfRing_ShouldFail);
+  RUN_TEST(Test_USARTRxDMASetRTS_RingIsNotStarted_ShouldFail);
+  /* usart_set_mute_mode() */
+  RUN_TEST(Test_USARTSetMuteMode_EdgeCase_RegistersShouldSetProperly);
+  RUN_TEST(Test_USARTSetMuteMode_AddressIsInvalid_RegistersShouldNotSet);
+  /* usart_tx_address() */
+  RUN_TEST(Test_USARTTxAddress_EdgeCase_ShouldSetAddressMark);
+  /* usart_read() */
+  RUN_TEST(Test_USARTRead_EdgeCase_ShouldReportErrors);
+  RUN_TEST(Test_USARTRead_LineIsSilent_ShouldTimeOut);
+
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Decodes TLOG records back into text.
+
+The format strings are read from the .tlog section of the
+firmware ELF, the records from a capture file or a serial
+port (needs pyserial).
+
+Usage:
+    tlog_decode.py firmware.elf capture.bin
+    tlog_decode.py firmware.elf /dev/ttyUSB0 --baud 921600
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+TLOG_SYNC = 0xA
+TLOG_ID_MASK = 0x00FFFFFF
+
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diouxXcfFeEgGp%])")
+
+
+def read_tlog_section(path):
+    """Returns (address, bytes) of the .tlog section of an ELF32 file."""
+    with open(path, "rb") as elf:
+        data = elf.read()
+
+    if data[:4] != b"\x7fELF" or data[4] != 1:
+        raise ValueError("not an ELF32 file")
+    endian = "<" if data[5] == 1 else ">"
+
+    (shoff,) = struct.unpack_from(endian + "I", data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x2E)
+
+    def section(index):
+        return struct.unpack_from(endian + "IIIIIIIIII", data, shoff + index * shentsize)
+
+    strtab = section(shstrndx)
+    for index in range(shnum):
+        name, _, _, addr, offset, size, _, _, _, _ = section(index)
+        start = strtab[4] + name
+        if data[start:data.index(b"\0", start)] == b".tlog":
+            return addr, data[offset:offset + size]
+
+    raise ValueError("no .tlog section, was the firmware built with TLOG?")
+
+
+def format_record(fmt, args):
+    """Applies the 32-bit argument words to a C format string."""
+    words = iter(args)
+
+    def convert(match):
+        flags, kind = match.group(1), match.group(2)
+        if kind == "%":
+            return "%"
+        word = next(words, 0)
+        if kind in "di":
+            value = word - (1 << 32) if word & 0x80000000 else word
+            return ("%" + flags + "d") % value
+        if kind in "fFeEgG":
+            (value,) = struct.unpack("<f", struct.pack("<I", word))
+            return ("%" + flags + kind) % value
+        if kind == "p":
+            return "0x%08x" % word
+        if kind == "c":
+            return chr(word & 0xFF)
+        return ("%" + flags + ("d" if kind == "u" else kind)) % word
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(read, base, strings):
+    """Yields decoded lines, resyncing on the header marker."""
+    buffer = b""
+    while True:
+        chunk = read()
+        if not chunk:
+            return
+        buffer += chunk
+
+        while len(buffer) >= 4:
+            (header,) = struct.unpack_from("<I", buffer)
+            nargs = (header >> 24) & 0xF
+            offset = (header & TLOG_ID_MASK) - base
+            if (header >> 28) != TLOG_SYNC or nargs > 8 or not 0 <= offset < len(strings):
+                buffer = buffer[1:]
+                continue
+            if len(buffer) < 4 * (nargs + 1):
+                break
+
+            args = struct.unpack_from("<%dI" % nargs, buffer, 4)
+            end = strings.find(b"\0", offset)
+            fmt = strings[offset:end].decode("utf-8", "replace")
+            buffer = buffer[4 * (nargs + 1):]
+            yield format_record(fmt, args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF with the .tlog section")
+    parser.add_argument("source", help="capture file or serial port")
+    parser.add_argument("--baud", type=int, default=115200, help="serial baudrate")
+    options = parser.parse_args()
+
+    base, strings = read_tlog_section(options.elf)
+
+    if options.source.startswith("/dev/") or options.source.upper().startswith("COM"):
+        import serial  # pylint: disable=import-outside-toplevel
+
+        stream = serial.Serial(options.source, options.baud, timeout=None)
+        read = lambda: stream.read(max(1, stream.in_waiting))
+    else:
+        stream = open(options.source, "rb")  # pylint: disable=consider-using-with
+        read = lambda: stream.read(256)
+
+    with stream:
+        for line in decode(read, base, strings):
+            sys.stdout.write(line)
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()